@@ -123,6 +123,8 @@ void AudioInputCore::get_devices (std::vector <AudioInputDevice> & devices)
   yield = true;
   PWaitAndSignal m(core_mutex);
 
+  PTime start;
+
   devices.clear();
 
   for (std::set<AudioInputManager *>::iterator iter = managers.begin ();
@@ -130,6 +132,9 @@ void AudioInputCore::get_devices (std::vector <AudioInputDevice> & devices)
        iter++)
     (*iter)->get_devices (devices);
 
+  PTRACE(4, "AudioInputCore\tListed " << devices.size () << " devices in "
+         << (PTime () - start).GetMilliSeconds () << " ms");
+
 #if PTRACING
   for (std::vector<AudioInputDevice>::iterator iter = devices.begin ();
        iter != devices.end ();
@@ -140,6 +145,18 @@ void AudioInputCore::get_devices (std::vector <AudioInputDevice> & devices)
 
 }
 
+void AudioInputCore::refresh_devices ()
+{
+  PTRACE(4, "AudioInputCore\tRefreshing devices");
+  yield = true;
+  PWaitAndSignal m(core_mutex);
+
+  for (std::set<AudioInputManager *>::iterator iter = managers.begin ();
+       iter != managers.end ();
+       iter++)
+    (*iter)->refresh_devices ();
+}
+
 void
 AudioInputCore::set_device (const std::string& device_string)
 {
@@ -186,6 +203,13 @@ void AudioInputCore::add_device (const std::string & source, const std::string &
   PWaitAndSignal m(core_mutex);
 
   AudioInputDevice device;
+
+  /* the managers only know about the new device once they probed again */
+  for (std::set<AudioInputManager *>::iterator iter = managers.begin ();
+       iter != managers.end ();
+       iter++)
+    (*iter)->refresh_devices ();
+
   for (std::set<AudioInputManager *>::iterator iter = managers.begin ();
        iter != managers.end ();
        iter++) {
@@ -234,6 +258,12 @@ void AudioInputCore::remove_device (const std::string & source, const std::strin
        device_removed (device,  current_device == device);
      }
   }
+
+  /* the managers had to know about the device to tell whether it was theirs */
+  for (std::set<AudioInputManager *>::iterator iter = managers.begin ();
+       iter != managers.end ();
+       iter++)
+    (*iter)->refresh_devices ();
 }
 
 void AudioInputCore::start_preview (unsigned channels, unsigned samplerate, unsigned bits_per_sample)
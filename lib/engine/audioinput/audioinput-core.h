@@ -145,6 +145,12 @@ namespace Ekiga
        */
       void get_devices(std::vector <AudioInputDevice> & devices);
 
+      /** Make all managers registered to the core probe their devices again.
+       * The devices are otherwise only probed when the core learns that one
+       * was added or removed, so that get_devices() doesn't cost a probe.
+       */
+      void refresh_devices ();
+
       /** Set a specific device
        * This functions sets the current audio input device.
        * It can also be used while in a stream or in preview mode,
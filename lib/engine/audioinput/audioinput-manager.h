@@ -80,6 +80,14 @@ namespace Ekiga
        */
       virtual void get_devices (std::vector <AudioInputDevice> & devices) = 0;
 
+      /** Forget the devices found so far.
+       * Managers which keep the devices they found between calls to get_devices()
+       * have to probe them again the next time.
+       * This function is called by the core when a device was added or removed,
+       * or when a rescan was requested.
+       */
+      virtual void refresh_devices () {};
+
       /** Set the current device.
        * Must be called before opening the device.
        * In case a different device of the same manager was opened before, it must be 
@@ -42,8 +42,37 @@
 #include "audiooutput-core.h"
 #include "audiooutput-manager.h"
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/* Never keep more than this many seconds of sound events to mix */
+#define EVENT_MIX_MAX_SECONDS 10
+
 using namespace Ekiga;
 
+/* Adds the sound events to the frame, saturating instead of wrapping */
+static void
+mix_samples (short* frame,
+             const short* events,
+             unsigned long count)
+{
+  unsigned long i = 0;
+
+#ifdef __SSE2__
+  for ( ; i + 8 <= count ; i += 8) {
+    __m128i a = _mm_loadu_si128 ((const __m128i*) (frame + i));
+    __m128i b = _mm_loadu_si128 ((const __m128i*) (events + i));
+    _mm_storeu_si128 ((__m128i*) (frame + i), _mm_adds_epi16 (a, b));
+  }
+#endif
+
+  for ( ; i < count ; i++) {
+    int sample = frame[i] + events[i];
+    frame[i] = (short) std::max (-32768, std::min (32767, sample));
+  }
+}
+
 AudioOutputCore::AudioOutputCore (Ekiga::ServiceCore& core)
 {
   PWaitAndSignal m_pri(core_mutex[primary]);
@@ -59,6 +88,14 @@ AudioOutputCore::AudioOutputCore (Ekiga::ServiceCore& core)
   current_primary_config.buffer_size = 0;
   current_primary_config.num_buffers = 0;
 
+  for (unsigned ps = primary ; ps <= secondary ; ps++) {
+    event_device_config[ps].open = false;
+    event_device_config[ps].channels = 0;
+    event_device_config[ps].samplerate = 0;
+    event_device_config[ps].bits_per_sample = 0;
+  }
+  event_mix_pos = 0;
+
   current_primary_volume = 0;
   desired_primary_volume = 0;
 
@@ -151,6 +188,8 @@ void AudioOutputCore::get_devices (std::vector <AudioOutputDevice> & devices)
   PWaitAndSignal m_pri(core_mutex[primary]);
   PWaitAndSignal m_sec(core_mutex[secondary]);
 
+  PTime start;
+
   devices.clear();
 
   for (std::set<AudioOutputManager *>::iterator iter = managers.begin ();
@@ -158,6 +197,9 @@ void AudioOutputCore::get_devices (std::vector <AudioOutputDevice> & devices)
        iter++)
     (*iter)->get_devices (devices);
 
+  PTRACE(4, "AudioOutputCore\tListed " << devices.size () << " devices in "
+         << (PTime () - start).GetMilliSeconds () << " ms");
+
 #if PTRACING
   for (std::vector<AudioOutputDevice>::iterator iter = devices.begin ();
        iter != devices.end ();
@@ -168,6 +210,19 @@ void AudioOutputCore::get_devices (std::vector <AudioOutputDevice> & devices)
 
 }
 
+void AudioOutputCore::refresh_devices ()
+{
+  PTRACE(4, "AudioOutputCore\tRefreshing devices");
+  yield = true;
+  PWaitAndSignal m_pri(core_mutex[primary]);
+  PWaitAndSignal m_sec(core_mutex[secondary]);
+
+  for (std::set<AudioOutputManager *>::iterator iter = managers.begin ();
+       iter != managers.end ();
+       iter++)
+    (*iter)->refresh_devices ();
+}
+
 void AudioOutputCore::set_device(AudioOutputPS ps, const AudioOutputDevice & device)
 {
   PTRACE(4, "AudioOutputCore\tSetting device[" << ps << "]: " << device);
@@ -184,6 +239,7 @@ void AudioOutputCore::set_device(AudioOutputPS ps, const AudioOutputDevice & dev
 
       break;
     case secondary:
+        internal_close_event_device (secondary);
         if (device == current_device[primary])
         {
           current_manager[secondary] = NULL;
@@ -207,6 +263,13 @@ void AudioOutputCore::add_device (const std::string & sink, const std::string &
   PWaitAndSignal m_pri(core_mutex[primary]);
 
   AudioOutputDevice device;
+
+  /* the managers only know about the new device once they probed again */
+  for (std::set<AudioOutputManager *>::iterator iter = managers.begin ();
+       iter != managers.end ();
+       iter++)
+    (*iter)->refresh_devices ();
+
   for (std::set<AudioOutputManager *>::iterator iter = managers.begin ();
        iter != managers.end ();
        iter++) {
@@ -254,6 +317,12 @@ void AudioOutputCore::remove_device (const std::string & sink, const std::string
        device_removed(device, device == current_device[primary]);
      }
   }
+
+  /* the managers had to know about the device to tell whether it was theirs */
+  for (std::set<AudioOutputManager *>::iterator iter = managers.begin ();
+       iter != managers.end ();
+       iter++)
+    (*iter)->refresh_devices ();
 }
 
 void AudioOutputCore::start (unsigned channels, unsigned samplerate, unsigned bits_per_sample)
@@ -266,9 +335,12 @@ void AudioOutputCore::start (unsigned channels, unsigned samplerate, unsigned bi
     return;
   }
 
+  internal_close_event_device(primary);
   internal_set_manager(primary, desired_primary_device);    /* may be left undetermined after the last call */
 
   average_level = 0;
+  event_mix.clear ();
+  event_mix_pos = 0;
   internal_open(primary, channels, samplerate, bits_per_sample);
   current_primary_config.active = true;
   current_primary_config.channels = channels;
@@ -284,6 +356,8 @@ void AudioOutputCore::stop()
   PWaitAndSignal m_pri(core_mutex[primary]);
 
   average_level = 0;
+  event_mix.clear ();
+  event_mix_pos = 0;
   internal_close(primary);
   internal_set_manager(primary, desired_primary_device);
 
@@ -311,6 +385,23 @@ void AudioOutputCore::set_frame_data (const char *data,
   }
   PWaitAndSignal m_pri(core_mutex[primary]);
 
+  /* Mix the pending sound events into a copy of the frame */
+  if (event_mix_pos < event_mix.size () && size >= sizeof (short)) {
+
+    unsigned long count = std::min ((unsigned long) (size / sizeof (short)),
+                                    (unsigned long) (event_mix.size () - event_mix_pos));
+
+    mix_buffer.assign (data, data + size);
+    mix_samples ((short*) &mix_buffer[0], &event_mix[event_mix_pos], count);
+    data = &mix_buffer[0];
+
+    event_mix_pos += count;
+    if (event_mix_pos == event_mix.size ()) {
+      event_mix.clear ();
+      event_mix_pos = 0;
+    }
+  }
+
   if (current_manager[primary]) {
     if (!current_manager[primary]->set_frame_data(primary, data, size, bytes_written)) {
       internal_close(primary);
@@ -353,7 +444,7 @@ void AudioOutputCore::play_buffer(AudioOutputPS ps, const char* buffer, unsigned
       }
 
       if (current_primary_config.active) {
-        PTRACE(1, "AudioOutputCore\tDropping sound event, primary device not set");
+        internal_queue_event_mix(buffer, len, channels, sample_rate, bps);
         core_mutex[primary].Signal();
         return;
       }
@@ -379,6 +470,17 @@ void AudioOutputCore::play_buffer(AudioOutputPS ps, const char* buffer, unsigned
   }
 }
 
+void AudioOutputCore::close_event_devices ()
+{
+  core_mutex[primary].Wait();
+  internal_close_event_device(primary);
+  core_mutex[primary].Signal();
+
+  core_mutex[secondary].Wait();
+  internal_close_event_device(secondary);
+  core_mutex[secondary].Signal();
+}
+
 void AudioOutputCore::on_set_device (const AudioOutputDevice & device)
 {
   gm_conf_set_string (AUDIO_DEVICES_KEY "output_device", device.GetString ().c_str ());
@@ -404,6 +506,8 @@ void AudioOutputCore::on_device_error (AudioOutputPS ps, AudioOutputDevice devic
 
 void AudioOutputCore::internal_set_primary_device(const AudioOutputDevice & device)
 {
+  internal_close_event_device(primary);
+
   if (current_primary_config.active)
      internal_close(primary);
 
@@ -499,20 +603,120 @@ void AudioOutputCore::internal_play(AudioOutputPS ps, const char* buffer, unsign
   unsigned long pos = 0;
   unsigned bytes_written = 0;
   unsigned buffer_size = (unsigned)((float)sample_rate/25);
+  EventDeviceConfig & config = event_device_config[ps];
 
-  if (!internal_open ( ps, channels, sample_rate, bps))
-    return;
+  /* Reuse the device if it is still open with the right format */
+  if (config.open
+      && (config.channels != channels
+          || config.samplerate != sample_rate
+          || config.bits_per_sample != bps))
+    internal_close_event_device (ps);
+
+  if (!config.open) {
+
+    if (!internal_open ( ps, channels, sample_rate, bps))
+      return;
+
+    config.open = true;
+    config.channels = channels;
+    config.samplerate = sample_rate;
+    config.bits_per_sample = bps;
+
+    if (current_manager[ps])
+      current_manager[ps]->set_buffer_size (ps, buffer_size, 4);
+  }
 
   if (current_manager[ps]) {
-    current_manager[ps]->set_buffer_size (ps, buffer_size, 4);
     do {
-      if (!current_manager[ps]->set_frame_data(ps, buffer+pos, std::min(buffer_size, (unsigned) (len - pos)), bytes_written))
+      if (!current_manager[ps]->set_frame_data(ps, buffer+pos, std::min(buffer_size, (unsigned) (len - pos)), bytes_written)) {
+        internal_close_event_device (ps);
         break;
+      }
       pos += buffer_size;
     } while (pos < len);
   }
+}
+
+void AudioOutputCore::internal_close_event_device(AudioOutputPS ps)
+{
+  if (!event_device_config[ps].open)
+    return;
+
+  internal_close (ps);
+  event_device_config[ps].open = false;
+}
+
+void AudioOutputCore::internal_queue_event_mix(const char* buffer, unsigned long len, unsigned channels, unsigned sample_rate, unsigned bps)
+{
+  unsigned out_channels = current_primary_config.channels;
+  unsigned out_rate = current_primary_config.samplerate;
+
+  if (bps != 16 || current_primary_config.bits_per_sample != 16
+      || channels == 0 || sample_rate == 0 || out_channels == 0 || out_rate == 0) {
+    PTRACE(1, "AudioOutputCore\tDropping sound event, unable to mix " << bps << " bits into " << current_primary_config.bits_per_sample << " bits");
+    return;
+  }
 
-  internal_close( ps);
+  const short* in = (const short*) buffer;
+  unsigned long in_frames = len / (sizeof (short) * channels);
+  unsigned long out_frames = (unsigned long) ((guint64) in_frames * out_rate / sample_rate);
+  unsigned long max_frames = (unsigned long) out_rate * EVENT_MIX_MAX_SECONDS;
+
+  if (in_frames == 0)
+    return;
+
+  /* Forget what was already mixed, and keep the queue bounded */
+  event_mix.erase (event_mix.begin (), event_mix.begin () + event_mix_pos);
+  event_mix_pos = 0;
+
+  if (event_mix.size () / out_channels + out_frames > max_frames) {
+    PTRACE(1, "AudioOutputCore\tTruncating sound event, too many events to mix");
+    out_frames = max_frames - std::min (max_frames, (unsigned long) (event_mix.size () / out_channels));
+  }
+
+  /* A new sound starts now : it is mixed with the end of the previous ones */
+  if (event_mix.size () < out_frames * out_channels)
+    event_mix.resize (out_frames * out_channels, 0);
+
+  /* Linear interpolation, in 16.16 fixed point */
+  guint64 step = ((guint64) sample_rate << 16) / out_rate;
+
+  for (unsigned long i = 0 ; i < out_frames ; i++) {
+
+    guint64 pos = i * step;
+    unsigned long index = (unsigned long) (pos >> 16);
+    int frac = (int) (pos & 0xffff);
+    unsigned long next = std::min (index + 1, in_frames - 1);
+
+    if (index >= in_frames)
+      break;
+
+    for (unsigned c = 0 ; c < out_channels ; c++) {
+
+      int a = 0;
+      int b = 0;
+
+      if (channels < out_channels) {  /* mono to stereo */
+        a = in[index * channels];
+        b = in[next * channels];
+      }
+      else if (channels > out_channels) {  /* stereo to mono */
+        for (unsigned k = 0 ; k < channels ; k++) {
+          a += in[index * channels + k];
+          b += in[next * channels + k];
+        }
+        a /= (int) channels;
+        b /= (int) channels;
+      }
+      else {
+        a = in[index * channels + c];
+        b = in[next * channels + c];
+      }
+
+      int sample = event_mix[i * out_channels + c] + a + (int) (((gint64) (b - a) * frac) >> 16);
+      event_mix[i * out_channels + c] = (short) std::max (-32768, std::min (32767, sample));
+    }
+  }
 }
 
 void AudioOutputCore::calculate_average_level (const short *buffer, unsigned size)
@@ -135,6 +135,12 @@ namespace Ekiga
        */
       void get_devices(std::vector <AudioOutputDevice> & devices);
 
+      /** Make all managers registered to the core probe their devices again.
+       * The devices are otherwise only probed when the core learns that one
+       * was added or removed, so that get_devices() doesn't cost a probe.
+       */
+      void refresh_devices ();
+
       /** Set a specific device
        * This function sets the current primary or secondary audio output device. This function can
        * also be used while in a stream or in preview mode. In that case the old
@@ -229,6 +235,8 @@ namespace Ekiga
 
       /** Play a sound event buffer
        * This function is called by the Scheduler in order to play an already loaded sound.
+       * If the primary device is used by a call, the sound is converted to the
+       * format of the call and mixed into it by set_frame_data().
        * @param ps whether to play the sound on the primary or secondary device.
        * @param buffer pointer to the sound in raw format.
        * @param len the length in bytes of the sound.
@@ -238,6 +246,13 @@ namespace Ekiga
        */
       void play_buffer(AudioOutputPS ps, const char* buffer, unsigned long len, unsigned channels, unsigned sample_rate, unsigned bps);
 
+      /** Close the devices kept open for sound events
+       * play_buffer() leaves the device open, so that the repetitions of an
+       * event do not reopen it each time. This function is called by the
+       * Scheduler once there is nothing left to play.
+       */
+      void close_event_devices ();
+
 
       /*** Stream Management ***/
 
@@ -333,6 +348,8 @@ namespace Ekiga
       void internal_close(AudioOutputPS ps);
 
       void internal_play(AudioOutputPS ps, const char* buffer, unsigned long len, unsigned channels, unsigned sample_rate, unsigned bps);
+      void internal_close_event_device(AudioOutputPS ps);
+      void internal_queue_event_mix(const char* buffer, unsigned long len, unsigned channels, unsigned sample_rate, unsigned bps);
 
       void calculate_average_level (const short *buffer, unsigned size);
 
@@ -349,6 +366,24 @@ namespace Ekiga
 
       DeviceConfig current_primary_config;
 
+      typedef struct EventDeviceConfig {
+        bool open;
+        unsigned channels;
+        unsigned samplerate;
+        unsigned bits_per_sample;
+      } EventDeviceConfig;
+
+      /* The format the devices were opened with to play sound events,
+       * protected by the core_mutex of the device */
+      EventDeviceConfig event_device_config[2];
+
+      /* The sound events waiting to be mixed into the call, in the format
+       * of the primary device, and a buffer to mix them with a frame ;
+       * protected by core_mutex[primary] */
+      std::vector<short> event_mix;
+      unsigned long event_mix_pos;
+      std::vector<char> mix_buffer;
+
       AudioOutputManager* current_manager[2];
       AudioOutputDevice desired_primary_device;
       AudioOutputDevice current_device[2];
@@ -34,6 +34,9 @@
  *
  */
 
+#include <string.h>
+#include <algorithm>
+
 #include "audiooutput-scheduler.h"
 #include "audiooutput-core.h"
 #include "config.h"
@@ -43,8 +46,127 @@
 
 using namespace Ekiga;
 
-AudioEventScheduler::AudioEventScheduler (AudioOutputCore& _audio_output_core)
+AudioEventQueue::AudioEventQueue (Clock _clock)
+: clock (_clock)
+{
+  next_event_id = 0;
+}
+
+PInt64 AudioEventQueue::monotonic_clock ()
+{
+  return PTimer::Tick().GetMilliSeconds();
+}
+
+void AudioEventQueue::add (const std::string & name, bool is_file_name, unsigned interval, unsigned repetitions)
+{
+  PWaitAndSignal m(mutex);
+  AudioEvent event;
+  AudioEventTimer timer;
+  event.name = name;
+  event.is_file_name = is_file_name;
+  event.interval = interval;
+  event.repetitions = repetitions;
+  event.time = clock ();
+
+  timer.time = event.time;
+  timer.id = next_event_id++;
+
+  event_list[timer.id] = event;
+  event_ids.insert (std::pair<std::string, unsigned> (name, timer.id));
+  event_timers.push (timer);
+}
+
+void AudioEventQueue::remove (const std::string & name)
+{
+  PWaitAndSignal m(mutex);
+
+  std::multimap<std::string, unsigned>::iterator id = event_ids.find (name);
+
+  /* its timer stays in the heap, and is dropped when it surfaces */
+  if (id != event_ids.end ())
+    remove_event (event_list.find (id->second));
+}
+
+void AudioEventQueue::get_pending (std::vector<AudioEvent> & pending_event_list)
+{
+  PWaitAndSignal m(mutex);
+
+  PInt64 time = clock ();
+
+  pending_event_list.clear();
+
+  while (!event_timers.empty () && event_timers.top ().time <= time) {
+
+    AudioEventTimer timer = event_timers.top ();
+    event_timers.pop ();
+
+    std::map<unsigned, AudioEvent>::iterator iter = event_list.find (timer.id);
+    if (iter == event_list.end ())
+      continue; // removed since it was scheduled
+
+    AudioEvent & event = iter->second;
+    pending_event_list.push_back(event);
+
+    if (event.interval > 0 && event.repetitions > 1) {
+      event.repetitions--;
+      event.time = time + event.interval;
+      timer.time = event.time;
+      event_timers.push (timer);
+    }
+    else
+      remove_event (iter);
+  }
+}
+
+unsigned AudioEventQueue::get_time_to_next ()
+{
+  PWaitAndSignal m(mutex);
+
+  /* drop the entries of removed events, so that they do not
+   * wake us up for nothing */
+  while (!event_timers.empty () && event_list.find (event_timers.top ().id) == event_list.end ())
+    event_timers.pop ();
+
+  if (event_timers.empty ())
+    return 65535;
+
+  PInt64 delay = event_timers.top ().time - clock ();
+  if (delay <= 0)
+    return 0;
+
+  return (unsigned) std::min (delay, (PInt64) 65534);
+}
+
+unsigned AudioEventQueue::size ()
+{
+  PWaitAndSignal m(mutex);
+
+  return event_list.size ();
+}
+
+void AudioEventQueue::remove_event (std::map<unsigned, AudioEvent>::iterator iter)
+{
+  std::pair<std::multimap<std::string, unsigned>::iterator,
+            std::multimap<std::string, unsigned>::iterator> range = event_ids.equal_range (iter->second.name);
+
+  for (std::multimap<std::string, unsigned>::iterator id = range.first;
+       id != range.second;
+       id++) {
+
+    if (id->second == iter->first) {
+      event_ids.erase (id);
+      break;
+    }
+  }
+
+  event_list.erase (iter);
+}
+
+
+AudioEventScheduler::AudioEventScheduler (AudioOutputCore& _audio_output_core,
+                                          AudioEventQueue::Clock clock)
 : PThread (1000, AutoDeleteThread, HighestPriority, "AudioEventScheduler"),
+  event_queue (clock),
   audio_output_core (_audio_output_core)
 {
   end_thread = false;
@@ -70,9 +192,7 @@ void AudioEventScheduler::Main ()
   std::vector <AudioEvent> pending_event_list;
   unsigned idle_time = 65535;
   AudioEvent event;
-  char* buffer = NULL;
-  unsigned long buffer_len = 0;
-  unsigned channels, sample_rate, bps;
+  AudioSoundPtr sound;
   AudioOutputPS ps;
 
   thread_created.Signal ();
@@ -87,136 +207,85 @@ void AudioEventScheduler::Main ()
     if (end_thread)
       break;
       
-    get_pending_event_list(pending_event_list);
+    event_queue.get_pending (pending_event_list);
     PTRACE(4, "AEScheduler\tChecking pending list with " << pending_event_list.size() << " elements");
 
     while (pending_event_list.size() > 0) {
       event = *(pending_event_list.begin()); pending_event_list.erase(pending_event_list.begin());
-      load_wav(event.name, event.is_file_name, buffer, buffer_len, channels, sample_rate, bps, ps);
-      if (buffer) {
-         audio_output_core.play_buffer (ps, buffer, buffer_len, channels, sample_rate, bps);
-        free (buffer);
-        buffer = NULL;
-      }
+      sound = get_sound(event.name, event.is_file_name, ps);
+      if (sound && !sound->data.empty ())
+        audio_output_core.play_buffer (ps, &sound->data[0], sound->data.size (), sound->channels, sound->sample_rate, sound->bps);
+      sound.reset ();
       Current()->Sleep (10);
     }
-    idle_time = get_time_to_next_event();
-  }
-}
-
-void AudioEventScheduler::get_pending_event_list (std::vector<AudioEvent> & pending_event_list)
-{
-  PWaitAndSignal m(event_list_mutex);
-
-  AudioEvent event;
-  std::vector <AudioEvent> new_event_list;
-  unsigned long time = get_time_ms();
-
-  pending_event_list.clear();
+    idle_time = event_queue.get_time_to_next ();
 
-  while (event_list.size() > 0) {
-
-    event = *(event_list.begin()); event_list.erase(event_list.begin());
-
-    if (event.interval == 0) {
-      pending_event_list.push_back(event);
-    }
-    else {
-      if (event.time <= time) {
-        pending_event_list.push_back(event);
-        event.repetitions--; 
-        if (event.repetitions > 0) {
-          event.time = time + event.interval;
-          new_event_list.push_back(event);
-        }
-      }
-      else {
-        new_event_list.push_back(event);
-      }
-    }
-  }
-
-  event_list = new_event_list;
-}
-
-unsigned long AudioEventScheduler::get_time_ms()
-{
-  GTimeVal time_val;
-  g_get_current_time(&time_val);
-  return (time_val.tv_sec * 1000 + (unsigned long) (time_val.tv_usec / 1000) );
-}
-
-unsigned AudioEventScheduler::get_time_to_next_event()
-{
-  PWaitAndSignal m(event_list_mutex);
-  unsigned long time = get_time_ms();
-  unsigned min_time = 65535;
-
-  for (std::vector<AudioEvent>::iterator iter = event_list.begin ();
-       iter !=event_list.end ();
-       iter++) {
-
-    if ( (iter->interval > 0) && ((iter->time - time) < min_time) )
-      min_time = iter->time - time;
+    /* The devices stay open between the repetitions of an event,
+     * and are closed once nothing is left to play */
+    if (idle_time == 65535)
+      audio_output_core.close_event_devices ();
   }
-  return min_time;
 }
 
 void AudioEventScheduler::add_event_to_queue(const std::string & name, bool is_file_name, unsigned interval, unsigned repetitions)
 {
   PTRACE(4, "AEScheduler\tAdding Event " << name << " " << interval << "/" << repetitions << " to queue");
-  PWaitAndSignal m(event_list_mutex);
-  AudioEvent event;
-  event.name = name;
-  event.is_file_name = is_file_name;
-  event.interval = interval;
-  event.repetitions = repetitions;
-  event.time = get_time_ms();
-  event_list.push_back(event);
+  event_queue.add (name, is_file_name, interval, repetitions);
   run_thread.Signal();
 }
 
 void AudioEventScheduler::remove_event_from_queue(const std::string & name)
 {
   PTRACE(4, "AEScheduler\tRemoving Event " << name << " from queue");
-  PWaitAndSignal m(event_list_mutex);
+  event_queue.remove (name);
+}
 
-  bool found = false;
-  std::vector<AudioEvent>::iterator iter;
+AudioSoundPtr AudioEventScheduler::get_sound(const std::string & event_name, bool is_file_name, AudioOutputPS & ps)
+{
+  std::string file_name;
+  std::string key;
+  AudioSoundPtr sound;
 
-  for (iter = event_list.begin ();
-       iter != event_list.end () ;
-       iter++) {
+  /* Files played directly aren't cached : they are mostly previews of
+   * files picked one after the other, which may change on disk */
+  if (is_file_name) {
+    ps = primary;
+    return load_wav(event_name);
+  }
 
-      if ( (iter->name == name) ) { 
-        found = true;
-        break;
-      }
+  if (!get_file_name(event_name, file_name, ps)) // if this event is disabled
+    return sound;
+  key = "event:" + event_name;
+
+  {
+    PWaitAndSignal m(event_file_list_mutex);
+    std::map<std::string, AudioSoundPtr>::iterator iter = sound_cache.find (key);
+    if (iter != sound_cache.end ())
+      return iter->second;
   }
 
-  if (found) {
-    event_list.erase(iter);
+  /* The file is read without holding the lock */
+  sound = load_wav(file_name);
+  if (!sound)
+    return sound;
+
+  /* Only cache it if the event was not remapped in the meantime */
+  std::string current_file_name;
+  AudioOutputPS current_ps;
+  if (get_file_name(event_name, current_file_name, current_ps) && current_file_name == file_name) {
+    PWaitAndSignal m(event_file_list_mutex);
+    sound_cache[key] = sound;
   }
+
+  return sound;
 }
 
-void AudioEventScheduler::load_wav(const std::string & event_name, bool is_file_name, char* & buffer, unsigned long & len, unsigned & channels, unsigned & sample_rate, unsigned & bps, AudioOutputPS & ps)
+AudioSoundPtr AudioEventScheduler::load_wav(const std::string & file_name)
 {
   PWAVFile* wav = NULL;
-  std::string file_name;
+  AudioSoundPtr result;
 
-  len = 0;
-  buffer = NULL;
-
-  // Shall we also try event name as file name?
-  if (is_file_name) {
-    file_name = event_name;
-    ps = primary;
-  }
-  else 
-    if (!get_file_name(event_name, file_name, ps)) // if this event is disabled
-      return;
-
-  PTRACE(4, "AEScheduler\tTrying to load " << file_name << " for event " << event_name);
+  PTRACE(4, "AEScheduler\tTrying to load " << file_name);
   wav = new PWAVFile (file_name.c_str(), PFile::ReadOnly);
 
   if (!wav->IsValid ()) {
@@ -226,24 +295,45 @@ void AudioEventScheduler::load_wav(const std::string & event_name, bool is_file_
     wav = NULL;
  
     gchar* filename = g_build_filename (DATA_DIR, "sounds", PACKAGE_NAME, file_name.c_str(), NULL);
-    PTRACE(4, "AEScheduler\tTrying to load " << filename << " for event " << event_name);
+    PTRACE(4, "AEScheduler\tTrying to load " << filename);
 
     wav = new PWAVFile (filename, PFile::ReadOnly);
     g_free (filename);
   }
   
   if (wav->IsValid ()) {
-    len = wav->GetDataLength();
-    channels = wav->GetChannels ();
-    sample_rate = wav->GetSampleRate ();
-    bps = wav->GetSampleSize ();
-
-    buffer = (char*) malloc (len);
-    memset(buffer, 127, len);
-    wav->Read(buffer, len);
+    AudioSound* sound = new AudioSound;
+    std::vector<char> raw (wav->GetDataLength ());
+
+    sound->channels = wav->GetChannels ();
+    sound->sample_rate = wav->GetSampleRate ();
+    sound->bps = wav->GetSampleSize ();
+
+    if (!raw.empty () && wav->Read (&raw[0], raw.size ()))
+      raw.resize (wav->GetLastReadCount ());
+    else
+      raw.clear ();
+
+    /* 8 bits samples are unsigned : widen them once to signed 16 bits,
+     * which all the devices take */
+    if (sound->bps == 8) {
+      sound->data.resize (raw.size () * 2);
+      for (unsigned i = 0 ; i < raw.size () ; i++) {
+        short sample = ((short) (unsigned char) raw[i] - 128) * 256;
+        memcpy (&sound->data[2 * i], &sample, sizeof (sample));
+      }
+      sound->bps = 16;
+    }
+    else
+      sound->data.swap (raw);
+
+    PTRACE(4, "AEScheduler\tLoaded " << sound->data.size () << " bytes from " << file_name);
+    result = AudioSoundPtr (sound);
   }
 
   delete wav;
+
+  return result;
 }
 
 
@@ -286,6 +376,9 @@ void AudioEventScheduler::set_file_name(const std::string & event_name, const st
     }
   }
 
+  /* It will be loaded again the next time it is played */
+  sound_cache.erase ("event:" + event_name);
+
   if (!found) {
     EventFileName event_file_name;
     event_file_name.event_name = event_name;
@@ -43,6 +43,10 @@
 
 #include <glib.h>
 #include <vector>
+#include <map>
+#include <queue>
+#include <boost/shared_ptr.hpp>
+#include <boost/function.hpp>
 #include <ptlib.h>
 #include <ptclib/pwavfile.h>
 
@@ -55,9 +59,30 @@ namespace Ekiga
     bool is_file_name;
     unsigned interval;
     unsigned repetitions;
-    unsigned long time;
+    PInt64 time;        // when it is due, in ms of the monotonic clock
   } AudioEvent;
 
+  /* An entry of the timer heap : the event it points to may have been
+   * removed since, in which case the entry is dropped when it surfaces */
+  typedef struct AudioEventTimer {
+    PInt64 time;
+    unsigned id;
+
+    bool operator> (const AudioEventTimer & other) const
+    { return time > other.time || (time == other.time && id > other.id); }
+  } AudioEventTimer;
+
+  /* A sound decoded once into 16 bits PCM, shared between the
+   * repetitions of its event */
+  typedef struct AudioSound {
+    std::vector<char> data;
+    unsigned channels;
+    unsigned sample_rate;
+    unsigned bps;
+  } AudioSound;
+
+  typedef boost::shared_ptr<const AudioSound> AudioSoundPtr;
+
   typedef struct EventFileName {
     std::string event_name;
     std::string file_name;
@@ -65,12 +90,58 @@ namespace Ekiga
     AudioOutputPS ps;
   } EventFileName;
 
+  /* The events waiting to be played, with the times they are due at.
+   *
+   * The events are kept by id, with their ids by event name, and a min-heap
+   * of the times they are due at, so that adding, removing and finding the
+   * next due event cost O(log n).
+   *
+   * The times come from the clock given to the constructor, in ms ; the
+   * default one is monotonic. The queue can be used from any thread.
+   */
+  class AudioEventQueue
+  {
+  public:
+    typedef boost::function0<PInt64> Clock;
+
+    AudioEventQueue (Clock _clock = monotonic_clock);
+
+    /* The ms elapsed on the monotonic clock */
+    static PInt64 monotonic_clock ();
+
+    void add (const std::string & name, bool is_file_name, unsigned interval, unsigned repetitions);
+
+    /* Removes the first event added with that name */
+    void remove (const std::string & name);
+
+    /* Fills the list with the events due now, in the order they are due ;
+     * those which have repetitions left are scheduled again */
+    void get_pending (std::vector<AudioEvent> & pending_event_list);
+
+    /* The ms until the next event is due, 65535 if there is none */
+    unsigned get_time_to_next ();
+
+    unsigned size ();
+
+  private:
+    void remove_event (std::map<unsigned, AudioEvent>::iterator iter);
+
+    Clock clock;
+
+    PMutex mutex;
+    std::map<unsigned, AudioEvent> event_list;
+    std::multimap<std::string, unsigned> event_ids;
+    std::priority_queue<AudioEventTimer, std::vector<AudioEventTimer>, std::greater<AudioEventTimer> > event_timers;
+    unsigned next_event_id;
+  };
+
   class AudioEventScheduler : public PThread
   {
     PCLASSINFO(AudioEventScheduler, PThread);
 
   public:
-    AudioEventScheduler(Ekiga::AudioOutputCore& _audio_output_core);
+    AudioEventScheduler(Ekiga::AudioOutputCore& _audio_output_core,
+                        AudioEventQueue::Clock clock = AudioEventQueue::monotonic_clock);
     void quit ();
     void add_event_to_queue(const std::string & name, bool is_file_name, unsigned interval, unsigned repetitions);
     void remove_event_from_queue(const std::string & name);
@@ -78,11 +149,9 @@ namespace Ekiga
   
   protected:
     void Main (void);
-    void get_pending_event_list (std::vector<AudioEvent> & pending_event_list);
-    unsigned long get_time_ms();
-    unsigned get_time_to_next_event();
     bool get_file_name(const std::string & event_name, std::string & file_name, AudioOutputPS & ps);
-    void load_wav(const std::string & event_name, bool is_file_name, char* & buffer, unsigned long & len, unsigned & channels, unsigned & sample_rate, unsigned & bps, AudioOutputPS & ps);
+    AudioSoundPtr get_sound(const std::string & event_name, bool is_file_name, AudioOutputPS & ps);
+    AudioSoundPtr load_wav(const std::string & file_name);
 
     PSyncPoint run_thread;
     bool end_thread;
@@ -90,12 +159,16 @@ namespace Ekiga
     PMutex thread_ended;
     PSyncPoint thread_created;
 
-    PMutex event_list_mutex;
-    std::vector <AudioEvent> event_list;
+    AudioEventQueue event_queue;
 
     PMutex event_file_list_mutex;
     std::vector <EventFileName> event_file_list;
 
+    /* The decoded sounds, by event name ; the cache is
+     * protected by event_file_list_mutex since the mapping decides
+     * what is in it */
+    std::map<std::string, AudioSoundPtr> sound_cache;
+
     Ekiga::AudioOutputCore& audio_output_core;
   };
 };
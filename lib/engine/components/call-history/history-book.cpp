@@ -40,19 +40,14 @@
 #include "gmconf.h"
 
 History::Book::Book (Ekiga::ServiceCore& core):
-  contact_core(core.get<Ekiga::ContactCore>("contact-core")), doc()
+  contact_core(core.get<Ekiga::ContactCore>("contact-core")), doc(),
+  store("call-history.xml", "list", CALL_HISTORY_KEY)
 {
   xmlNodePtr root = NULL;
 
-  gchar *c_raw = gm_conf_get_string (CALL_HISTORY_KEY);
+  doc = store.load ();
 
-  if (c_raw != NULL) {
-
-    const std::string raw = c_raw;
-
-    doc = boost::shared_ptr<xmlDoc> (xmlRecoverMemory (raw.c_str (), raw.length ()), xmlFreeDoc);
-    if ( !doc)
-      doc = boost::shared_ptr<xmlDoc> (xmlNewDoc (BAD_CAST "1.0"), xmlFreeDoc);
+  if (doc) {
 
     root = xmlDocGetRootElement (doc.get ());
     if (root == NULL) {
@@ -68,13 +63,12 @@ History::Book::Book (Ekiga::ServiceCore& core):
 	  && child->name != NULL
 	  && xmlStrEqual (BAD_CAST ("entry"), child->name))
         add (child);
-
-    g_free (c_raw);
   } else {
 
     doc = boost::shared_ptr<xmlDoc> (xmlNewDoc (BAD_CAST "1.0"), xmlFreeDoc);
     root = xmlNewDocNode (doc.get (), NULL, BAD_CAST "list", NULL);
     xmlDocSetRootElement (doc.get (), root);
+    store.reset (doc);
   }
 
   boost::shared_ptr<Ekiga::CallCore> call_core = core.get<Ekiga::CallCore> ("call-core");
@@ -129,7 +123,8 @@ History::Book::add (const std::string & name,
 
     xmlAddChild (root, contact->get_node ());
 
-    save ();
+    // a call only needs appending to the file
+    store.append (contact->get_node ());
 
     common_add (contact);
 
@@ -158,19 +153,6 @@ History::Book::get_status () const
   return ""; // nothing special here
 }
 
-void
-History::Book::save () const
-{
-  xmlChar *buffer = NULL;
-  int size = 0;
-
-  xmlDocDumpMemory (doc.get (), &buffer, &size);
-
-  gm_conf_set_string (CALL_HISTORY_KEY, (const char *)buffer);
-
-  xmlFree (buffer);
-}
-
 void
 History::Book::clear ()
 {
@@ -191,7 +173,7 @@ History::Book::clear ()
   root = xmlNewDocNode (doc.get (), NULL, BAD_CAST "list", NULL);
   xmlDocSetRootElement (doc.get (), root);
 
-  save ();
+  store.reset (doc);
 }
 
 void
@@ -233,7 +215,7 @@ History::Book::common_add (ContactPtr contact)
 void
 History::Book::enforce_size_limit()
 {
-  bool flag = false;
+  unsigned dropped = 0;
 
   while (ordered_contacts.size() > 100) {
 
@@ -243,12 +225,14 @@ History::Book::enforce_size_limit()
     contact->removed();
     xmlUnlinkNode(node);
     xmlFreeNode(node);
-    flag = true;
+    dropped++;
   }
 
-  if (flag) {
+  if (dropped > 0) {
 
-    save();
+    /* the oldest entries are dropped again when loading, so the file
+     * can keep them for a while */
+    store.drop_oldest (dropped);
     updated();
   }
 }
@@ -41,6 +41,7 @@
 
 #include "book-impl.h"
 #include "history-contact.h"
+#include "xml-store.h"
 
 namespace History
 {
@@ -92,8 +93,6 @@ namespace History
 
     void parse_entry (xmlNodePtr entry);
 
-    void save () const;
-
     void add (xmlNodePtr node);
 
     void on_missed_call (boost::shared_ptr<Ekiga::CallManager> manager,
@@ -110,6 +109,7 @@ namespace History
     boost::weak_ptr<Ekiga::ContactCore> contact_core;
     boost::shared_ptr<xmlDoc> doc;
     std::list<ContactPtr> ordered_contacts;
+    Ekiga::XmlStore store;
   };
 
   typedef boost::shared_ptr<Book> BookPtr;
@@ -56,6 +56,10 @@ GMVideoOutputManager::GMVideoOutputManager(Ekiga::ServiceCore & _core)
   : PThread (1000, AutoDeleteThread, HighestPriority, "GMVideoOutputManager"),
     core (_core)
 {
+  devices_nbr = 0;
+  frame_pool = Ekiga::VideoFramePoolPtr (new Ekiga::VideoFramePool);
+  for (unsigned i = 0 ; i < 3 ; i++)
+    skipped_at_init[i] = 0;
 }
 
 GMVideoOutputManager::~GMVideoOutputManager ()
@@ -80,18 +84,18 @@ void GMVideoOutputManager::close ()
 void
 GMVideoOutputManager::Main ()
 {
-  bool do_sync = false;
   bool initialised_thread = false;
-  UpdateRequired sync_required;
+  bool signalled = false;
+  UpdateRequired fresh;
 
   PWaitAndSignal m(thread_ended);
   thread_created.Signal ();
 
   while (!end_thread) {
     if (initialised_thread)
-      run_thread.Wait(250);
+      signalled = run_thread.Wait(250);
     else
-      run_thread.Wait();
+      signalled = run_thread.Wait();
 
     if (init_thread) {
       init();
@@ -101,19 +105,45 @@ GMVideoOutputManager::Main ()
     }
 
     if (initialised_thread) {
-      var_mutex.Wait ();
-        do_sync = local_frame_received | remote_frame_received | ext_frame_received;
-        if (do_sync)
-          sync_required = redraw();
-      var_mutex.Signal ();
-      if (do_sync)
-        sync(sync_required);
+
+      fresh = take_frames ();
+
+      /* The main display is refreshed when one of its streams has a new
+       * frame, the extended display when it has a new frame, and both are
+       * refreshed periodically when nothing new arrives */
+      UpdateRequired displayed;
+      displayed.local = fresh.local && update_frame_info (0);
+      displayed.remote = fresh.remote && update_frame_info (1);
+      displayed.extended = false;
+
+      if (displayed.local || displayed.remote) {
+        update_required.local = fresh.local;
+        update_required.remote = fresh.remote;
+        update_required.extended = false;
+        draw_and_sync (displayed);
+      }
+
+      if (fresh.extended && update_frame_info (2)) {
+        update_required.local = false;
+        update_required.remote = false;
+        update_required.extended = true;
+        displayed.local = false;
+        displayed.remote = false;
+        displayed.extended = true;
+        draw_and_sync (displayed);
+      }
+
+      if (!signalled && !fresh.local && !fresh.remote && !fresh.extended
+          && (local_frame_received || remote_frame_received || ext_frame_received)) {
+        update_required.local = false;
+        update_required.remote = false;
+        update_required.extended = false;
+        sync (redraw ());
+      }
     }
 
     if (uninit_thread) {
-      var_mutex.Wait ();
       close_frame_display ();
-      var_mutex.Signal ();
       uninit();
       uninit_thread = false;
       initialised_thread = false;
@@ -121,9 +151,7 @@ GMVideoOutputManager::Main ()
     }
   }
 
-  var_mutex.Wait ();
   close_frame_display ();
-  var_mutex.Signal ();
 }
 
 void GMVideoOutputManager::set_frame_data (const char* data,
@@ -132,52 +160,128 @@ void GMVideoOutputManager::set_frame_data (const char* data,
 					   unsigned type,
 					   int devices_nbr)
 {
-  Ekiga::DisplayInfo local_display_info;
+  set_frame (frame_pool->acquire_copy (data, width, height), type, devices_nbr);
+}
 
-  if (type < 2)
-    get_display_info (local_display_info);
-  else
-    get_ext_display_info (local_display_info);
+void GMVideoOutputManager::set_frame (Ekiga::VideoFramePtr frame,
+				      unsigned type,
+				      int _devices_nbr)
+{
+  if (type > 2) {
+    run_thread.Signal();
+    return; // nothing happened
+  }
 
-  bool local = (type == 0);
+  g_atomic_int_set (&devices_nbr, _devices_nbr);
+
+  /* Never waits for the display thread: if it did not take the previous
+   * frame of this stream yet, that frame is simply replaced */
+  if (mailboxes[type].publish (frame)) {
+
+    if (type == 0) {
+      PTRACE(3, "GMVideoOutputManager\tSkipped earlier local frame");
+    }
+    else if (type == 1) {
+      PTRACE(3, "GMVideoOutputManager\tSkipped earlier remote frame");
+    }
+    else {
+      PTRACE(3, "GMVideoOutputManager\tSkipped earlier extended frame");
+    }
+  }
+
+  run_thread.Signal();
+}
+
+unsigned
+GMVideoOutputManager::get_dropped_frames (unsigned type) const
+{
+  if (type > 2)
+    return 0;
+
+  return mailboxes[type].get_dropped ();
+}
+
+bool
+GMVideoOutputManager::get_latency_stats (Ekiga::VideoOutputLatencyStats & stats)
+{
+  PWaitAndSignal m(latency_stats_mutex);
 
-  var_mutex.Wait();
+  stats = latency_stats;
+  stats.skipped_local = get_dropped_frames (0) - skipped_at_init[0];
+  stats.skipped_remote = get_dropped_frames (1) - skipped_at_init[1];
+  stats.skipped_ext = get_dropped_frames (2) - skipped_at_init[2];
 
-  if (local) {
+  return true;
+}
+
+void
+GMVideoOutputManager::draw_and_sync (UpdateRequired displayed)
+{
+  UpdateRequired sync_required;
+  double drawn;
+  double synced;
+
+  sync_required = redraw ();
+  drawn = Ekiga::VideoFrame::now ();
+  sync (sync_required);
+  synced = Ekiga::VideoFrame::now ();
+
+  PWaitAndSignal m(latency_stats_mutex);
+
+  latency_stats.sync_wait.add ((synced - drawn) * 1000);
+  if (displayed.local && lframe)
+    latency_stats.capture_to_display.add ((synced - lframe->get_timestamp ()) * 1000);
+  if (displayed.remote && rframe)
+    latency_stats.decode_to_display.add ((synced - rframe->get_timestamp ()) * 1000);
+  if (displayed.extended && eframe)
+    latency_stats.decode_to_display.add ((synced - eframe->get_timestamp ()) * 1000);
+}
 
-    /* memcpy the frame */
-    lframeStore.SetSize (width * height * 3);
-    current_frame.local_width = width;
-    current_frame.local_height= height;
-    memcpy (lframeStore.GetPointer(), data, (width * height * 3) >> 1);
+GMVideoOutputManager::UpdateRequired
+GMVideoOutputManager::take_frames ()
+{
+  UpdateRequired fresh;
+
+  fresh.local = mailboxes[0].take (lframe);
+  if (fresh.local) {
+    current_frame.local_width = lframe->get_width ();
+    current_frame.local_height= lframe->get_height ();
     local_frame_received = true;
   }
-  else if (type == 1) { // REMOTE 1
 
-    /* memcpy the frame */
-    rframeStore.SetSize (width * height * 3);
-    current_frame.remote_width = width;
-    current_frame.remote_height= height;
-    memcpy (rframeStore.GetPointer(), data, (width * height * 3) >> 1);
+  fresh.remote = mailboxes[1].take (rframe);
+  if (fresh.remote) {
+    current_frame.remote_width = rframe->get_width ();
+    current_frame.remote_height= rframe->get_height ();
     remote_frame_received = true;
   }
-  else if (type == 2) { // REMOTE 2 (extended video)
-    /* memcpy the frame */
-    eframeStore.SetSize (width * height * 3);
-    current_frame.ext_width = width;
-    current_frame.ext_height= height;
-    memcpy (eframeStore.GetPointer(), data, (width * height * 3) >> 1);
+
+  fresh.extended = mailboxes[2].take (eframe);
+  if (fresh.extended) {
+    current_frame.ext_width = eframe->get_width ();
+    current_frame.ext_height= eframe->get_height ();
     ext_frame_received = true;
-  } else {
-    var_mutex.Signal();
-    run_thread.Signal();
-    return; // nothing happened
   }
 
+  return fresh;
+}
+
+bool
+GMVideoOutputManager::update_frame_info (unsigned type)
+{
+  Ekiga::DisplayInfo local_display_info;
+
+  if (type < 2)
+    get_display_info (local_display_info);
+  else
+    get_ext_display_info (local_display_info);
+
+  bool local = (type == 0);
+
   /* If there is only one device open, ignore the setting, and
    * display what we can actually display.
    */
-  if (devices_nbr <= 1) {
+  if (g_atomic_int_get (&devices_nbr) <= 1) {
     if (local) {
       local_display_info.mode = Ekiga::VO_MODE_LOCAL;
       remote_frame_received = false;
@@ -203,47 +307,23 @@ void GMVideoOutputManager::set_frame_data (const char* data,
   current_frame.mode = local_display_info.mode;
   current_frame.zoom = local_display_info.zoom;
 
-  if (local) {
-
-    if (update_required.local) {
-      PTRACE(3, "GMVideoOutputManager\tSkipped earlier local frame");
-    }
-    update_required.local = true;
-  }
-  else if (type == 1) {
-
-    if (update_required.remote) {
-      PTRACE(3, "GMVideoOutputManager\tSkipped earlier remote frame");
-    }
-    update_required.remote = true;
-  }
-  else if (type == 2) {
-
-    if (update_required.extended) {
-      PTRACE(3, "GMVideoOutputManager\tSkipped earlier extended frame");
-    }
-    update_required.extended = true;
-  }
-
-  var_mutex.Signal();
-
   if ((local_display_info.mode == Ekiga::VO_MODE_UNSET) ||
       (local_display_info.zoom == 0) ||
       (!local_display_info.config_info_set)) {
     PTRACE(4, "GMVideoOutputManager\tDisplay and zoom variable not set yet, not opening display");
-     return;
+    return false;
   }
 
   if ((local_display_info.mode == Ekiga::VO_MODE_LOCAL) && !local)
-    return;
+    return false;
 
   if (local_display_info.mode == Ekiga::VO_MODE_REMOTE && type != 1)
-    return;
+    return false;
 
   if (local_display_info.mode == Ekiga::VO_MODE_REMOTE_EXT && type != 2)
-    return;
+    return false;
 
-  run_thread.Signal();
+  return true;
 }
 
 
@@ -298,14 +378,34 @@ void GMVideoOutputManager::init()
   update_required.remote = false;
   update_required.extended = false;
 
+  /* The statistics start anew with each opening */
+  {
+    PWaitAndSignal m(latency_stats_mutex);
+    latency_stats = Ekiga::VideoOutputLatencyStats ();
+    for (unsigned i = 0 ; i < 3 ; i++)
+      skipped_at_init[i] = get_dropped_frames (i);
+  }
 }
 
 void GMVideoOutputManager::uninit ()
 {
   /* This is common to all output classes */
-  lframeStore.SetSize (0);
-  rframeStore.SetSize (0);
-  eframeStore.SetSize (0);
+  take_frames ();
+  lframe.reset ();
+  rframe.reset ();
+  eframe.reset ();
+
+  PTRACE(4, "GMVideoOutputManager\tDropped "
+         << get_dropped_frames (0) << " local, "
+         << get_dropped_frames (1) << " remote and "
+         << get_dropped_frames (2) << " extended frames so far");
+  {
+    PWaitAndSignal m(latency_stats_mutex);
+    PTRACE(4, "GMVideoOutputManager\tMean latency: "
+           << latency_stats.capture_to_display.get_mean () << " ms from capture, "
+           << latency_stats.decode_to_display.get_mean () << " ms from decoding, "
+           << latency_stats.sync_wait.get_mean () << " ms waiting in sync");
+  }
 }
 
 void GMVideoOutputManager::update_gui_device ()
@@ -316,10 +416,10 @@ void GMVideoOutputManager::update_gui_device ()
   last_ext_frame.both_streams_active = current_frame.both_streams_active;
   last_ext_frame.ext_stream_active = current_frame.ext_stream_active;
 
-  Ekiga::Runtime::run_in_main (boost::bind (&GMVideoOutputManager::device_closed_in_main, this));
-
+  /* Only the latest state matters to the GUI */
   Ekiga::Runtime::run_in_main
-    (boost::bind (&GMVideoOutputManager::device_opened_in_main, this,
+    ("videooutput-update-gui-device",
+     boost::bind (&GMVideoOutputManager::device_reopened_in_main, this,
                   current_frame.accel, current_frame.mode, current_frame.zoom,
                   current_frame.both_streams_active,
                   current_frame.ext_stream_active));
@@ -408,30 +508,30 @@ GMVideoOutputManager::redraw ()
 
   switch (current_frame.mode) {
   case Ekiga::VO_MODE_LOCAL:
-    if (lframeStore.GetSize() > 0)
-      display_frame ((char *) lframeStore.GetPointer (),
+    if (lframe)
+      display_frame (lframe->get_data (),
                      current_frame.local_width, current_frame.local_height);
     break;
 
   case Ekiga::VO_MODE_REMOTE:
-    if (rframeStore.GetSize() > 0)
-      display_frame ((char *) rframeStore.GetPointer (),
+    if (rframe)
+      display_frame (rframe->get_data (),
                      current_frame.remote_width, current_frame.remote_height);
     break;
 
   case Ekiga::VO_MODE_FULLSCREEN:
   case Ekiga::VO_MODE_PIP:
   case Ekiga::VO_MODE_PIP_WINDOW:
-    if ((lframeStore.GetSize() > 0) &&  (rframeStore.GetSize() > 0))
-      display_pip_frames ((char *) lframeStore.GetPointer (),
+    if (lframe && rframe)
+      display_pip_frames (lframe->get_data (),
                           current_frame.local_width, current_frame.local_height,
-                          (char *) rframeStore.GetPointer (),
+                          rframe->get_data (),
                           current_frame.remote_width, current_frame.remote_height);
     break;
 
   case Ekiga::VO_MODE_REMOTE_EXT:
-    if (eframeStore.GetSize() > 0)
-      display_frame ((char *) eframeStore.GetPointer (),
+    if (eframe)
+      display_frame (eframe->get_data (),
                      current_frame.ext_width, current_frame.ext_height);
     break;
 
@@ -449,16 +549,11 @@ GMVideoOutputManager::redraw ()
 
 
 void
-GMVideoOutputManager::device_opened_in_main (Ekiga::VideoOutputAccel accel,
-					     Ekiga::VideoOutputMode mode,
-					     unsigned zoom,
-					     bool both, bool ext)
-{
-  device_opened (accel, mode, zoom, both, ext);
-}
-
-void
-GMVideoOutputManager::device_closed_in_main ()
+GMVideoOutputManager::device_reopened_in_main (Ekiga::VideoOutputAccel accel,
+					       Ekiga::VideoOutputMode mode,
+					       unsigned zoom,
+					       bool both, bool ext)
 {
   device_closed ();
+  device_opened (accel, mode, zoom, both, ext);
 }
@@ -68,19 +68,21 @@
    * A call to open() from the core will signal the thread to execute the initialize function,
    * with open() blocking until the thread has finished its task. 
    * The thread is now ready to accept frames, which will arrive from the core via
-   * set_frame_data(). set_frame_data will make a local copy of the image via memcpy,
-   * and signal the thread that a new remote or local frame has arrived and is ready to be
-   * displayed. Then set_frame_data() will be left, while the actual display of the frame
-   * will be performed in the thread.
+   * set_frame(). set_frame() publishes a reference to the pooled frame in the
+   * lock-free mailbox of its stream (local, remote or extended), replacing the previous
+   * one if the thread did not take it yet, and signals the thread that a new frame has
+   * arrived and is ready to be displayed. Then set_frame() will be left, while the actual
+   * display of the frame will be performed in the thread: producers never wait for it.
    * Once the thread has been triggered with a new frame to display, it will first call redraw
    * for passing the frame to the graphics adaptor, and then do_sync to actually displaying it.
-   * The reason these procedures are separate has the following motivation: do_sync can block for
-   * quite some time if synv-to-vblank is active. If this would be executed in the mutex-protected
-   * redraw procedure, we would be blocking the video processing threads, possibly leading to lost packets
-   * and interfering with synchronous frame transmission.
+   * All the frame state (current_frame, update_required, the received frames) belongs
+   * to the thread, which takes the latest frame of each stream from the mailboxes before
+   * drawing; this way neither redraw nor a do_sync blocked on vblank can delay the video
+   * processing threads, which could lead to lost packets and interfere with synchronous
+   * frame transmission.
    * redraw() will check whether the dxWindow/xvWindow classes need to be reinitialized (e.g. we want to 
    * switching from non-pip mode to pip mode, etc.), do that if desired and then pass pointers to the 
-   * (copied) frames to the dxWindow/xvWindow classes via display_frame() and display_pip_frames(). It will
+   * referenced frames to the dxWindow/xvWindow classes via display_frame() and display_pip_frames(). It will
    * also determine if only one or both frames need to be synched to the screen.
    * Once the device has been opened/initialized and no new frame arrives, the frames will nevertheless
    * be updated every 250 ms.
@@ -117,6 +119,18 @@
                                   unsigned type,
                                   int devices_nbr);
 
+    virtual void set_frame (Ekiga::VideoFramePtr frame,
+                            unsigned type,
+                            int devices_nbr);
+
+    /** Returns the number of frames of the given stream which were replaced
+     * by a newer one before the thread could display them.
+     * @param type the type of the stream: 0 - local, 1 - remote, 2 - extended.
+     */
+    unsigned get_dropped_frames (unsigned type) const;
+
+    virtual bool get_latency_stats (Ekiga::VideoOutputLatencyStats & stats);
+
     virtual void set_display_info (const Ekiga::DisplayInfo & _display_info) {
       PWaitAndSignal m(display_info_mutex);
       display_info = _display_info;
@@ -183,6 +197,20 @@
                                     unsigned rf_width,
                                     unsigned rf_height) = 0;
   
+    /** Take the new frames
+     * Take the latest frame of each stream from the mailboxes, and
+     * update the frame dimensions accordingly.
+     * @return which streams got a new frame.
+     */
+    UpdateRequired take_frames ();
+
+    /** Update the frame information
+     * Compute the display mode after a new frame of the given stream
+     * was taken.
+     * @return wether that frame should be displayed.
+     */
+    bool update_frame_info (unsigned type);
+
     /** Draw the frame 
      * Draw the frame to a backbuffer, do not show it yet.
      * @return wether the local, the remote or both frames need to be synced to the screen.
@@ -196,6 +224,11 @@
      */
     virtual void sync(UpdateRequired sync_required) = 0;
 
+    /** Draw and sync the frames, measuring their latency
+     * @param displayed which streams got a new frame to display.
+     */
+    void draw_and_sync (UpdateRequired displayed);
+
     /** Initialises the display
      */
     virtual void init ();
@@ -227,9 +260,22 @@
     PMutex display_info_mutex; /* To protect the DisplayInfo object */
     PMutex ext_display_info_mutex; /* To protect the 2nd DisplayInfo object */
 
-    PBYTEArray lframeStore;
-    PBYTEArray rframeStore;
-    PBYTEArray eframeStore;
+    /* The streams are exchanged with the producers through those */
+    Ekiga::VideoFrameMailbox mailboxes[3];
+    volatile gint devices_nbr;
+
+    /* The frames being displayed, only used by the thread */
+    Ekiga::VideoFramePtr lframe;
+    Ekiga::VideoFramePtr rframe;
+    Ekiga::VideoFramePtr eframe;
+
+    /* For the frames given through set_frame_data () */
+    Ekiga::VideoFramePoolPtr frame_pool;
+
+    /* Since the device was opened ; written by the thread only */
+    Ekiga::VideoOutputLatencyStats latency_stats;
+    unsigned skipped_at_init[3];
+    PMutex latency_stats_mutex;
 
     typedef struct {
       Ekiga::VideoOutputMode mode;
@@ -271,20 +317,16 @@
     PSyncPoint thread_initialised;          /* To signal that the thread has been initialised */
     PSyncPoint thread_uninitialised;        /* To signal that the thread has been uninitialised */
     PMutex     thread_ended;                /* To exit */
-    
-    PMutex var_mutex;      /* To protect variables that are read and written
-                              from various threads */
-  
+
+
     Ekiga::ServiceCore & core;
 
   private:
 
-    void device_opened_in_main (Ekiga::VideoOutputAccel accel,
-				Ekiga::VideoOutputMode mode,
-				unsigned zoom,
-				bool both, bool ext);
-
-    void device_closed_in_main ();
+    void device_reopened_in_main (Ekiga::VideoOutputAccel accel,
+				  Ekiga::VideoOutputMode mode,
+				  unsigned zoom,
+				  bool both, bool ext);
 
   };
 
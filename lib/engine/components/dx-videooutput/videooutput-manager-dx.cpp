@@ -89,7 +89,8 @@ GMVideoOutputManager_dx::setup_frame_display ()
   switch (current_frame.mode) {
   case Ekiga::VO_MODE_LOCAL:
     Ekiga::Runtime::run_in_main
-      (boost::bind (&GMVideoOutputManager_dx::size_changed_in_main, this,
+      ("videooutput-size-changed",
+       boost::bind (&GMVideoOutputManager_dx::size_changed_in_main, this,
                     (unsigned) (current_frame.local_width * current_frame.zoom / 100),
                     (unsigned) (current_frame.local_height * current_frame.zoom / 100),
                     current_frame.mode));
@@ -97,24 +98,28 @@ GMVideoOutputManager_dx::setup_frame_display ()
   case Ekiga::VO_MODE_REMOTE:
   case Ekiga::VO_MODE_PIP:
     Ekiga::Runtime::run_in_main
-      (boost::bind (&GMVideoOutputManager_dx::size_changed_in_main, this,
+      ("videooutput-size-changed",
+       boost::bind (&GMVideoOutputManager_dx::size_changed_in_main, this,
                     (unsigned) (current_frame.remote_width * current_frame.zoom / 100),
                     (unsigned) (current_frame.remote_height * current_frame.zoom / 100),
                     current_frame.mode));
     break;
   case Ekiga::VO_MODE_FULLSCREEN:
     Ekiga::Runtime::run_in_main
-      (boost::bind (&GMVideoOutputManager_dx::size_changed_in_main, this,
+      ("videooutput-size-changed",
+       boost::bind (&GMVideoOutputManager_dx::size_changed_in_main, this,
                     176, 144, current_frame.mode));
     break;
   case Ekiga::VO_MODE_PIP_WINDOW:
     Ekiga::Runtime::run_in_main
-      (boost::bind (&GMVideoOutputManager_dx::size_changed_in_main, this,
+      ("videooutput-size-changed",
+       boost::bind (&GMVideoOutputManager_dx::size_changed_in_main, this,
                     176, 144, current_frame.mode));
     break;
   case Ekiga::VO_MODE_REMOTE_EXT:
     Ekiga::Runtime::run_in_main
-      (boost::bind (&GMVideoOutputManager_dx::size_changed_in_main, this,
+      ("videooutput-ext-size-changed",
+       boost::bind (&GMVideoOutputManager_dx::size_changed_in_main, this,
                     (unsigned) (current_frame.ext_width * current_frame.zoom / 100),
                     (unsigned) (current_frame.ext_height * current_frame.zoom / 100),
                     current_frame.mode));
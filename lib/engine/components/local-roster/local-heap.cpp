@@ -50,18 +50,15 @@
  */
 Local::Heap::Heap (boost::shared_ptr<Ekiga::PresenceCore> _presence_core,
 		   boost::shared_ptr<Local::Cluster> _local_cluster):
-  presence_core(_presence_core), local_cluster(_local_cluster), doc ()
+  presence_core(_presence_core), local_cluster(_local_cluster), doc (),
+  store("roster.xml", "list", ROSTER_KEY)
 {
   xmlNodePtr root;
-  gchar *c_raw = gm_conf_get_string (ROSTER_KEY);
 
-  // Build the XML document representing the contacts list from the configuration
-  if (c_raw != NULL) {
+  doc = store.load ();
 
-    const std::string raw = c_raw;
-    doc = boost::shared_ptr<xmlDoc> (xmlRecoverMemory (raw.c_str (), raw.length ()), xmlFreeDoc);
-    if ( !doc)
-      doc = boost::shared_ptr<xmlDoc> (xmlNewDoc (BAD_CAST "1.0"), xmlFreeDoc);
+  // Build the XML document representing the contacts list from its file
+  if (doc) {
 
     root = xmlDocGetRootElement (doc.get ());
     if (root == NULL) {
@@ -76,8 +73,6 @@ Local::Heap::Heap (boost::shared_ptr<Ekiga::PresenceCore> _presence_core,
 	  && xmlStrEqual (BAD_CAST ("entry"), child->name))
 	add (child);
 
-    g_free (c_raw);
-
     // Or create a new XML document
   }
   else {
@@ -85,6 +80,7 @@ Local::Heap::Heap (boost::shared_ptr<Ekiga::PresenceCore> _presence_core,
     doc = boost::shared_ptr<xmlDoc> (xmlNewDoc (BAD_CAST "1.0"), xmlFreeDoc);
     root = xmlNewDocNode (doc.get (), NULL, BAD_CAST "list", NULL);
     xmlDocSetRootElement (doc.get (), root);
+    store.reset (doc);
 
     {
       // add 500, 501 and 520 at ekiga.net in this case!
@@ -347,7 +343,7 @@ Local::Heap::add (const std::string name,
 
   xmlAddChild (root, presentity->get_node ());
 
-  save ();
+  store.append (presentity->get_node ());
   common_add (presentity);
 }
 
@@ -370,16 +366,9 @@ Local::Heap::common_add (PresentityPtr presentity)
 
 
 void
-Local::Heap::save () const
+Local::Heap::save ()
 {
-  xmlChar *buffer = NULL;
-  int size = 0;
-
-  xmlDocDumpMemory (doc.get (), &buffer, &size);
-
-  gm_conf_set_string (ROSTER_KEY, (const char *)buffer);
-
-  xmlFree (buffer);
+  store.save ();
 }
 
 
@@ -410,7 +399,6 @@ Local::Heap::new_presentity_form_submitted (bool submitted,
       && !has_presentity_with_uri (uri)) {
 
     add (name, uri, groups);
-    save ();
   } else {
 
     boost::shared_ptr<Ekiga::FormRequestSimple> request = boost::shared_ptr<Ekiga::FormRequestSimple>(new Ekiga::FormRequestSimple (boost::bind (&Local::Heap::new_presentity_form_submitted, this, _1, _2)));
@@ -39,6 +39,7 @@
 
 #include "heap-impl.h"
 #include "friend-or-foe.h"
+#include "xml-store.h"
 #include "local-presentity.h"
 
 namespace Local
@@ -59,8 +60,8 @@ namespace Local
    * signals defined in heap.h through the use of global implementations
    * coded in heap-imp.h.
    *
-   * When required, the Heap content is being saved in a GmConf entry.
-   * Alternatively, it could be saved elsewhere.
+   * When required, the Heap content is being saved in a file of its own,
+   * a few seconds later, so that a burst of changes is saved only once.
    */
   class Heap:
     public Ekiga::HeapImpl<Presentity>,
@@ -180,9 +181,9 @@ namespace Local
     void common_add (PresentityPtr presentity);
 
 
-    /** Save the XML Document in the GmConf key.
+    /** Save the XML Document in its file.
      */
-    void save () const;
+    void save ();
 
 
     /** This should be triggered when a new Presentity form
@@ -208,6 +209,7 @@ namespace Local
     boost::weak_ptr<Ekiga::PresenceCore> presence_core;
     boost::weak_ptr<Local::Cluster> local_cluster;
     boost::shared_ptr<xmlDoc> doc;
+    Ekiga::XmlStore store;
   };
 
   typedef boost::shared_ptr<Heap> HeapPtr;
@@ -55,6 +55,10 @@
 
 #include "sip-endpoint.h"
 
+/* older versions wrote other values in the twelfth field of the account
+ * string, so the resource list is told apart by this marker */
+#define RESOURCE_LIST_MARKER "resource-list="
+
 Opal::Account::Account (boost::shared_ptr<Opal::Sip::EndPoint> _sip_endpoint,
 			boost::shared_ptr<Ekiga::NotificationCore> _notification_core,
 			boost::shared_ptr<Ekiga::PersonalDetails> _personal_details,
@@ -72,6 +76,7 @@ Opal::Account::Account (boost::shared_ptr<Opal::Sip::EndPoint> _sip_endpoint,
   message_waiting_number = 0;
   failed_registration_already_notified = false;
   dead = false;
+  resource_list_known = false;
 
   int i = 0;
   char *pch = strtok ((char *) account.c_str (), "|");
@@ -118,9 +123,13 @@ Opal::Account::Account (boost::shared_ptr<Opal::Sip::EndPoint> _sip_endpoint,
       timeout = atoi (pch);
       break;
 
+    case 11:
+      if (g_str_has_prefix (pch, RESOURCE_LIST_MARKER "sip:"))
+        resource_list = pch + strlen (RESOURCE_LIST_MARKER);
+      break;
+
     case 1:
     case 6:
-    case 11:
     default:
       break;
     }
@@ -186,6 +195,7 @@ Opal::Account::Account (boost::shared_ptr<Opal::Sip::EndPoint> _sip_endpoint,
   type = t;
   failed_registration_already_notified = false;
   dead = false;
+  resource_list_known = false;
 
   setup_presentity ();
 
@@ -217,6 +227,10 @@ const std::string Opal::Account::as_string () const
       << (password.empty () ? " " : password) << "|"
       << timeout;
 
+  // optional, so older versions still read the account
+  if (!resource_list.empty ())
+    str << "|" RESOURCE_LIST_MARKER << resource_list;
+
   return str.str ();
 }
 
@@ -297,6 +311,12 @@ unsigned Opal::Account::get_timeout () const
 }
 
 
+const std::string Opal::Account::get_resource_list () const
+{
+  return resource_list;
+}
+
+
 void Opal::Account::set_authentication_settings (const std::string & _username,
                                                  const std::string & _password)
 {
@@ -327,10 +347,11 @@ void Opal::Account::disable ()
 
   if (presentity) {
 
+    unsubscribe_watched_uris ();
     for (std::set<std::string>::iterator iter = watched_uris.begin ();
          iter != watched_uris.end (); ++iter) {
-      presentity->UnsubscribeFromPresence (PString (*iter));
-      Ekiga::Runtime::run_in_main (boost::bind (&Opal::Account::presence_status_in_main, this, *iter, "unknown", ""));
+      Ekiga::Runtime::run_in_main ("presence:" + get_aor () + ":" + *iter,
+                                   boost::bind (&Opal::Account::presence_status_in_main, this, *iter, "unknown", ""));
     }
   }
 
@@ -507,6 +528,8 @@ void Opal::Account::edit ()
     request->text ("authentication_user", _("Authentication user:"), get_authentication_username (), _("The user name used during authentication, if different than the user name; leave empty if you do not have one"));
   request->private_text ("password", _("Password:"), get_password (), _("Password associated to the user"));
   request->text ("timeout", _("Timeout:"), str.str (), _("Time in seconds after which the account registration is automatically retried"));
+  if (get_protocol_name () == "SIP")
+    request->text ("resource_list", _("Presence list:"), get_resource_list (), _("The address of the list of your contacts on the presence server, e.g. sip:jim-buddies@ekiga.net, to watch them all with a single subscription; leave empty if you do not have one"));
   request->boolean ("enabled", _("Enable account"), enabled);
 
   questions (request);
@@ -528,9 +551,13 @@ void Opal::Account::on_edit_form_submitted (bool submitted,
   if (new_authentication_user.empty ())
     new_authentication_user = new_user;
   std::string new_password = result.private_text ("password");
+  std::string new_resource_list;
+  if (get_protocol_name () == "SIP")
+    new_resource_list = result.text ("resource_list");
   bool new_enabled = result.boolean ("enabled");
   bool should_enable = false;
   bool should_disable = false;
+  bool should_resubscribe = false;
   unsigned new_timeout = atoi (result.text ("timeout").c_str ());
   std::string error;
 
@@ -542,6 +569,9 @@ void Opal::Account::on_edit_form_submitted (bool submitted,
     error = _("You did not supply a user name for that account.");
   else if (new_timeout < 10)
     error = _("The timeout should be at least 10 seconds.");
+  else if (!new_resource_list.empty ()
+           && new_resource_list.compare (0, 4, "sip:") != 0)
+    error = _("The presence list should be a SIP address, e.g. sip:jim-buddies@ekiga.net.");
 
   if (!error.empty ()) {
 
@@ -572,6 +602,13 @@ void Opal::Account::on_edit_form_submitted (bool submitted,
       }
     }
 
+    // The contacts are watched differently from now on
+    if (resource_list != new_resource_list && state == Registered && presentity) {
+
+      unsubscribe_watched_uris ();
+      should_resubscribe = true;
+    }
+
     enabled = new_enabled;
     name = new_name;
     host = new_host;
@@ -579,12 +616,15 @@ void Opal::Account::on_edit_form_submitted (bool submitted,
     auth_username = new_authentication_user;
     password = new_password;
     timeout = new_timeout;
+    resource_list = new_resource_list;
     enabled = new_enabled;
 
     if (should_enable)
       enable ();
     else if (should_disable)
       disable ();
+    else if (should_resubscribe)
+      subscribe_watched_uris ();
 
     updated ();
     trigger_saving ();
@@ -654,6 +694,17 @@ Opal::Account::fetch (const std::string uri)
 
   // Subscribe now
   if (state == Registered) {
+
+    if (!resource_list.empty ()) {
+
+      // the resource list will tell, or already does
+      if (!resource_list_known
+          || listed_uris.find (uri) != listed_uris.end ())
+        return;
+
+      single_uris.insert (uri);
+    }
+
     PTRACE(4, "Ekiga\tSubscribeToPresence for " << uri.c_str () << " (fetch)");
     presentity->SubscribeToPresence (PString (uri));
   }
@@ -663,9 +714,95 @@ void
 Opal::Account::unfetch (const std::string uri)
 {
   if (is_myself (uri) && presentity) {
-    presentity->UnsubscribeFromPresence (PString (uri));
+    if (resource_list.empty () || single_uris.erase (uri))
+      presentity->UnsubscribeFromPresence (PString (uri));
     watched_uris.erase (uri);
-    Ekiga::Runtime::run_in_main (boost::bind (&Opal::Account::presence_status_in_main, this, uri, "unknown", ""));
+    Ekiga::Runtime::run_in_main ("presence:" + get_aor () + ":" + uri,
+                                 boost::bind (&Opal::Account::presence_status_in_main, this, uri, "unknown", ""));
+  }
+}
+
+void
+Opal::Account::subscribe_watched_uris ()
+{
+  /* when registered again, the uris watched on their own are dropped : the
+   * list may contain some of them by now, and its first NOTIFY tells which
+   * need their own subscription again */
+  for (std::set<std::string>::iterator iter = single_uris.begin ();
+       iter != single_uris.end (); ++iter)
+    presentity->UnsubscribeFromPresence (PString (*iter));
+
+  single_uris.clear ();
+  listed_uris.clear ();
+  resource_list_known = false;
+
+  if (resource_list.empty () || type == Account::H323) {
+
+    for (std::set<std::string>::iterator iter = watched_uris.begin ();
+         iter != watched_uris.end (); ++iter) {
+      PTRACE(4, "Ekiga\tSubscribeToPresence for " << iter->c_str () << " (Account Registered)");
+      presentity->SubscribeToPresence (PString (*iter));
+    }
+    return;
+  }
+
+  SIPSubscribe::Params params (SIPSubscribe::Presence);
+  params.m_addressOfRecord = resource_list;
+  params.m_localAddress = get_aor ();
+  params.m_authID = auth_username;
+  params.m_password = password;
+  params.m_expire = 3600;
+  params.m_eventList = true;
+  params.m_contentType = "application/pidf+xml";
+  params.m_onNotify = PCREATE_NOTIFIER2 (OnResourceListNotify, SIPSubscribe::NotifyCallbackInfo &);
+  params.m_onSubcribeStatus = PCREATE_NOTIFIER2 (OnResourceListStatus, const SIPSubscribe::SubscriptionStatus &);
+
+  PString token;
+  PTRACE(4, "Ekiga\tSubscribe to resource list " << resource_list << " for " << watched_uris.size () << " watched uris");
+  sip_endpoint->Subscribe (params, token);
+}
+
+void
+Opal::Account::unsubscribe_watched_uris ()
+{
+  for (std::set<std::string>::iterator iter = watched_uris.begin ();
+       iter != watched_uris.end (); ++iter)
+    if (resource_list.empty () || single_uris.find (*iter) != single_uris.end ())
+      presentity->UnsubscribeFromPresence (PString (*iter));
+
+  if (!resource_list.empty ())
+    sip_endpoint->Unsubscribe (SIPSubscribe::Presence, resource_list, true);
+
+  single_uris.clear ();
+  listed_uris.clear ();
+  resource_list_known = false;
+}
+
+void
+Opal::Account::subscribe_unlisted_uris ()
+{
+  for (std::set<std::string>::iterator iter = watched_uris.begin ();
+       iter != watched_uris.end (); ++iter) {
+
+    if (listed_uris.find (*iter) == listed_uris.end ()
+        && single_uris.insert (*iter).second) {
+
+      PTRACE(4, "Ekiga\tSubscribeToPresence for " << iter->c_str () << " (not in the resource list)");
+      presentity->SubscribeToPresence (PString (*iter));
+    }
+  }
+
+  // the list may have grown to contain some of them
+  for (std::set<std::string>::iterator iter = single_uris.begin ();
+       iter != single_uris.end (); ) {
+
+    if (listed_uris.find (*iter) != listed_uris.end ()) {
+
+      presentity->UnsubscribeFromPresence (PString (*iter));
+      single_uris.erase (iter++);
+    }
+    else
+      ++iter;
   }
 }
 
@@ -684,11 +821,7 @@ Opal::Account::handle_registration_event (RegistrationState state_,
       status = _("Registered");
       if (presentity) {
 
-        for (std::set<std::string>::iterator iter = watched_uris.begin ();
-             iter != watched_uris.end (); ++iter) {
-          PTRACE(4, "Ekiga\tSubscribeToPresence for " << iter->c_str () << " (Account Registered)");
-          presentity->SubscribeToPresence (PString (*iter));
-        }
+        const_cast<Account*>(this)->subscribe_watched_uris ();
         presentity->SetLocalPresence (personal_state, presence_status);
         if (type != Account::H323) {
           sip_endpoint->Subscribe (SIPSubscribe::MessageSummary, 3600, get_aor ());
@@ -710,6 +843,11 @@ Opal::Account::handle_registration_event (RegistrationState state_,
     // "(you are) unregistered", and not as "(you have been) unregistered"
     status = _("Unregistered");
     failed_registration_already_notified = false;
+
+    /* when disabled, that was done already */
+    if (state == Registered && enabled && presentity)
+      const_cast<Account*>(this)->unsubscribe_watched_uris ();
+
     state = state_;
 
     updated ();
@@ -845,26 +983,14 @@ Opal::Account::setup_presentity ()
 }
 
 
-void
-Opal::Account::OnPresenceChange (OpalPresentity& /*presentity*/,
-				 const OpalPresenceInfo& info)
+/* the presence and status ekiga shows for an OPAL presence */
+static void
+presence_from_info (const OpalPresenceInfo& info,
+                    std::string& new_presence,
+                    std::string& new_status)
 {
-  std::string new_presence;
-  std::string new_status = "";
-
-  SIPURL sip_uri = SIPURL (info.m_entity);
-  sip_uri.Sanitise (SIPURL::ExternalURI);
-  std::string uri = sip_uri.AsString ();
   PCaselessString note = info.m_note;
 
-  PTRACE (4, "Ekiga\tReceived a presence change (notify) for " << info.m_entity << ": state " << info.m_state << ", note " << info.m_note);
-
-  if (info.m_state == OpalPresenceInfo::Unchanged)
-    return;
-
-  if (!uri.compare (0, 5, "pres:"))
-    uri.replace (0, 5, "sip:");  // replace "pres:" sith "sip:" FIXME
-
   new_status = (const char*) info.m_note;
   switch (info.m_state) {
 
@@ -995,8 +1121,34 @@ Opal::Account::OnPresenceChange (OpalPresentity& /*presentity*/,
   default:
     break;
   }
+}
+
+
+void
+Opal::Account::OnPresenceChange (OpalPresentity& /*presentity*/,
+				 const OpalPresenceInfo& info)
+{
+  std::string new_presence;
+  std::string new_status = "";
+
+  SIPURL sip_uri = SIPURL (info.m_entity);
+  sip_uri.Sanitise (SIPURL::ExternalURI);
+  std::string uri = sip_uri.AsString ();
+
+  PTRACE (4, "Ekiga\tReceived a presence change (notify) for " << info.m_entity << ": state " << info.m_state << ", note " << info.m_note);
 
-  Ekiga::Runtime::run_in_main (boost::bind (&Opal::Account::presence_status_in_main, this, uri, new_presence, new_status));
+  if (info.m_state == OpalPresenceInfo::Unchanged)
+    return;
+
+  if (!uri.compare (0, 5, "pres:"))
+    uri.replace (0, 5, "sip:");  // replace "pres:" sith "sip:" FIXME
+
+  presence_from_info (info, new_presence, new_status);
+
+  /* a presentity changing its status several times in a row only needs
+   * its latest status to be shown */
+  Ekiga::Runtime::run_in_main ("presence:" + get_aor () + ":" + uri,
+                               boost::bind (&Opal::Account::presence_status_in_main, this, uri, new_presence, new_status));
 }
 
 
@@ -1008,3 +1160,104 @@ Opal::Account::presence_status_in_main (std::string uri,
   presence_received (uri, uri_presence);
   status_received (uri, uri_status);
 }
+
+
+void
+Opal::Account::resource_list_in_main (bool full_state,
+                                      std::list<Opal::Sip::ResourceState> resources)
+{
+  // a late notification for a list we do not watch anymore
+  if (resource_list.empty () || !enabled || state != Registered || !presentity)
+    return;
+
+  if (full_state)
+    listed_uris.clear ();
+
+  for (std::list<Opal::Sip::ResourceState>::const_iterator iter = resources.begin ();
+       iter != resources.end ();
+       ++iter) {
+
+    if (iter->state == "terminated")
+      listed_uris.erase (iter->uri);
+    else
+      listed_uris.insert (iter->uri);
+
+    if (watched_uris.find (iter->uri) == watched_uris.end ())
+      continue;
+
+    if (iter->has_presence) {
+
+      OpalPresenceInfo info (iter->open ? OpalPresenceInfo::Available : OpalPresenceInfo::NoPresence);
+      std::string new_presence;
+      std::string new_status;
+
+      info.m_note = iter->note;
+      presence_from_info (info, new_presence, new_status);
+      presence_status_in_main (iter->uri, new_presence, new_status);
+    }
+    else if (iter->state == "terminated")
+      presence_status_in_main (iter->uri, "unknown", "");
+  }
+
+  if (full_state)
+    resource_list_known = true;
+
+  if (resource_list_known)
+    subscribe_unlisted_uris ();
+}
+
+
+void
+Opal::Account::OnResourceListNotify (SIPSubscribeHandler& /*handler*/,
+                                     SIPSubscribe::NotifyCallbackInfo& notify)
+{
+  bool full_state = false;
+  std::list<Opal::Sip::ResourceState> resources;
+  PString body = notify.m_notify.GetEntityBody ();
+
+  // the NOTIFY of a pending or terminated subscription may have no body
+  if (body.IsEmpty ()) {
+
+    notify.SendResponse (SIP_PDU::Successful_OK);
+    return;
+  }
+
+  if (!Opal::Sip::parse_resource_list ((const char*) notify.m_notify.GetMIME ().GetContentType (true),
+                                       (const char*) body,
+                                       full_state, resources)) {
+
+    PTRACE (2, "Ekiga\tCould not parse the NOTIFY of resource list " << resource_list);
+    notify.SendResponse (SIP_PDU::Failure_UnsupportedMediaType);
+    return;
+  }
+
+  notify.SendResponse (SIP_PDU::Successful_OK);
+
+  for (std::list<Opal::Sip::ResourceState>::iterator iter = resources.begin ();
+       iter != resources.end ();
+       ++iter) {
+
+    SIPURL sip_uri = SIPURL (PString (iter->uri));
+    sip_uri.Sanitise (SIPURL::ExternalURI);
+    iter->uri = sip_uri.AsString ();
+  }
+
+  PTRACE (4, "Ekiga\tReceived " << resources.size () << " resources of list " << resource_list << (full_state ? " (full state)" : ""));
+
+  Ekiga::Runtime::run_in_main (boost::bind (&Opal::Account::resource_list_in_main, this, full_state, resources));
+}
+
+
+void
+Opal::Account::OnResourceListStatus (SIPSubscribeHandler& /*handler*/,
+                                     const SIPSubscribe::SubscriptionStatus& status)
+{
+  if (!status.m_wasSubscribing || status.m_reason / 100 == 2)
+    return;
+
+  /* the server does not know the list : an empty full state makes each
+   * watched uri get a subscription of its own */
+  PTRACE (2, "Ekiga\tCould not subscribe to resource list " << resource_list << ": " << status.m_reason);
+
+  Ekiga::Runtime::run_in_main (boost::bind (&Opal::Account::resource_list_in_main, this, true, std::list<Opal::Sip::ResourceState> ()));
+}
@@ -40,6 +40,7 @@
 
 #include <opal/pres_ent.h>
 #include <sip/sippdu.h>
+#include <sip/handlers.h>
 
 #include "notification-core.h"
 #include "presence-core.h"
@@ -48,6 +49,8 @@
 
 #include "bank-impl.h"
 
+#include "sip-resource-list.h"
+
 namespace Opal
 {
   // forward declarations:
@@ -141,6 +144,13 @@ public:
      */
     unsigned get_timeout () const;
 
+    /** Returns the URI of the resource list (RFC 4662) through which the
+     * presence of the contacts of the Opal::Account is watched.
+     * @return The URI of the resource list, or an empty string if each
+     * contact is watched with a subscription of its own.
+     */
+    const std::string get_resource_list () const;
+
     void enable ();
 
     void disable ();
@@ -219,6 +229,23 @@ private:
     PDECLARE_PresenceChangeNotifier (Account, OnPresenceChange);
 
     std::set<std::string> watched_uris;
+
+    /* With a resource list, the watched uris the server put in it are
+     * watched through a single subscription : only the others get one of
+     * their own, once the first NOTIFY told what the list contains */
+    std::string resource_list;
+    std::set<std::string> listed_uris;
+    std::set<std::string> single_uris;
+    bool resource_list_known;
+    void subscribe_watched_uris ();
+    void unsubscribe_watched_uris ();
+    void subscribe_unlisted_uris ();
+    void resource_list_in_main (bool full_state,
+				std::list<Opal::Sip::ResourceState> resources);
+
+    PDECLARE_NOTIFIER2 (SIPSubscribeHandler, Account, OnResourceListNotify, SIPSubscribe::NotifyCallbackInfo &);
+    PDECLARE_NOTIFIER2 (SIPSubscribeHandler, Account, OnResourceListStatus, const SIPSubscribe::SubscriptionStatus &);
+
     OpalPresenceInfo::State personal_state;
     std::string presence_status;
     void presence_status_in_main (std::string uri,
@@ -114,6 +114,9 @@ bool PVideoOutputDevice_EKIGA::SetFrameData (unsigned x,
 					   const BYTE * data,
 					   bool endFrame)
 {
+  /* the frame was decoded (or captured, for the local one) just now */
+  double produced = Ekiga::VideoFrame::now ();
+
   PWaitAndSignal m(videoDisplay_mutex);
 
   if (x > 0 || y > 0)
@@ -136,7 +139,13 @@ bool PVideoOutputDevice_EKIGA::SetFrameData (unsigned x,
     devices_nbr++;
   }
 
-  videooutput_core->set_frame_data((const char*) data, width, height, device_id, devices_nbr);
+  /* OPAL keeps ownership of the decoded picture, so this is the only
+   * copy: the pooled frame is then handed over to the display by
+   * reference */
+  Ekiga::VideoFramePtr frame = videooutput_core->acquire_frame (width, height);
+  memcpy (frame->get_data (), data, frame->get_size ());
+  frame->set_timestamp (produced);
+  videooutput_core->set_frame (frame, device_id, devices_nbr);
 
   return TRUE;
 }
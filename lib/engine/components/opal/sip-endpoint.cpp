@@ -36,11 +36,17 @@
  */
 
 
+#include <algorithm>
+#include <climits>
+
 #include <glib/gi18n.h>
 #include "config.h"
 #include "sip-endpoint.h"
 #include "chat-core.h"
 
+/* How many threads run the registrations */
+#define SUBSCRIBER_THREADS 3
+
 namespace Opal {
 
   namespace Sip {
@@ -50,61 +56,20 @@ namespace Opal {
       PCLASSINFO(subscriber, PThread);
 
     public:
-      subscriber (std::string _username,
-		  std::string _host,
-		  std::string _authentication_username,
-		  std::string _password,
-		  bool _is_enabled,
-		  SIPRegister::CompatibilityModes _compat_mode,
-		  unsigned _timeout,
-		  std::string _aor,
-                  Opal::Sip::EndPoint & _manager,
-		  bool _registering,
-                  const PSafePtr<OpalPresentity> & _presentity)
-        : PThread (1000, AutoDeleteThread),
-	  username(_username),
-	  host(_host),
-	  authentication_username(_authentication_username),
-	  password(_password),
-	  is_enabled(_is_enabled),
-	  compat_mode(_compat_mode),
-	  timeout(_timeout),
-	  aor(_aor),
-	  manager (_manager),
-	  registering (_registering),
-	  presentity (_presentity)
+      subscriber (Opal::Sip::EndPoint & _manager)
+        : PThread (1000, NoAutoDeleteThread, NormalPriority, "SIPSubscriber"),
+	  manager (_manager)
       {
         this->Resume ();
       };
 
       void Main ()
       {
-	if (registering) {
-
-          if (presentity && !presentity->IsOpen ())
-            presentity->Open ();
-	  manager.Register (username, host, authentication_username, password, is_enabled, compat_mode, timeout);
-	}
-        else {
-	  manager.Unregister (aor);
-
-          if (presentity && presentity->IsOpen ())
-            presentity->Close ();
-	}
+	while (manager.run_subscriber_task ());
       };
 
     private:
-      std::string username;
-      std::string host;
-      std::string authentication_username;
-      std::string password;
-      bool is_enabled;
-      SIPRegister::CompatibilityModes compat_mode;
-      unsigned timeout;
-      std::string aor;
       Opal::Sip::EndPoint & manager;
-      bool registering;
-      const PSafePtr<OpalPresentity> & presentity;
     };
   };
 };
@@ -115,8 +80,18 @@ namespace Opal {
 Opal::Sip::EndPoint::EndPoint (Opal::CallManager & _manager,
                                Ekiga::ServiceCore& core):
   SIPEndPoint (_manager),
+  subscribers_available (0, INT_MAX),
+  subscribers_quit (false),
   manager (_manager)
 {
+  subscriber_stats.dispatched = 0;
+  subscriber_stats.coalesced = 0;
+  subscriber_stats.queue_length = 0;
+  subscriber_stats.max_queue_length = 0;
+  subscriber_stats.registered = 0;
+  subscriber_stats.total_latency = 0;
+  subscriber_stats.max_latency = 0;
+
   boost::shared_ptr<Ekiga::ChatCore> chat_core = core.get<Ekiga::ChatCore> ("chat-core");
 
   protocol_name = "sip";
@@ -147,11 +122,32 @@ Opal::Sip::EndPoint::EndPoint (Opal::CallManager & _manager,
 
   /* NAT Binding */
   SetNATBindingRefreshMethod (SIPEndPoint::Options);
+
+  /* The threads running the registrations, waiting for tasks */
+  while (subscribers.size () < SUBSCRIBER_THREADS)
+    subscribers.push_back (new subscriber (*this));
 }
 
 
 Opal::Sip::EndPoint::~EndPoint ()
 {
+  {
+    PWaitAndSignal m(subscribers_mutex);
+    subscribers_quit = true;
+  }
+
+  for (std::vector<PThread *>::iterator iter = subscribers.begin ();
+       iter != subscribers.end ();
+       ++iter)
+    subscribers_available.Signal ();
+
+  for (std::vector<PThread *>::iterator iter = subscribers.begin ();
+       iter != subscribers.end ();
+       ++iter) {
+
+    (*iter)->WaitForTermination ();
+    delete *iter;
+  }
 }
 
 bool
@@ -367,17 +363,7 @@ Opal::Sip::EndPoint::subscribe (const Opal::Account & account,
   if (account.get_protocol_name () != "SIP")
     return false;
 
-  new subscriber (account.get_username (),
-		  account.get_host (),
-		  account.get_authentication_username (),
-		  account.get_password (),
-		  account.is_enabled (),
-		  account.get_compat_mode (),
-		  account.get_timeout (),
-		  account.get_aor (),
-		  *this,
-                  true,
-                  presentity);
+  push_subscriber_task (account, true, presentity);
   return true;
 }
 
@@ -389,17 +375,152 @@ Opal::Sip::EndPoint::unsubscribe (const Opal::Account & account,
   if (account.get_protocol_name () != "SIP")
     return false;
 
-  new subscriber (account.get_username (),
-		  account.get_host (),
-		  account.get_authentication_username (),
-		  account.get_password (),
-		  account.is_enabled (),
-		  account.get_compat_mode (),
-		  account.get_timeout (),
-		  account.get_aor (),
-		  *this,
-                  false,
-                  presentity);
+  push_subscriber_task (account, false, presentity);
+  return true;
+}
+
+
+void
+Opal::Sip::EndPoint::get_subscriber_statistics (SubscriberStatistics & stats)
+{
+  PWaitAndSignal m(subscribers_mutex);
+
+  stats = subscriber_stats;
+  stats.queue_length = 0;
+  for (std::map<std::string, std::list<SubscriberTask> >::const_iterator iter = subscriber_tasks.begin ();
+       iter != subscriber_tasks.end ();
+       ++iter)
+    stats.queue_length += iter->second.size ();
+}
+
+
+void
+Opal::Sip::EndPoint::push_subscriber_task (const Opal::Account & account,
+                                           bool registering,
+                                           const PSafePtr<OpalPresentity> & presentity)
+{
+  PWaitAndSignal m(subscribers_mutex);
+
+  SubscriberTask task;
+  task.username = account.get_username ();
+  task.host = account.get_host ();
+  task.authentication_username = account.get_authentication_username ();
+  task.password = account.get_password ();
+  task.is_enabled = account.is_enabled ();
+  task.compat_mode = account.get_compat_mode ();
+  task.timeout = account.get_timeout ();
+  task.aor = account.get_aor ();
+  task.registering = registering;
+  task.presentity = presentity;
+  task.queued = PTimer::Tick ();
+
+  std::list<SubscriberTask> & tasks = subscriber_tasks[task.aor];
+  unsigned queue_length = 0;
+
+  /* The registrations waiting after the last unregistration are superseded
+   * by a new one, and a new unregistration makes them pointless ; but an
+   * unregistration is never dropped for a later registration, since the
+   * new one may not be to the same registrar
+   */
+  while (!tasks.empty () && tasks.back ().registering) {
+
+    tasks.pop_back ();
+    subscriber_stats.coalesced++;
+  }
+
+  if (!registering && !tasks.empty ()) {
+
+    /* the last waiting task is an unregistration already */
+    subscriber_stats.coalesced++;
+  }
+  else
+    tasks.push_back (task);
+
+  /* if a task for that AOR is running, it will take care of the others */
+  if (subscribers_busy.find (task.aor) == subscribers_busy.end ()
+      && std::find (subscribers_ready.begin (), subscribers_ready.end (), task.aor) == subscribers_ready.end ()) {
+
+    subscribers_ready.push_back (task.aor);
+    subscribers_available.Signal ();
+  }
+
+  for (std::map<std::string, std::list<SubscriberTask> >::const_iterator iter = subscriber_tasks.begin ();
+       iter != subscriber_tasks.end ();
+       ++iter)
+    queue_length += iter->second.size ();
+  subscriber_stats.max_queue_length = std::max (subscriber_stats.max_queue_length, queue_length);
+}
+
+
+bool
+Opal::Sip::EndPoint::run_subscriber_task ()
+{
+  SubscriberTask task;
+
+  subscribers_available.Wait ();
+
+  {
+    PWaitAndSignal m(subscribers_mutex);
+
+    if (subscribers_quit)
+      return false;
+
+    if (subscribers_ready.empty ())
+      return true;
+
+    std::string aor = subscribers_ready.front ();
+    subscribers_ready.pop_front ();
+
+    std::map<std::string, std::list<SubscriberTask> >::iterator iter = subscriber_tasks.find (aor);
+    if (iter == subscriber_tasks.end () || iter->second.empty ()) {
+
+      subscriber_tasks.erase (aor);
+      return true;
+    }
+
+    task = iter->second.front ();
+    iter->second.pop_front ();
+    subscribers_busy.insert (aor);
+  }
+
+  if (task.registering) {
+
+    if (task.presentity && !task.presentity->IsOpen ())
+      task.presentity->Open ();
+
+    Register (task.username, task.host, task.authentication_username, task.password,
+              task.is_enabled, task.compat_mode, task.timeout, task.queued);
+  }
+  else {
+
+    /* nothing was registered (or its registration was coalesced away) :
+     * the account still waits to hear it is unregistered */
+    if (!Unregister (task.aor))
+      Ekiga::Runtime::run_in_main (boost::bind (boost::ref (registration_event), task.aor, Account::Unregistered, std::string ()));
+
+    if (task.presentity && task.presentity->IsOpen ())
+      task.presentity->Close ();
+  }
+
+  {
+    PWaitAndSignal m(subscribers_mutex);
+
+    subscribers_busy.erase (task.aor);
+    subscriber_stats.dispatched++;
+
+    std::map<std::string, std::list<SubscriberTask> >::iterator iter = subscriber_tasks.find (task.aor);
+    if (iter != subscriber_tasks.end ()) {
+
+      if (iter->second.empty ())
+        subscriber_tasks.erase (iter);
+      else {
+
+        subscribers_ready.push_back (task.aor);
+        subscribers_available.Signal ();
+      }
+    }
+  }
+
   return true;
 }
 
@@ -411,7 +532,8 @@ Opal::Sip::EndPoint::Register (const std::string username,
 			       const std::string password,
 			       bool is_enabled,
 			       SIPRegister::CompatibilityModes compat_mode,
-			       unsigned timeout)
+			       unsigned timeout,
+			       PTimeInterval queued)
 {
   PString _aor;
   std::stringstream aor;
@@ -435,6 +557,17 @@ Opal::Sip::EndPoint::Register (const std::string username,
   params.m_minRetryTime = PMaxTimeInterval;  // use default value
   params.m_maxRetryTime = PMaxTimeInterval;  // use default value
 
+  /* keyed by the AOR as OnRegistrationStatus gets it back, without the
+   * port of the registrar */
+  {
+    PWaitAndSignal m(subscribers_mutex);
+    std::string started = aor.str ();
+
+    if (started.find (uri_prefix) == std::string::npos)
+      started = uri_prefix + started;
+    registrations_started[started] = queued;
+  }
+
   // Register the given aor to the give registrar
   if (!SIPEndPoint::Register (params, _aor)) {
     SIPEndPoint::RegistrationStatus status;
@@ -465,6 +598,28 @@ Opal::Sip::EndPoint::OnRegistrationStatus (const RegistrationStatus & status)
 
   SIPEndPoint::OnRegistrationStatus (status);
 
+  /* How long it took since the registration was asked */
+  if (status.m_wasRegistering && !status.m_reRegistering) {
+
+    PWaitAndSignal m(subscribers_mutex);
+    std::map<std::string, PTimeInterval>::iterator iter = registrations_started.find (strm.str ());
+
+    if (iter != registrations_started.end ()) {
+
+      PInt64 latency = (PTimer::Tick () - iter->second).GetMilliSeconds ();
+
+      if (status.m_reason == SIP_PDU::Successful_OK) {
+
+        subscriber_stats.registered++;
+        subscriber_stats.total_latency += latency;
+        subscriber_stats.max_latency = std::max (subscriber_stats.max_latency, (unsigned long) latency);
+      }
+      registrations_started.erase (iter);
+
+      PTRACE (4, "Ekiga\tRegistration of " << strm.str () << " answered " << status.m_reason << " in " << latency << " ms");
+    }
+  }
+
   /* Successful registration or unregistration */
   if (status.m_reason == SIP_PDU::Successful_OK) {
 
@@ -125,6 +125,28 @@ namespace Opal {
       bool subscribe (const Opal::Account & account, const PSafePtr<OpalPresentity> & presentity);
       bool unsubscribe (const Opal::Account & account, const PSafePtr<OpalPresentity> & presentity);
 
+      /* Statistics about the registrations : they are run by a few threads,
+       * one at a time and in order for a given AOR, and the operations
+       * superseded by a newer one while waiting are dropped ; the latency
+       * of the successful registrations is measured from the request to
+       * the answer, in ms
+       */
+      struct SubscriberStatistics
+      {
+        unsigned long dispatched;      // operations run so far
+        unsigned long coalesced;       // operations dropped while waiting
+        unsigned int queue_length;     // operations waiting right now
+        unsigned int max_queue_length; // highest number of operations waiting at once
+        unsigned long registered;      // registrations which succeeded
+        unsigned long total_latency;
+        unsigned long max_latency;
+      };
+
+      void get_subscriber_statistics (SubscriberStatistics & stats);
+
+      /* Runs the next registration task ; for the subscriber threads */
+      bool run_subscriber_task ();
+
 
       /* Helpers */
       static std::string get_aor_domain (const std::string & aor);
@@ -138,7 +160,8 @@ namespace Opal {
 		     const std::string password,
 		     bool is_enabled,
 		     SIPRegister::CompatibilityModes compat_mode,
-		     unsigned timeout);
+		     unsigned timeout,
+		     PTimeInterval queued);
 
       void OnRegistrationStatus (const RegistrationStatus & status);
 
@@ -180,6 +203,37 @@ namespace Opal {
       PMutex aorMutex;
       std::map<std::string, std::string> accounts;
 
+      struct SubscriberTask
+      {
+        std::string username;
+        std::string host;
+        std::string authentication_username;
+        std::string password;
+        bool is_enabled;
+        SIPRegister::CompatibilityModes compat_mode;
+        unsigned timeout;
+        std::string aor;
+        bool registering;
+        PSafePtr<OpalPresentity> presentity;
+        PTimeInterval queued;
+      };
+
+      void push_subscriber_task (const Opal::Account & account,
+                                 bool registering,
+                                 const PSafePtr<OpalPresentity> & presentity);
+
+      /* The waiting tasks by AOR, the AORs which have some and no running
+       * one, and those which have a running one */
+      PMutex subscribers_mutex;
+      PSemaphore subscribers_available;
+      bool subscribers_quit;
+      std::vector<PThread *> subscribers;
+      std::map<std::string, std::list<SubscriberTask> > subscriber_tasks;
+      std::list<std::string> subscribers_ready;
+      std::set<std::string> subscribers_busy;
+      std::map<std::string, PTimeInterval> registrations_started;
+      SubscriberStatistics subscriber_stats;
+
       // this object is really managed by opal,
       // so the way it is handled here is correct
       CallManager & manager;
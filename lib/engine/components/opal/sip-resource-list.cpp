@@ -0,0 +1,432 @@
+
+/* Ekiga -- A VoIP and Video-Conferencing application
+ * Copyright (C) 2000-2009 Damien Sandras <dsandras@seconix.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ *
+ * Ekiga is licensed under the GPL license and as a special exception,
+ * you have permission to link or otherwise combine this program with the
+ * programs OPAL, OpenH323 and PWLIB, and distribute the combination,
+ * without applying the requirements of the GNU GPL to the OPAL, OpenH323
+ * and PWLIB programs, as long as you do follow the requirements of the
+ * GNU GPL for all the rest of the software thus combined.
+ */
+
+
+/*
+ *                         sip-resource-list.cpp  -  description
+ *                         ------------------------------------------
+ *   begin                : written in 2012
+ *   copyright            : (c) 2012 by Damien Sandras
+ *   description          : implementation of the parser of the NOTIFY
+ *                          requests of a resource list subscription
+ *
+ */
+
+#include <map>
+
+#include <glib.h>
+#include <libxml/parser.h>
+#include <libxml/tree.h>
+
+#include "sip-resource-list.h"
+
+/* a body part, with the headers we care about */
+struct BodyPart
+{
+  std::string type;
+  std::string id;
+  std::string contents;
+};
+
+static std::string
+trim (const std::string str)
+{
+  size_t begin = str.find_first_not_of (" \t\r\n");
+  size_t end = str.find_last_not_of (" \t\r\n");
+
+  if (begin == std::string::npos)
+    return "";
+
+  return str.substr (begin, end - begin + 1);
+}
+
+static std::string
+lower (const std::string str)
+{
+  gchar* down = g_ascii_strdown (str.c_str (), -1);
+  std::string result = down;
+
+  g_free (down);
+
+  return result;
+}
+
+/* the media type of a Content-Type, without its parameters */
+static std::string
+media_type (const std::string content_type)
+{
+  return lower (trim (content_type.substr (0, content_type.find (';'))));
+}
+
+/* the value of a parameter of a Content-Type, unquoted ; a quoted value
+ * (RFC 2045) may contain semicolons and escaped characters, which are
+ * skipped while looking for the next parameter */
+static std::string
+media_parameter (const std::string content_type,
+		 const std::string name)
+{
+  const size_t length = content_type.length ();
+  size_t pos = content_type.find (';');
+
+  while (pos != std::string::npos) {
+
+    size_t equal = content_type.find_first_of ("=;", pos + 1);
+    std::string value;
+
+    if (equal == std::string::npos)
+      return "";
+
+    /* a parameter without a value */
+    if (content_type[equal] == ';') {
+
+      pos = equal;
+      continue;
+    }
+
+    std::string param = lower (trim (content_type.substr (pos + 1, equal - pos - 1)));
+
+    pos = content_type.find_first_not_of (" \t", equal + 1);
+    if (pos != std::string::npos && content_type[pos] == '"') {
+
+      for (pos++ ; pos < length && content_type[pos] != '"' ; pos++) {
+
+	if (content_type[pos] == '\\' && pos + 1 < length)
+	  pos++;
+	value += content_type[pos];
+      }
+
+      /* an unterminated quoted value */
+      if (pos >= length)
+	return "";
+
+      pos = content_type.find (';', pos + 1);
+    }
+    else if (pos != std::string::npos) {
+
+      size_t next = content_type.find (';', pos);
+      value = trim (content_type.substr (pos, next == std::string::npos ? std::string::npos : next - pos));
+      pos = next;
+    }
+
+    if (param == name)
+      return value;
+  }
+
+  return "";
+}
+
+static BodyPart
+parse_part (const std::string part)
+{
+  BodyPart result;
+  size_t pos = 0;
+
+  /* the headers, up to the first empty line */
+  while (pos < part.length ()) {
+
+    size_t eol = part.find ('\n', pos);
+    std::string line = part.substr (pos, eol == std::string::npos ? std::string::npos : eol - pos);
+
+    pos = (eol == std::string::npos) ? part.length () : eol + 1;
+
+    line = trim (line);
+    if (line.empty ())
+      break;
+
+    size_t colon = line.find (':');
+    if (colon == std::string::npos)
+      continue;
+
+    std::string name = lower (trim (line.substr (0, colon)));
+    std::string value = trim (line.substr (colon + 1));
+
+    if (name == "content-type")
+      result.type = value;
+    else if (name == "content-id") {
+
+      if (value.length () >= 2 && value[0] == '<' && value[value.length () - 1] == '>')
+	value = value.substr (1, value.length () - 2);
+      result.id = value;
+    }
+  }
+
+  result.contents = part.substr (pos);
+
+  return result;
+}
+
+/* splits a multipart body (RFC 2046) into its parts */
+static bool
+split_multipart (const std::string body,
+		 const std::string boundary,
+		 std::list<BodyPart> & parts)
+{
+  const std::string delimiter = "--" + boundary;
+  size_t pos = 0;
+
+  if (boundary.empty ())
+    return false;
+
+  /* the preamble, if any, ends with a line break */
+  if (body.compare (0, delimiter.length (), delimiter) != 0) {
+
+    pos = body.find ("\n" + delimiter);
+    if (pos == std::string::npos)
+      return false;
+    pos++;
+  }
+
+  while (true) {
+
+    pos += delimiter.length ();
+
+    /* the closing delimiter */
+    if (body.compare (pos, 2, "--") == 0)
+      return true;
+
+    pos = body.find ('\n', pos);
+    if (pos == std::string::npos)
+      return false;
+    pos++;
+
+    size_t end = body.find ("\n" + delimiter, pos);
+    if (end == std::string::npos)
+      return false;
+
+    /* the line break before a delimiter belongs to the delimiter */
+    size_t length = end - pos;
+    if (length > 0 && body[pos + length - 1] == '\r')
+      length--;
+
+    parts.push_back (parse_part (body.substr (pos, length)));
+
+    pos = end + 1;
+  }
+}
+
+static std::string
+get_property (xmlNodePtr node,
+	      const char* name)
+{
+  std::string result;
+  xmlChar* xml_str = xmlGetProp (node, BAD_CAST name);
+
+  if (xml_str != NULL) {
+
+    result = (const char*) xml_str;
+    xmlFree (xml_str);
+  }
+
+  return result;
+}
+
+static std::string
+get_content (xmlNodePtr node)
+{
+  std::string result;
+  xmlChar* xml_str = xmlNodeGetContent (node);
+
+  if (xml_str != NULL) {
+
+    result = trim ((const char*) xml_str);
+    xmlFree (xml_str);
+  }
+
+  return result;
+}
+
+static xmlNodePtr
+get_child (xmlNodePtr node,
+	   const char* name)
+{
+  for (xmlNodePtr child = node->children ;
+       child != NULL ;
+       child = child->next)
+    if (child->type == XML_ELEMENT_NODE
+	&& xmlStrEqual (BAD_CAST name, child->name))
+      return child;
+
+  return NULL;
+}
+
+static xmlDocPtr
+read_document (const std::string contents)
+{
+  return xmlReadMemory (contents.c_str (), contents.length (), NULL, NULL,
+			XML_PARSE_NONET | XML_PARSE_NOERROR | XML_PARSE_NOWARNING);
+}
+
+/* fills the presence of a resource from a PIDF document (RFC 3863) : the
+ * resource is open if any of its tuples is, and its note is the first one
+ * found in a tuple or else in the document */
+static void
+parse_pidf (const std::string contents,
+	    Opal::Sip::ResourceState & resource)
+{
+  xmlDocPtr doc = read_document (contents);
+  xmlNodePtr root = NULL;
+  std::string presence_note;
+
+  if (doc == NULL)
+    return;
+
+  root = xmlDocGetRootElement (doc);
+  if (root == NULL || !xmlStrEqual (BAD_CAST "presence", root->name)) {
+
+    xmlFreeDoc (doc);
+    return;
+  }
+
+  resource.has_presence = true;
+
+  for (xmlNodePtr child = root->children ;
+       child != NULL ;
+       child = child->next) {
+
+    if (child->type != XML_ELEMENT_NODE)
+      continue;
+
+    if (xmlStrEqual (BAD_CAST "tuple", child->name)) {
+
+      xmlNodePtr status = get_child (child, "status");
+      xmlNodePtr basic = status ? get_child (status, "basic") : NULL;
+      xmlNodePtr note = get_child (child, "note");
+
+      if (basic && lower (get_content (basic)) == "open")
+	resource.open = true;
+      if (note && resource.note.empty ())
+	resource.note = get_content (note);
+    }
+    else if (xmlStrEqual (BAD_CAST "note", child->name)
+	     && presence_note.empty ())
+      presence_note = get_content (child);
+  }
+
+  if (resource.note.empty ())
+    resource.note = presence_note;
+
+  xmlFreeDoc (doc);
+}
+
+bool
+Opal::Sip::parse_resource_list (const std::string content_type,
+				const std::string body,
+				bool & full_state,
+				std::list<ResourceState> & resources)
+{
+  std::list<BodyPart> parts;
+  std::map<std::string, const BodyPart*> parts_by_id;
+  const BodyPart* rlmi = NULL;
+  xmlDocPtr doc = NULL;
+  xmlNodePtr root = NULL;
+
+  if (media_type (content_type) != "multipart/related")
+    return false;
+
+  if (!split_multipart (body, media_parameter (content_type, "boundary"), parts))
+    return false;
+
+  for (std::list<BodyPart>::const_iterator iter = parts.begin ();
+       iter != parts.end ();
+       ++iter) {
+
+    if (media_type (iter->type) == "application/rlmi+xml" && rlmi == NULL)
+      rlmi = &*iter;
+    else if (!iter->id.empty ())
+      parts_by_id[iter->id] = &*iter;
+  }
+
+  if (rlmi == NULL)
+    return false;
+
+  doc = read_document (rlmi->contents);
+  if (doc == NULL)
+    return false;
+
+  root = xmlDocGetRootElement (doc);
+  if (root == NULL || !xmlStrEqual (BAD_CAST "list", root->name)) {
+
+    xmlFreeDoc (doc);
+    return false;
+  }
+
+  std::string full = get_property (root, "fullState");
+  full_state = (full == "true" || full == "1");
+
+  for (xmlNodePtr child = root->children ;
+       child != NULL ;
+       child = child->next) {
+
+    if (child->type != XML_ELEMENT_NODE
+	|| !xmlStrEqual (BAD_CAST "resource", child->name))
+      continue;
+
+    ResourceState resource;
+    std::string cid;
+
+    resource.uri = get_property (child, "uri");
+    if (resource.uri.empty ())
+      continue;
+
+    /* a resource may have several instances : the active one with a
+     * document wins */
+    for (xmlNodePtr instance = child->children ;
+	 instance != NULL ;
+	 instance = instance->next) {
+
+      if (instance->type != XML_ELEMENT_NODE
+	  || !xmlStrEqual (BAD_CAST "instance", instance->name))
+	continue;
+
+      std::string state = get_property (instance, "state");
+      std::string instance_cid = get_property (instance, "cid");
+
+      if (resource.state.empty () || (cid.empty () && !instance_cid.empty ())) {
+
+	resource.state = state;
+	cid = instance_cid;
+      }
+    }
+
+    if (!cid.empty ()) {
+
+      std::map<std::string, const BodyPart*>::const_iterator part = parts_by_id.find (cid);
+
+      /* the resources which are lists themselves come as a nested
+       * multipart, which isn't supported */
+      if (part != parts_by_id.end ()
+	  && media_type (part->second->type) == "application/pidf+xml")
+	parse_pidf (part->second->contents, resource);
+    }
+
+    resources.push_back (resource);
+  }
+
+  xmlFreeDoc (doc);
+
+  return true;
+}
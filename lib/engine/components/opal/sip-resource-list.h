@@ -0,0 +1,88 @@
+
+/* Ekiga -- A VoIP and Video-Conferencing application
+ * Copyright (C) 2000-2009 Damien Sandras <dsandras@seconix.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ *
+ * Ekiga is licensed under the GPL license and as a special exception,
+ * you have permission to link or otherwise combine this program with the
+ * programs OPAL, OpenH323 and PWLIB, and distribute the combination,
+ * without applying the requirements of the GNU GPL to the OPAL, OpenH323
+ * and PWLIB programs, as long as you do follow the requirements of the
+ * GNU GPL for all the rest of the software thus combined.
+ */
+
+
+/*
+ *                         sip-resource-list.h  -  description
+ *                         ------------------------------------------
+ *   begin                : written in 2012
+ *   copyright            : (c) 2012 by Damien Sandras
+ *   description          : declaration of the parser of the NOTIFY
+ *                          requests of a resource list subscription
+ *
+ */
+
+#ifndef __SIP_RESOURCE_LIST_H__
+#define __SIP_RESOURCE_LIST_H__
+
+#include <list>
+#include <string>
+
+namespace Opal
+{
+  namespace Sip
+  {
+    /**
+     * @addtogroup presence
+     * @internal
+     * @{
+     */
+
+    /* what a NOTIFY tells about one resource of the list */
+    struct ResourceState
+    {
+      ResourceState (): has_presence(false), open(false)
+      {}
+
+      std::string uri;
+      std::string state;   // "active", "pending", "terminated", or empty
+      bool has_presence;   // whether a PIDF document came with it
+      bool open;           // the PIDF basic status
+      std::string note;
+    };
+
+    /* Parses the body of a NOTIFY received for a resource list subscription
+     * (RFC 4662) : a multipart/related body whose root is an RLMI document,
+     * followed by a PIDF document for each resource with a known presence.
+     *
+     * full_state tells whether the resources are the whole list, or only
+     * those which changed since the last NOTIFY.
+     *
+     * Returns false if the body isn't a resource list.
+     */
+    bool parse_resource_list (const std::string content_type,
+			      const std::string body,
+			      bool & full_state,
+			      std::list<ResourceState> & resources);
+
+    /**
+     * @}
+     */
+  };
+};
+
+#endif
@@ -47,6 +47,7 @@
 GMAudioInputManager_ptlib::GMAudioInputManager_ptlib (Ekiga::ServiceCore & _core)
 : core (_core)
 {
+  already_detected_devices = false;
   current_state.opened = false;
   input_device = NULL;
   expectedFrameSize = 0;
@@ -57,6 +58,19 @@ GMAudioInputManager_ptlib::~GMAudioInputManager_ptlib ()
 }
 
 void GMAudioInputManager_ptlib::get_devices(std::vector <Ekiga::AudioInputDevice> & devices)
+{
+  if ( !already_detected_devices)
+    detect_devices ();
+
+  devices.insert (devices.end (), detected_devices.begin (), detected_devices.end ());
+}
+
+void GMAudioInputManager_ptlib::refresh_devices ()
+{
+  already_detected_devices = false;
+}
+
+void GMAudioInputManager_ptlib::detect_devices ()
 {
   PStringArray audio_sources;
   PStringArray audio_devices;
@@ -66,6 +80,9 @@ void GMAudioInputManager_ptlib::get_devices(std::vector <Ekiga::AudioInputDevice
   Ekiga::AudioInputDevice device;
   device.type   = DEVICE_TYPE;
 
+  already_detected_devices = true;
+  detected_devices.clear ();
+
   audio_sources = PSoundChannel::GetDriverNames ();
   sources_array = audio_sources.ToCharArray ();
   for (PINDEX i = 0; sources_array[i] != NULL; i++) {
@@ -86,7 +103,7 @@ void GMAudioInputManager_ptlib::get_devices(std::vector <Ekiga::AudioInputDevice
 #else
         device.name = devices_array[j];
 #endif
-        devices.push_back(device);
+        detected_devices.push_back(device);
       }
       free (devices_array);
     }
@@ -62,6 +62,8 @@
 
       virtual void get_devices(std::vector <Ekiga::AudioInputDevice> & devices);
 
+      virtual void refresh_devices ();
+
       virtual bool open (unsigned channels, unsigned samplerate, unsigned bits_per_sample);
 
       virtual void close();
@@ -83,6 +85,10 @@
       PSoundChannel *input_device;
 
     private:
+      bool already_detected_devices;
+      std::vector <Ekiga::AudioInputDevice> detected_devices;
+      void detect_devices ();
+
       void device_error_in_main (Ekiga::AudioInputDevice device,
 				 Ekiga::AudioInputErrorCodes code);
       void device_opened_in_main (Ekiga::AudioInputDevice device,
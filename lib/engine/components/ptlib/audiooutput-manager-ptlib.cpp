@@ -46,6 +46,7 @@
 GMAudioOutputManager_ptlib::GMAudioOutputManager_ptlib (Ekiga::ServiceCore & _core)
 : core (_core)
 {
+  already_detected_devices = false;
   current_state[Ekiga::primary].opened = false;
   current_state[Ekiga::secondary].opened = false;
   output_device[Ekiga::primary] = NULL;
@@ -57,6 +58,19 @@ GMAudioOutputManager_ptlib::~GMAudioOutputManager_ptlib ()
 }
 
 void GMAudioOutputManager_ptlib::get_devices(std::vector <Ekiga::AudioOutputDevice> & devices)
+{
+  if ( !already_detected_devices)
+    detect_devices ();
+
+  devices.insert (devices.end (), detected_devices.begin (), detected_devices.end ());
+}
+
+void GMAudioOutputManager_ptlib::refresh_devices ()
+{
+  already_detected_devices = false;
+}
+
+void GMAudioOutputManager_ptlib::detect_devices ()
 {
   PStringArray audio_sources;
   PStringArray audio_devices;
@@ -66,6 +80,9 @@ void GMAudioOutputManager_ptlib::get_devices(std::vector <Ekiga::AudioOutputDevi
   Ekiga::AudioOutputDevice device;
   device.type   = DEVICE_TYPE;
 
+  already_detected_devices = true;
+  detected_devices.clear ();
+
   audio_sources = PSoundChannel::GetDriverNames ();
   sources_array = audio_sources.ToCharArray ();
   for (PINDEX i = 0; sources_array[i] != NULL; i++) {
@@ -86,7 +103,7 @@ void GMAudioOutputManager_ptlib::get_devices(std::vector <Ekiga::AudioOutputDevi
 #else
         device.name = devices_array[j];
 #endif
-        devices.push_back(device);
+        detected_devices.push_back(device);
       }
       free (devices_array);
     }
@@ -60,6 +60,8 @@
 
       virtual void get_devices (std::vector <Ekiga::AudioOutputDevice> & devices);
 
+      virtual void refresh_devices ();
+
       virtual bool set_device (Ekiga::AudioOutputPS ps, const Ekiga::AudioOutputDevice & device);
 
       virtual bool open (Ekiga::AudioOutputPS ps, unsigned channels, unsigned samplerate, unsigned bits_per_sample);
@@ -83,6 +85,10 @@
       PSoundChannel *output_device[2];
 
     private:
+      bool already_detected_devices;
+      std::vector <Ekiga::AudioOutputDevice> detected_devices;
+      void detect_devices ();
+
       void device_opened_in_main (Ekiga::AudioOutputPS ps,
 				  Ekiga::AudioOutputDevice device,
 				  Ekiga::AudioOutputSettings settings);
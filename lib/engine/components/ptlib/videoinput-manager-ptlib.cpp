@@ -44,6 +44,7 @@
 
 GMVideoInputManager_ptlib::GMVideoInputManager_ptlib ()
 {
+  already_detected_devices = false;
   current_state.opened = false;
   input_device = NULL;
   expectedFrameSize = 0;
@@ -54,6 +55,19 @@ GMVideoInputManager_ptlib::~GMVideoInputManager_ptlib ()
 }
 
 void GMVideoInputManager_ptlib::get_devices(std::vector <Ekiga::VideoInputDevice> & devices)
+{
+  if ( !already_detected_devices)
+    detect_devices ();
+
+  devices.insert (devices.end (), detected_devices.begin (), detected_devices.end ());
+}
+
+void GMVideoInputManager_ptlib::refresh_devices ()
+{
+  already_detected_devices = false;
+}
+
+void GMVideoInputManager_ptlib::detect_devices ()
 {
   PStringArray video_sources;
   PStringArray video_devices;
@@ -63,6 +77,9 @@ void GMVideoInputManager_ptlib::get_devices(std::vector <Ekiga::VideoInputDevice
   Ekiga::VideoInputDevice device;
   device.type   = DEVICE_TYPE;
 
+  already_detected_devices = true;
+  detected_devices.clear ();
+
   video_sources = PVideoInputDevice::GetDriverNames ();
   sources_array = video_sources.ToCharArray ();
   for (PINDEX i = 0; sources_array[i] != NULL; i++) {
@@ -81,7 +98,7 @@ void GMVideoInputManager_ptlib::get_devices(std::vector <Ekiga::VideoInputDevice
       for (PINDEX j = 0; devices_array[j] != NULL; j++) {
         // ptlib returns device name in utf-8
         device.name = devices_array[j];
-        devices.push_back(device);
+        detected_devices.push_back(device);
       }
       free (devices_array);
     }
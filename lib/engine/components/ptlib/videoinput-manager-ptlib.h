@@ -59,6 +59,8 @@
 
       virtual void get_devices(std::vector <Ekiga::VideoInputDevice> & devices);
 
+      virtual void refresh_devices ();
+
       virtual bool set_device (const Ekiga::VideoInputDevice & device, int channel, Ekiga::VideoInputFormat format);
 
       virtual bool open (unsigned width, unsigned height, unsigned fps);
@@ -80,6 +82,10 @@
       PVideoInputDevice *input_device;
 
     private:
+      bool already_detected_devices;
+      std::vector <Ekiga::VideoInputDevice> detected_devices;
+      void detect_devices ();
+
       void device_opened_in_main (Ekiga::VideoInputDevice device,
 				  Ekiga::VideoInputSettings settings);
       void device_closed_in_main (Ekiga::VideoInputDevice device);
@@ -38,11 +38,41 @@
 #define KICKSTART_DEBUG 0
 
 #include <algorithm>
+#include <map>
+
+#include <glib.h>
 
 #if KICKSTART_DEBUG
 #include <iostream>
 #endif
 
+/* how long each spark spent in try_initialize_more, in seconds ; the
+ * engine gets them as debug messages once it is started */
+static std::map<std::string, double> timings;
+
+static void
+count_service (unsigned* counter,
+	       Ekiga::ServicePtr /*service*/)
+{
+  (*counter)++;
+}
+
+static bool
+try_spark (Ekiga::Spark& spark,
+	   Ekiga::ServiceCore& core,
+	   int* argc,
+	   char** argv[])
+{
+  GTimer* timer = g_timer_new ();
+
+  bool result = spark.try_initialize_more (core, argc, argv);
+
+  timings[spark.get_name ()] += g_timer_elapsed (timer, NULL);
+  g_timer_destroy (timer);
+
+  return result;
+}
+
 Ekiga::KickStart::KickStart ()
 {
 }
@@ -69,6 +99,18 @@ Ekiga::KickStart::~KickStart ()
   }
   std::cout << std::endl;
 #endif
+
+  std::multimap<double, std::string> slowest;
+  for (std::map<std::string, double>::const_iterator iter = timings.begin ();
+       iter != timings.end ();
+       ++iter)
+    slowest.insert (std::make_pair (iter->second, iter->first));
+
+  for (std::multimap<double, std::string>::reverse_iterator iter = slowest.rbegin ();
+       iter != slowest.rend ();
+       ++iter)
+    g_debug ("KickStart: %s initialized in %.1f ms",
+	     iter->second.c_str (), iter->first * 1000);
 }
 
 void
@@ -88,6 +130,14 @@ Ekiga::KickStart::kick (Ekiga::ServiceCore& core,
   std::list<std::string> disabled;
   bool went_on;
 
+  /* sparks wait for services : one which couldn't do more isn't tried again
+   * until a service was added since -- this maps it to the count of
+   * services added when it was last tried */
+  unsigned added = 0;
+  std::map<Spark*, unsigned> tried;
+  boost::signals2::scoped_connection conn
+    = core.service_added.connect (boost::bind (&count_service, &added, _1));
+
   for (int arg = 2; arg <= *argc; arg++) {
 
     std::string argument = (*argv)[arg - 1];
@@ -127,11 +177,17 @@ Ekiga::KickStart::kick (Ekiga::ServiceCore& core,
 	   ++iter) {
 
 	bool result = false;
-	if (std::find (disabled.begin (),
-		       disabled.end (), (*iter)->get_name ())
-	    == disabled.end ()) {
+	std::map<Spark*, unsigned>::iterator last = tried.find (iter->get ());
+
+	if (last != tried.end () && last->second == added) {
+
+	  // nothing new to work with
+	} else if (std::find (disabled.begin (),
+			      disabled.end (), (*iter)->get_name ())
+		   == disabled.end ()) {
 
-	  result = (*iter)->try_initialize_more (core, argc, argv);
+	  tried[iter->get ()] = added;
+	  result = try_spark (**iter, core, argc, argv);
 	} else {
 
 #if KICKSTART_DEBUG
@@ -143,6 +199,7 @@ Ekiga::KickStart::kick (Ekiga::ServiceCore& core,
 	if (result) {
 
 	  went_on = true;
+	  tried.erase (iter->get ());
 	  switch ((*iter)->get_state ()) {
 
 	  case Spark::BLANK:
@@ -204,11 +261,19 @@ Ekiga::KickStart::kick (Ekiga::ServiceCore& core,
 	   iter != temp.end ();
 	   ++iter) {
 
-	bool result = (*iter)->try_initialize_more (core, argc, argv);
+	bool result = false;
+	std::map<Spark*, unsigned>::iterator last = tried.find (iter->get ());
+
+	if (last == tried.end () || last->second != added) {
+
+	  tried[iter->get ()] = added;
+	  result = try_spark (**iter, core, argc, argv);
+	}
 
 	if (result) {
 
 	  went_on = true;
+	  tried.erase (iter->get ());
 	  switch ((*iter)->get_state ()) {
 
 	  case Spark::BLANK:
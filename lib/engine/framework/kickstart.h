@@ -92,7 +92,9 @@ namespace Ekiga
 
     void add_spark (boost::shared_ptr<Spark>& spark);
 
-    /* try to do more with the known blank/partial sparks */
+    /* try to do more with the known blank/partial sparks ; during a kick,
+     * a spark which couldn't do more is only tried again once a service
+     * was added to the core */
     void kick (Ekiga::ServiceCore& core,
 	       int* argc,
 	       char** argv[]);
@@ -56,6 +56,9 @@ namespace Ekiga
   {
   protected:
 
+    RefLister (): held(0), missed_update(false)
+    {}
+
     typedef std::map<boost::shared_ptr<ObjectType>, boost::shared_ptr<scoped_connections> > container_type;
     typedef Ekiga::map_key_iterator<container_type> iterator;
     typedef Ekiga::map_key_const_iterator<container_type> const_iterator;
@@ -71,6 +74,13 @@ namespace Ekiga
 
     void remove_all_objects ();
 
+    /* while updates are held, objects are still added, removed and updated
+     * one by one, but the lister's own updated signal is only emitted once
+     * they're released -- use it around batches of changes ; holds nest */
+    void hold_updates ();
+
+    void release_updates ();
+
     iterator begin ();
     iterator end ();
 
@@ -82,7 +92,14 @@ namespace Ekiga
     boost::signals2::signal<void(boost::shared_ptr<ObjectType>)> object_updated;
 
   private:
+
+    void on_object_updated (boost::shared_ptr<ObjectType> obj);
+
+    void emit_updated ();
+
     container_type objects;
+    unsigned held;
+    bool missed_update;
   };
 
 };
@@ -105,13 +122,12 @@ Ekiga::RefLister<ObjectType>::add_object (boost::shared_ptr<ObjectType> obj)
 {
   typename container_type::iterator iter = objects.find (obj);
   if (iter == objects.end ())
-    objects[obj] = boost::shared_ptr<scoped_connections> (new scoped_connections);
-  objects[obj]->add (obj->updated.connect (boost::bind (boost::ref (object_updated), obj)));
-  objects[obj]->add (obj->updated.connect (boost::ref (updated)));
-  objects[obj]->add (obj->removed.connect (boost::bind (&Ekiga::RefLister<ObjectType>::remove_object, this, obj)));
+    iter = objects.insert (std::make_pair (obj, boost::shared_ptr<scoped_connections> (new scoped_connections))).first;
+  iter->second->add (obj->updated.connect (boost::bind (&Ekiga::RefLister<ObjectType>::on_object_updated, this, obj)));
+  iter->second->add (obj->removed.connect (boost::bind (&Ekiga::RefLister<ObjectType>::remove_object, this, obj)));
 
   object_added (obj);
-  updated ();
+  emit_updated ();
 }
 
 template<typename ObjectType>
@@ -121,26 +137,73 @@ Ekiga::RefLister<ObjectType>::add_connection (boost::shared_ptr<ObjectType> obj,
 {
   typename container_type::iterator iter = objects.find (obj);
   if (iter == objects.end ())
-    objects[obj] = boost::shared_ptr<scoped_connections> (new scoped_connections);
-  objects[obj]->add (connection);
+    iter = objects.insert (std::make_pair (obj, boost::shared_ptr<scoped_connections> (new scoped_connections))).first;
+  iter->second->add (connection);
 }
 
 template<typename ObjectType>
 void
 Ekiga::RefLister<ObjectType>::remove_object (boost::shared_ptr<ObjectType> obj)
 {
-  objects.erase (objects.find (obj));
+  typename container_type::iterator iter = objects.find (obj);
+  if (iter == objects.end ())
+    return;
+
+  objects.erase (iter);
   object_removed (obj);
-  updated ();
+  emit_updated ();
 }
 
 template<typename ObjectType>
 void
 Ekiga::RefLister<ObjectType>::remove_all_objects ()
 {
+  hold_updates ();
+
   /* iterators get invalidated as we go, hence the strange loop */
   while ( !objects.empty ())
     remove_object (objects.begin ()->first);
+
+  release_updates ();
+}
+
+template<typename ObjectType>
+void
+Ekiga::RefLister<ObjectType>::hold_updates ()
+{
+  held++;
+}
+
+template<typename ObjectType>
+void
+Ekiga::RefLister<ObjectType>::release_updates ()
+{
+  if (held > 0)
+    held--;
+
+  if (held == 0 && missed_update) {
+
+    missed_update = false;
+    updated ();
+  }
+}
+
+template<typename ObjectType>
+void
+Ekiga::RefLister<ObjectType>::on_object_updated (boost::shared_ptr<ObjectType> obj)
+{
+  object_updated (obj);
+  emit_updated ();
+}
+
+template<typename ObjectType>
+void
+Ekiga::RefLister<ObjectType>::emit_updated ()
+{
+  if (held > 0)
+    missed_update = true;
+  else
+    updated ();
 }
 
 template<typename ObjectType>
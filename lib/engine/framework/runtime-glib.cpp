@@ -35,11 +35,32 @@
 
 #include "runtime.h"
 
+#include <map>
+#include <string>
+
 #include <glib.h>
 
 static GAsyncQueue* queue;
 static GMainLoop* loop;
 
+/* how long the main loop may spend running queued actions before it
+ * gives a chance to the other sources (redraws, input) to run */
+#define DISPATCH_TIME_SLICE 0.010
+
+/* measures the latencies ; it is only read, so it can be used from any thread */
+static GTimer* latency_timer;
+
+/* only used from the main thread */
+static unsigned long dispatched;
+static unsigned int max_queue_length;
+static double total_latency;
+static double max_latency;
+
+/* the keyed messages still in the queue, protected by the queue lock */
+typedef std::map<std::string, struct message*> pending_map;
+static pending_map pending;
+static unsigned long coalesced;
+
 /* implementation of the helper functions
  *
  */
@@ -47,12 +68,18 @@ static GMainLoop* loop;
 struct message
 {
   message (boost::function0<void> _action,
-	   unsigned int _seconds): action(_action),
-				   seconds(_seconds)
+	   unsigned int _seconds,
+	   double _queued): action(_action),
+			    seconds(_seconds),
+			    queued(_queued),
+			    superseded(false)
   {}
 
   boost::function0<void> action;
   unsigned int seconds;
+  double queued;
+  std::string key;  // empty if the message can't be coalesced
+  bool superseded;  // a newer message with the same key was queued
 };
 
 static void
@@ -92,7 +119,8 @@ static gboolean
 prepare (GSource *source,
 	 gint *timeout)
 {
-  *timeout = 100;
+  /* no need to poll : run_in_main wakes the main context up */
+  *timeout = -1;
 
   return check (source);
 }
@@ -104,14 +132,53 @@ dispatch (GSource *source,
 {
   struct source *src = (struct source *)source;
   struct message *msg = NULL;
+  double start = g_timer_elapsed (latency_timer, NULL);
+  double now = start;
+  gint length = g_async_queue_length (src->queue);
+
+  if (length > 0 && (unsigned int)length > max_queue_length)
+    max_queue_length = length;
+
+  /* drain the queue, but don't starve the rest of the main loop : what
+   * is left will be run at the next iteration */
+  while (now - start < DISPATCH_TIME_SLICE
+	 && (msg = (struct message *)g_async_queue_try_pop (src->queue)) != NULL) {
+
+    if (!msg->key.empty ()) {
 
-  msg = (struct message *)g_async_queue_pop (src->queue);
+      bool superseded;
+
+      g_async_queue_lock (src->queue);
+      superseded = msg->superseded;
+      if (!superseded)
+	pending.erase (msg->key);
+      g_async_queue_unlock (src->queue);
+
+      if (superseded) {
+
+	free_message (msg);
+	continue;
+      }
+    }
+
+    double latency = now - msg->queued;
+    if (latency > 0) {
+
+      total_latency += latency;
+      if (latency > max_latency)
+	max_latency = latency;
+    }
+    dispatched++;
+
+    if (msg->seconds == 0)
+      (void)run_later_or_back_in_main_helper ((gpointer)msg);
+    else
+      g_timeout_add_seconds (msg->seconds,
+			     run_later_or_back_in_main_helper, (gpointer)msg);
+
+    now = g_timer_elapsed (latency_timer, NULL);
+  }
 
-  if (msg->seconds == 0)
-    (void)run_later_or_back_in_main_helper ((gpointer)msg);
-  else
-    g_timeout_add_seconds (msg->seconds,
-			   run_later_or_back_in_main_helper, (gpointer)msg);
   return TRUE;
 }
 
@@ -135,6 +202,8 @@ static GSourceFuncs source_funcs = {
 void
 Ekiga::Runtime::init ()
 {
+  latency_timer = g_timer_new ();
+
   // here we get a ref to the queue, which we'll release in quit
   queue = g_async_queue_new_full ((GDestroyNotify)free_message);
 
@@ -167,6 +236,56 @@ void
 Ekiga::Runtime::run_in_main (boost::function0<void> action,
 			     unsigned int seconds)
 {
-  if (queue != NULL)
-    g_async_queue_push (queue, (gpointer)(new struct message (action, seconds)));
+  if (queue != NULL) {
+
+    g_async_queue_push (queue,
+			(gpointer)(new struct message (action, seconds,
+						       g_timer_elapsed (latency_timer, NULL))));
+    g_main_context_wakeup (g_main_context_default ());
+  }
+}
+
+void
+Ekiga::Runtime::run_in_main (const std::string & key,
+			     boost::function0<void> action)
+{
+  if (queue != NULL) {
+
+    struct message* msg = new struct message (action, 0,
+					      g_timer_elapsed (latency_timer, NULL));
+    msg->key = key;
+
+    g_async_queue_lock (queue);
+
+    /* the older message stays in the queue but won't run : this way the
+     * newest action keeps its place with respect to the other messages */
+    pending_map::iterator iter = pending.find (key);
+    if (iter != pending.end ()) {
+
+      iter->second->superseded = true;
+      iter->second->action.clear ();
+      coalesced++;
+    }
+    pending[key] = msg;
+
+    g_async_queue_push_unlocked (queue, (gpointer)msg);
+    g_async_queue_unlock (queue);
+
+    g_main_context_wakeup (g_main_context_default ());
+  }
+}
+
+void
+Ekiga::Runtime::get_statistics (Statistics & stats)
+{
+  stats.dispatched = dispatched;
+  stats.coalesced = coalesced;
+  stats.queue_length = 0;
+  if (queue != NULL && g_async_queue_length (queue) > 0)
+    stats.queue_length = g_async_queue_length (queue);
+  stats.max_queue_length = max_queue_length;
+  stats.mean_latency = 0;
+  if (dispatched > 0)
+    stats.mean_latency = (unsigned long)(total_latency * 1000000 / dispatched);
+  stats.max_latency = (unsigned long)(max_latency * 1000000);
 }
@@ -36,6 +36,7 @@
 
 #include <boost/signals2.hpp>
 #include <boost/bind.hpp>
+#include <string>
 
 #ifndef __RUNTIME_H__
 #define __RUNTIME_H__
@@ -60,6 +61,29 @@ namespace Ekiga
 
     void run_in_main (boost::function0<void> action,
 		      unsigned int seconds = 0); // depends on the implementation
+
+    /* Same as above, but when several actions with the same key are
+     * waiting to be run, only the newest one is ; this is meant for
+     * updates superseding each other, like a presence or size change
+     */
+    void run_in_main (const std::string & key,
+		      boost::function0<void> action); // depends on the implementation
+
+    /* Statistics about the actions run through run_in_main ; the
+     * latencies are measured from the call to run_in_main to the start
+     * of the action (for delayed actions, to the start of the delay)
+     */
+    struct Statistics
+    {
+      unsigned long dispatched;      // actions run so far
+      unsigned long coalesced;       // keyed actions superseded by a newer one
+      unsigned int queue_length;     // actions waiting right now
+      unsigned int max_queue_length; // highest number of actions waiting at once
+      unsigned long mean_latency;    // in microseconds
+      unsigned long max_latency;     // in microseconds
+    };
+
+    void get_statistics (Statistics & stats); // depends on the implementation
   };
 
   /**
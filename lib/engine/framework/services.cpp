@@ -86,10 +86,21 @@ Ekiga::ServiceCore::~ServiceCore ()
   /* this frees the memory, if we're the only to hold references,
    * and frees the last first -- so there's no problem
    */
+  services_index.clear ();
   while ( !services.empty ())
     services.pop_front ();
 
 #if DEBUG
+  for (std::map<std::string, unsigned>::const_iterator iter = lookups.begin ();
+       iter != lookups.end ();
+       ++iter)
+    std::cout << "Ekiga::ServiceCore: "
+	      << iter->first
+	      << " was asked for "
+	      << iter->second
+	      << " times"
+	      << std::endl;
+
   for (std::map<std::string, boost::weak_ptr<Service> >::iterator iter = remaining_services.begin();
        iter != remaining_services.end ();
        ++iter) {
@@ -114,8 +125,12 @@ Ekiga::ServiceCore::add (ServicePtr service)
 {
   bool result = false;
 
-  if ( !get (service->get_name ())) {
+  if (services_index.insert (std::make_pair (service->get_name (), service)).second) {
+
     services.push_front (service);
+#if DEBUG
+    lookups[service->get_name ()] = 0;
+#endif
     service_added (service);
     result = true;
   } else {
@@ -142,18 +157,17 @@ Ekiga::ServicePtr
 Ekiga::ServiceCore::get (const std::string name)
 {
   ServicePtr result;
+  services_index_type::const_iterator iter = services_index.find (name);
 
-  for (services_type::iterator iter = services.begin ();
-       iter != services.end () && !result;
-       iter++)
-    if (name == (*iter)->get_name ()) {
-
-      result = *iter;
-    }
-
+  if (iter != services_index.end ())
+    result = iter->second;
 
 #if DEBUG
 
+  /* the counters are made by add, so that this doesn't change the map */
+  if (result)
+    lookups.find (name)->second++;
+
   if (result)
     if (closed)
       std::cout << "Ekiga::ServiceCore refuses to return " << name << std::endl;
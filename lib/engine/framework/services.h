@@ -44,6 +44,7 @@
 #include <boost/optional.hpp>
 
 #include <list>
+#include <map>
 #include <string>
 #include <boost/signals2.hpp>
 #include <boost/bind.hpp>
@@ -109,9 +110,18 @@ namespace Ekiga
 
     bool closed;
 
+    /* the list keeps the order of addition, which is the reverse order of
+     * destruction ; the map is what lookups use */
     typedef std::list<ServicePtr> services_type;
     services_type services;
 
+    typedef std::map<std::string, ServicePtr> services_index_type;
+    services_index_type services_index;
+
+    /* how many times each service was asked for, only counted when DEBUG
+     * is set in services.cpp ; get is called from several threads and the
+     * counts aren't locked, so they are only approximate */
+    std::map<std::string, unsigned> lookups;
   };
 
   typedef boost::shared_ptr<ServiceCore> ServiceCorePtr;
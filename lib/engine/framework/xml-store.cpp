@@ -0,0 +1,263 @@
+/*
+ * Ekiga -- A VoIP and Video-Conferencing application
+ * Copyright (C) 2000-2009 Damien Sandras <dsandras@seconix.com>
+
+ * This program is free software; you can  redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version. This program is distributed in the hope
+ * that it will be useful, but WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Ekiga is licensed under the GPL license and as a special exception, you
+ * have permission to link or otherwise combine this program with the
+ * programs OPAL, OpenH323 and PWLIB, and distribute the combination, without
+ * applying the requirements of the GNU GPL to the OPAL, OpenH323 and PWLIB
+ * programs, as long as you do follow the requirements of the GNU GPL for all
+ * the rest of the software thus combined.
+ */
+
+
+/*
+ *                         xml-store.cpp  -  description
+ *                         ------------------------------------------
+ *   begin                : written in 2012
+ *   copyright            : (c) 2012 by Damien Sandras
+ *   description          : implementation of a file-backed XML document,
+ *                          written back some time after it changed
+ *
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <glib/gstdio.h>
+#include <libxml/parser.h>
+
+#include "xml-store.h"
+#include "gmconf.h"
+
+/* how long changes are gathered before being written */
+#define XML_STORE_DELAY 2
+
+/* the serialized form of a node, as a line of the file */
+static std::string
+dump_node (xmlDocPtr doc,
+	   xmlNodePtr node)
+{
+  std::string result;
+  xmlBufferPtr buffer = xmlBufferCreate ();
+
+  if (xmlNodeDump (buffer, doc, node, 0, 0) >= 0)
+    result = (const char*) xmlBufferContent (buffer);
+  xmlBufferFree (buffer);
+
+  return result + "\n";
+}
+
+
+Ekiga::XmlStore::XmlStore (const std::string file_name,
+			   const std::string root_name_,
+			   const std::string legacy_key_):
+  root_name(root_name_), legacy_key(legacy_key_),
+  dirty(false), migrated(false), stale(0), timeout(0)
+{
+  gchar *filename = g_build_filename (g_get_user_config_dir (),
+				      "ekiga", file_name.c_str (), NULL);
+
+  path = filename;
+
+  g_free (filename);
+}
+
+Ekiga::XmlStore::~XmlStore ()
+{
+  flush ();
+}
+
+boost::shared_ptr<xmlDoc>
+Ekiga::XmlStore::load ()
+{
+  gchar *contents = NULL;
+  gsize length = 0;
+
+  if (g_file_get_contents (path.c_str (), &contents, &length, NULL)) {
+
+    /* each node ends a line : what follows the last line break is a node
+     * which couldn't be written completely */
+    while (length > 0 && contents[length - 1] != '\n')
+      length--;
+
+    std::string raw = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<" + root_name + ">\n";
+    raw.append (contents, length);
+    raw += "</" + root_name + ">\n";
+    g_free (contents);
+
+    doc = boost::shared_ptr<xmlDoc> (xmlRecoverMemory (raw.c_str (), raw.length ()), xmlFreeDoc);
+    if ( !doc)
+      doc = boost::shared_ptr<xmlDoc> (xmlNewDoc (BAD_CAST "1.0"), xmlFreeDoc);
+  }
+  else {
+
+    gchar *c_raw = gm_conf_get_string (legacy_key.c_str ());
+
+    if (c_raw != NULL && c_raw[0] != '\0') {
+
+      doc = boost::shared_ptr<xmlDoc> (xmlRecoverMemory (c_raw, strlen (c_raw)), xmlFreeDoc);
+      if ( !doc)
+	doc = boost::shared_ptr<xmlDoc> (xmlNewDoc (BAD_CAST "1.0"), xmlFreeDoc);
+
+      migrated = true;
+      save ();
+    }
+    g_free (c_raw);
+  }
+
+  return doc;
+}
+
+void
+Ekiga::XmlStore::reset (boost::shared_ptr<xmlDoc> new_doc)
+{
+  doc = new_doc;
+  save ();
+}
+
+void
+Ekiga::XmlStore::save ()
+{
+  dirty = true;
+  appended.clear ();
+  schedule ();
+}
+
+void
+Ekiga::XmlStore::append (xmlNodePtr node)
+{
+  /* the whole file will be written anyway */
+  if (dirty)
+    return;
+
+  appended += dump_node (doc.get (), node);
+  schedule ();
+}
+
+void
+Ekiga::XmlStore::drop_oldest (unsigned count)
+{
+  xmlNodePtr root = doc ? xmlDocGetRootElement (doc.get ()) : NULL;
+
+  stale += count;
+
+  if (root == NULL || stale > xmlChildElementCount (root))
+    save ();
+}
+
+bool
+Ekiga::XmlStore::flush ()
+{
+  if (timeout != 0) {
+
+    g_source_remove (timeout);
+    timeout = 0;
+  }
+
+  if (dirty)
+    return write_all ();
+  else if (!appended.empty ())
+    return write_appended ();
+
+  return true;
+}
+
+gboolean
+Ekiga::XmlStore::on_timeout (gpointer data)
+{
+  XmlStore *self = (XmlStore *) data;
+
+  self->timeout = 0;
+
+  /* what couldn't be written is tried again later */
+  if (!self->flush ())
+    self->schedule ();
+
+  return FALSE;
+}
+
+void
+Ekiga::XmlStore::schedule ()
+{
+  if (timeout == 0)
+    timeout = g_timeout_add_seconds (XML_STORE_DELAY, on_timeout, this);
+}
+
+bool
+Ekiga::XmlStore::write_all ()
+{
+  std::string contents;
+  gchar *dirname = NULL;
+  GError *error = NULL;
+  xmlNodePtr root = doc ? xmlDocGetRootElement (doc.get ()) : NULL;
+
+  if (root != NULL)
+    for (xmlNodePtr child = root->children; child != NULL; child = child->next)
+      if (child->type == XML_ELEMENT_NODE)
+	contents += dump_node (doc.get (), child);
+
+  dirname = g_path_get_dirname (path.c_str ());
+  g_mkdir_with_parents (dirname, 0700);
+  g_free (dirname);
+
+  /* g_file_set_contents writes to a temporary file first, so a crash
+   * leaves either the old or the new file */
+  if (!g_file_set_contents (path.c_str (), contents.c_str (),
+			    contents.length (), &error)) {
+
+    g_warning ("Could not save %s: %s", path.c_str (), error->message);
+    g_error_free (error);
+    return false;
+  }
+
+  dirty = false;
+  stale = 0;
+
+  if (migrated) {
+
+    gm_conf_set_string (legacy_key.c_str (), "");
+    migrated = false;
+  }
+
+  return true;
+}
+
+bool
+Ekiga::XmlStore::write_appended ()
+{
+  FILE *file = g_fopen (path.c_str (), "ab");
+  bool result = false;
+
+  if (file == NULL) {
+
+    g_warning ("Could not open %s: %s", path.c_str (), g_strerror (errno));
+    return false;
+  }
+
+  result = (fwrite (appended.c_str (), 1, appended.length (), file) == appended.length ());
+  if (fclose (file) != 0)
+    result = false;
+  if (!result)
+    g_warning ("Could not write to %s: %s", path.c_str (), g_strerror (errno));
+
+  /* a node written partly is dropped when loading, but one written twice
+   * would not be : the next write is a whole one */
+  appended.clear ();
+  if (!result)
+    dirty = true;
+
+  return result;
+}
@@ -0,0 +1,127 @@
+/*
+ * Ekiga -- A VoIP and Video-Conferencing application
+ * Copyright (C) 2000-2009 Damien Sandras <dsandras@seconix.com>
+
+ * This program is free software; you can  redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version. This program is distributed in the hope
+ * that it will be useful, but WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Ekiga is licensed under the GPL license and as a special exception, you
+ * have permission to link or otherwise combine this program with the
+ * programs OPAL, OpenH323 and PWLIB, and distribute the combination, without
+ * applying the requirements of the GNU GPL to the OPAL, OpenH323 and PWLIB
+ * programs, as long as you do follow the requirements of the GNU GPL for all
+ * the rest of the software thus combined.
+ */
+
+
+/*
+ *                         xml-store.h  -  description
+ *                         ------------------------------------------
+ *   begin                : written in 2012
+ *   copyright            : (c) 2012 by Damien Sandras
+ *   description          : declaration of a file-backed XML document,
+ *                          written back some time after it changed
+ *
+ */
+
+#ifndef __XML_STORE_H__
+#define __XML_STORE_H__
+
+#include <string>
+#include <boost/shared_ptr.hpp>
+#include <libxml/tree.h>
+#include <glib.h>
+
+namespace Ekiga
+{
+
+  /**
+   * @addtogroup services
+   * @{
+   */
+
+  /* An XML document kept in a file of the user configuration directory.
+   *
+   * The file holds the children of the root node one after the other,
+   * without the root itself, so that a node added at the end of the root
+   * only has to be appended to it.
+   *
+   * Changes aren't written right away : they are gathered for a few
+   * seconds, then written at once. Whatever is left is written when the
+   * store is destroyed.
+   *
+   * The document was formerly kept in a GmConf key : it is read from there
+   * if the file doesn't exist yet, and the key is emptied once the file is
+   * written.
+   *
+   * The store is only used from the main thread.
+   */
+  class XmlStore
+  {
+  public:
+
+    XmlStore (const std::string file_name,
+	      const std::string root_name,
+	      const std::string legacy_key);
+
+    ~XmlStore ();
+
+    /* Returns the stored document, or an empty pointer if there is none */
+    boost::shared_ptr<xmlDoc> load ();
+
+    /* Replaces the stored document, and saves it */
+    void reset (boost::shared_ptr<xmlDoc> new_doc);
+
+    /* Tells the document changed, and should be written again */
+    void save ();
+
+    /* Tells the node was added at the end of the root */
+    void append (xmlNodePtr node);
+
+    /* Tells the first count children of the root were removed ; the file
+     * keeps them until it holds more of them than of live nodes, as
+     * readers are expected to drop them again when loading */
+    void drop_oldest (unsigned count);
+
+    /* Writes what is pending right now ; returns false if it failed, in
+     * which case it is still pending */
+    bool flush ();
+
+  private:
+
+    static gboolean on_timeout (gpointer data);
+
+    void schedule ();
+
+    bool write_all ();
+
+    bool write_appended ();
+
+    std::string path;
+    std::string root_name;
+    std::string legacy_key;
+
+    boost::shared_ptr<xmlDoc> doc;
+    bool dirty;             // the whole file has to be written
+    bool migrated;          // the legacy key still has to be emptied
+    std::string appended;   // what has to be appended to the file
+    unsigned stale;         // dropped nodes still in the file
+    guint timeout;
+  };
+
+  /**
+   * @}
+   */
+
+};
+
+#endif
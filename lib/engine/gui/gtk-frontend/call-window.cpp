@@ -396,7 +396,8 @@ static void ekiga_call_window_update_stats (EkigaCallWindow *cw,
                                             unsigned int tr_width,
                                             unsigned int tr_height,
                                             const char *tr_audio_codec,
-                                            const char *tr_video_codec);
+                                            const char *tr_video_codec,
+                                            const Ekiga::VideoOutputLatencyStats *latency_stats);
 
 static void ekiga_call_window_set_status (EkigaCallWindow *cw,
                                           const char *status,
@@ -1305,6 +1306,9 @@ on_stats_refresh_cb (gpointer self)
     Ekiga::VideoOutputStats videooutput_stats;
     cw->priv->videooutput_core->get_videooutput_stats(videooutput_stats);
 
+    Ekiga::VideoOutputLatencyStats latency_stats;
+    bool has_latency_stats = cw->priv->videooutput_core->get_videooutput_latency_stats (latency_stats);
+
     ekiga_call_window_set_status (cw, _("Connected with %s\n%s"), cw->priv->current_call->get_remote_party_name ().c_str (),
                                   cw->priv->current_call->get_duration ().c_str ());
     ekiga_call_window_set_bandwidth (cw,
@@ -1326,7 +1330,8 @@ on_stats_refresh_cb (gpointer self)
                                     videooutput_stats.tx_width,
                                     videooutput_stats.tx_height,
                                     cw->priv->transmitted_audio_codec.c_str (),
-                                    cw->priv->transmitted_video_codec.c_str ());
+                                    cw->priv->transmitted_video_codec.c_str (),
+                                    has_latency_stats ? &latency_stats : NULL);
   }
 
   return true;
@@ -1481,7 +1486,7 @@ ekiga_call_window_clear_stats (EkigaCallWindow *cw)
 {
   g_return_if_fail (EKIGA_IS_CALL_WINDOW (cw));
 
-  ekiga_call_window_update_stats (cw, 0, 0, 0, 0, 0, 0, 0, 0, NULL, NULL);
+  ekiga_call_window_update_stats (cw, 0, 0, 0, 0, 0, 0, 0, 0, NULL, NULL, NULL);
   if (cw->priv->qualitymeter)
     gm_powermeter_set_level (GM_POWERMETER (cw->priv->qualitymeter), 0.0);
 }
@@ -1498,12 +1503,14 @@ ekiga_call_window_update_stats (EkigaCallWindow *cw,
 				unsigned int tr_width,
 				unsigned int tr_height,
                                 const char *tr_audio_codec,
-                                const char *tr_video_codec)
+                                const char *tr_video_codec,
+                                const Ekiga::VideoOutputLatencyStats *latency_stats)
 {
   gchar *stats_msg = NULL;
   gchar *stats_msg_tr = NULL;
   gchar *stats_msg_re = NULL;
   gchar *stats_msg_codecs = NULL;
+  gchar *stats_msg_latency = NULL;
 
   int jitter_quality = 0;
   gfloat quality_level = 0.0;
@@ -1531,6 +1538,21 @@ ekiga_call_window_update_stats (EkigaCallWindow *cw,
                                         tr_audio_codec?tr_audio_codec:"",
                                         tr_video_codec?tr_video_codec:"");
 
+  if (latency_stats
+      && (latency_stats->capture_to_display.count > 0
+          || latency_stats->decode_to_display.count > 0))
+    /* Translators: the latencies of the displayed video, from the capture
+     * of the local frames and from the decoding of the remote frames to
+     * the screen, then the time spent waiting for the screen refresh */
+    stats_msg_latency = g_strdup_printf (_("\nVideo latency: TX %.0f ms RX %.0f ms (95%% < %.0f ms)\nScreen refresh wait: %.0f ms\nSkipped frames: %u"),
+                                         latency_stats->capture_to_display.get_mean (),
+                                         latency_stats->decode_to_display.get_mean (),
+                                         latency_stats->decode_to_display.get_percentile (95),
+                                         latency_stats->sync_wait.get_mean (),
+                                         latency_stats->skipped_local
+                                         + latency_stats->skipped_remote
+                                         + latency_stats->skipped_ext);
+
   stats_msg = g_strdup_printf (_("Lost packets: %.1f %%\nLate packets: %.1f %%\nOut of order packets: %.1f %%\nJitter buffer: %d ms\nCodecs: %s\nResolution: %s %s"),
                                   lost,
                                   late,
@@ -1540,9 +1562,16 @@ ekiga_call_window_update_stats (EkigaCallWindow *cw,
                                   stats_msg_tr,
                                   stats_msg_re);
 
+  if (stats_msg_latency) {
+    gchar *msg = g_strconcat (stats_msg, stats_msg_latency, NULL);
+    g_free (stats_msg);
+    stats_msg = msg;
+  }
+
   g_free(stats_msg_tr);
   g_free(stats_msg_re);
   g_free(stats_msg_codecs);
+  g_free(stats_msg_latency);
 
   gtk_widget_set_tooltip_text (GTK_WIDGET (cw->priv->main_video_image), stats_msg);
   g_free (stats_msg);
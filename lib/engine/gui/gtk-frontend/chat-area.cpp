@@ -45,11 +45,19 @@
 #include "gm-smiley-chooser-button.h"
 
 #include "platform.h"
+#include "gmconf.h"
 
+#include <stdio.h>
 #include <string.h>
 #include <stdarg.h>
+#ifdef WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
 
 #include <glib/gi18n.h>
+#include <glib/gstdio.h>
 #include <gdk/gdkkeysyms.h>
 
 class ChatAreaHelper;
@@ -65,8 +73,20 @@ struct _ChatAreaPrivate
   GtkWidget* scrolled_text_window;
   GtkWidget* text_view;
   GtkWidget* message;
+
+  /* only the last messages are kept in the text buffer ; all of them are
+   * written to the archive, so the older ones can be read back when the
+   * user scrolls up */
+  GQueue* shown;            // marks at the start of the shown messages
+  guint first_shown;        // the number of the oldest shown message
+  FILE* archive;
+  gchar* archive_path;
+  GArray* archive_offsets;  // where each message starts in the archive
 };
 
+/* how many older messages are read back at once */
+#define CHAT_AREA_PAGE 50
+
 enum {
   MESSAGE_NOTICE_EVENT,
   LAST_SIGNAL
@@ -85,6 +105,16 @@ static void chat_area_add_message (ChatArea* self,
 				   const gchar* from,
 				   const gchar* txt);
 
+static void chat_area_append (ChatArea* self,
+			      const gchar* str);
+
+static void chat_area_archive (ChatArea* self,
+			       const gchar* str);
+
+static void chat_area_trim (ChatArea* self);
+
+static void chat_area_show_older (ChatArea* self);
+
 /* declaration of the helping observer */
 class ChatAreaHelper: public Ekiga::ChatObserver
 {
@@ -150,6 +180,9 @@ static gboolean message_activated_cb (GtkWidget *w,
 
 static void on_chat_removed (ChatArea* self);
 
+static void on_text_window_scrolled (GtkAdjustment* adjustment,
+				     gpointer data);
+
 static void on_chat_area_grab_focus (GtkWidget*,
 				     gpointer);
 
@@ -210,21 +243,11 @@ chat_area_add_notice (ChatArea* self,
 		      const gchar* txt)
 {
   gchar* str = NULL;
-  GtkTextMark *mark = NULL;
-  GtkTextBuffer* buffer = NULL;
-  GtkTextIter iter;
 
   str = g_strdup_printf ("NOTICE: %s\n", txt);
-  buffer = gtk_text_view_get_buffer (GTK_TEXT_VIEW (self->priv->text_view));
-  gtk_text_buffer_get_end_iter (buffer, &iter);
-  gm_text_buffer_enhancer_insert_text (self->priv->enhancer, &iter,
-				       str, -1);
+  chat_area_append (self, str);
   g_free (str);
 
-  mark = gtk_text_buffer_get_mark (buffer, "current-position");
-  gtk_text_view_scroll_to_mark (GTK_TEXT_VIEW (self->priv->text_view), mark,
-                                0.0, FALSE, 0,0);
-
   g_signal_emit (self, signals[MESSAGE_NOTICE_EVENT], 0);
 }
 
@@ -234,22 +257,166 @@ chat_area_add_message (ChatArea* self,
 		       const gchar* txt)
 {
   gchar* str = NULL;
+
+  str = g_strdup_printf ("<b><i>%s %s</i></b>\n%s\n", from, _("says:"), txt);
+  chat_area_append (self, str);
+  g_free (str);
+
+  g_signal_emit (self, signals[MESSAGE_NOTICE_EVENT], 0);
+}
+
+static void
+chat_area_append (ChatArea* self,
+		  const gchar* str)
+{
   GtkTextMark *mark = NULL;
   GtkTextBuffer* buffer = NULL;
   GtkTextIter iter;
+  gint offset = 0;
 
-  str = g_strdup_printf ("<b><i>%s %s</i></b>\n%s\n", from, _("says:"), txt);
   buffer = gtk_text_view_get_buffer (GTK_TEXT_VIEW (self->priv->text_view));
   gtk_text_buffer_get_end_iter (buffer, &iter);
+  offset = gtk_text_iter_get_offset (&iter);
   gm_text_buffer_enhancer_insert_text (self->priv->enhancer, &iter,
 				       str, -1);
-  g_free (str);
+
+  /* the mark goes right, so text inserted before the message pushes it */
+  gtk_text_buffer_get_iter_at_offset (buffer, &iter, offset);
+  g_queue_push_tail (self->priv->shown,
+		     gtk_text_buffer_create_mark (buffer, NULL, &iter, FALSE));
+
+  chat_area_archive (self, str);
+  chat_area_trim (self);
 
   mark = gtk_text_buffer_get_mark (buffer, "current-position");
   gtk_text_view_scroll_to_mark (GTK_TEXT_VIEW (self->priv->text_view), mark,
                                 0.0, FALSE, 0,0);
+}
 
-  g_signal_emit (self, signals[MESSAGE_NOTICE_EVENT], 0);
+static void
+chat_area_archive (ChatArea* self,
+		   const gchar* str)
+{
+  gsize length = strlen (str);
+  long end = 0;
+
+  if (self->priv->archive == NULL)
+    return;
+
+  if (fseek (self->priv->archive, 0, SEEK_END) == 0
+      && fwrite (str, 1, length, self->priv->archive) == length
+      && (end = ftell (self->priv->archive)) >= 0) {
+
+    gint64 offset = end;
+    g_array_append_val (self->priv->archive_offsets, offset);
+  } else {
+
+    /* without an archive, nothing is taken out of the buffer anymore */
+    fclose (self->priv->archive);
+    self->priv->archive = NULL;
+  }
+}
+
+static void
+chat_area_trim (ChatArea* self)
+{
+  GtkTextBuffer* buffer = NULL;
+  GtkTextMark* oldest = NULL;
+  GtkTextIter start;
+  GtkTextIter end;
+  gint scrollback = 0;
+
+  if (self->priv->archive == NULL)
+    return;
+
+  scrollback = gm_conf_get_int (USER_INTERFACE_KEY "chat_window/scrollback");
+  if (scrollback <= 0)
+    return;
+
+  buffer = gtk_text_view_get_buffer (GTK_TEXT_VIEW (self->priv->text_view));
+
+  while (g_queue_get_length (self->priv->shown) > (guint) scrollback) {
+
+    oldest = (GtkTextMark*) g_queue_pop_head (self->priv->shown);
+    gtk_text_buffer_get_start_iter (buffer, &start);
+    gtk_text_buffer_get_iter_at_mark (buffer, &end,
+				      (GtkTextMark*) g_queue_peek_head (self->priv->shown));
+    gtk_text_buffer_delete (buffer, &start, &end);
+    gtk_text_buffer_delete_mark (buffer, oldest);
+    self->priv->first_shown++;
+  }
+}
+
+static void
+chat_area_show_older (ChatArea* self)
+{
+  GArray* offsets = self->priv->archive_offsets;
+  GtkTextBuffer* buffer = NULL;
+  GtkAdjustment* adjustment = NULL;
+  GtkTextMark* previous = NULL;
+  GtkTextIter iter;
+  guint from = 0;
+  guint number = 0;
+  gint64 begin = 0;
+  gsize length = 0;
+  gchar* contents = NULL;
+  gchar* str = NULL;
+  gint* starts = NULL;
+
+  if (self->priv->archive == NULL || self->priv->first_shown == 0)
+    return;
+
+  if (self->priv->first_shown > CHAT_AREA_PAGE)
+    from = self->priv->first_shown - CHAT_AREA_PAGE;
+
+  begin = g_array_index (offsets, gint64, from);
+  length = g_array_index (offsets, gint64, self->priv->first_shown) - begin;
+  contents = (gchar*) g_malloc (length);
+
+  if (fseek (self->priv->archive, begin, SEEK_SET) != 0
+      || fread (contents, 1, length, self->priv->archive) != length) {
+
+    g_free (contents);
+    return;
+  }
+
+  buffer = gtk_text_view_get_buffer (GTK_TEXT_VIEW (self->priv->text_view));
+  adjustment = gtk_scrolled_window_get_vadjustment (GTK_SCROLLED_WINDOW (self->priv->scrolled_text_window));
+  previous = (GtkTextMark*) g_queue_peek_head (self->priv->shown);
+  starts = g_new (gint, self->priv->first_shown - from);
+
+  /* the view is at the top while the text is inserted */
+  g_signal_handlers_block_by_func (adjustment, (gpointer) on_text_window_scrolled, self);
+
+  gtk_text_buffer_get_start_iter (buffer, &iter);
+  for (number = from; number < self->priv->first_shown; number++) {
+
+    starts[number - from] = gtk_text_iter_get_offset (&iter);
+    str = g_strndup (contents + g_array_index (offsets, gint64, number) - begin,
+		     g_array_index (offsets, gint64, number + 1)
+		     - g_array_index (offsets, gint64, number));
+    gm_text_buffer_enhancer_insert_text (self->priv->enhancer, &iter,
+					 str, -1);
+    g_free (str);
+  }
+
+  for (number = self->priv->first_shown; number > from; number--) {
+
+    gtk_text_buffer_get_iter_at_offset (buffer, &iter, starts[number - 1 - from]);
+    g_queue_push_head (self->priv->shown,
+		       gtk_text_buffer_create_mark (buffer, NULL, &iter, FALSE));
+  }
+
+  self->priv->first_shown = from;
+  g_free (starts);
+  g_free (contents);
+
+  g_signal_handlers_unblock_by_func (adjustment, (gpointer) on_text_window_scrolled, self);
+
+  /* stay on the message which was read */
+  if (previous != NULL)
+    gtk_text_view_scroll_to_mark (GTK_TEXT_VIEW (self->priv->text_view),
+				  previous, 0.0, TRUE, 0.0, 0.0);
 }
 
 /* implementation of callbacks */
@@ -587,6 +754,14 @@ on_chat_removed (ChatArea* self)
   gtk_widget_hide (self->priv->message);
 }
 
+static void
+on_text_window_scrolled (GtkAdjustment* adjustment,
+			 gpointer data)
+{
+  if (gtk_adjustment_get_value (adjustment) <= gtk_adjustment_get_lower (adjustment))
+    chat_area_show_older (CHAT_AREA (data));
+}
+
 static void
 on_chat_area_grab_focus (GtkWidget* widget,
 			 G_GNUC_UNUSED gpointer data)
@@ -633,6 +808,22 @@ chat_area_dispose (GObject* obj)
     self->priv->enhancer = NULL;
   }
 
+  if (self->priv->archive != NULL) {
+
+    fclose (self->priv->archive);
+    self->priv->archive = NULL;
+  }
+
+#ifdef WIN32
+  /* an open file can't be removed there, so it's only done now */
+  if (self->priv->archive_path != NULL) {
+
+    g_unlink (self->priv->archive_path);
+    g_free (self->priv->archive_path);
+    self->priv->archive_path = NULL;
+  }
+#endif
+
   G_OBJECT_CLASS (chat_area_parent_class)->dispose (obj);
 }
 
@@ -643,6 +834,8 @@ chat_area_finalize (GObject* obj)
 
   self = (ChatArea*)obj;
 
+  g_queue_free (self->priv->shown);
+  g_array_free (self->priv->archive_offsets, TRUE);
   delete self->priv;
 
   G_OBJECT_CLASS (chat_area_parent_class)->finalize (obj);
@@ -675,6 +868,8 @@ chat_area_init (ChatArea* self)
   GtkTextIter iter;
   GtkWidget *frame = NULL;
   GtkWidget *sep = NULL;
+  gint archive_fd = -1;
+  gint64 archive_start = 0;
 
   g_object_set (G_OBJECT (self),
 		"orientation", GTK_ORIENTATION_VERTICAL,
@@ -682,6 +877,30 @@ chat_area_init (ChatArea* self)
 
   self->priv = new ChatAreaPrivate;
 
+  self->priv->shown = g_queue_new ();
+  self->priv->first_shown = 0;
+  self->priv->archive = NULL;
+  self->priv->archive_path = NULL;
+  self->priv->archive_offsets = g_array_new (FALSE, FALSE, sizeof (gint64));
+  g_array_append_val (self->priv->archive_offsets, archive_start);
+
+  archive_fd = g_file_open_tmp ("ekiga-chat-XXXXXX",
+				&self->priv->archive_path, NULL);
+  if (archive_fd != -1) {
+
+    self->priv->archive = fdopen (archive_fd, "w+b");
+    if (self->priv->archive == NULL)
+      close (archive_fd);
+
+#ifndef WIN32
+    /* the open stream is all we need : without a name, the file goes away
+     * with it, even if we crash */
+    g_unlink (self->priv->archive_path);
+    g_free (self->priv->archive_path);
+    self->priv->archive_path = NULL;
+#endif
+  }
+
   /* first the area has a text view to display
      the GtkScrolledWindow is there to make
      the GtkTextView scrollable */
@@ -714,6 +933,8 @@ chat_area_init (ChatArea* self)
 
   gtk_container_add (GTK_CONTAINER (self->priv->scrolled_text_window),
 		     self->priv->text_view);
+  g_signal_connect (gtk_scrolled_window_get_vadjustment (GTK_SCROLLED_WINDOW (self->priv->scrolled_text_window)),
+		    "value-changed", G_CALLBACK (on_text_window_scrolled), self);
 
   frame = gtk_frame_new (NULL);
   gtk_frame_set_shadow_type (GTK_FRAME (frame), GTK_SHADOW_IN);
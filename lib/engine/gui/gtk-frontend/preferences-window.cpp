@@ -880,6 +880,12 @@ refresh_devices_list_cb (G_GNUC_UNUSED GtkWidget *widget,
 {
   g_return_if_fail (data != NULL);
   GtkWidget *prefs_window = GTK_WIDGET (data);
+  GmPreferencesWindow *pw = gm_pw_get_pw (prefs_window);
+
+  /* the cores only probe the devices again when asked to */
+  pw->audiooutput_core->refresh_devices ();
+  pw->audioinput_core->refresh_devices ();
+  pw->videoinput_core->refresh_devices ();
 
   gm_prefs_window_update_devices_list(prefs_window);
 }
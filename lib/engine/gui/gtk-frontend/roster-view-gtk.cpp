@@ -36,6 +36,8 @@
  */
 
 #include <ctime>
+#include <list>
+#include <map>
 #include <glib/gi18n.h>
 #include <gdk/gdkkeysyms.h>
 
@@ -48,6 +50,19 @@
 #include "form-dialog-gtk.h"
 #include "scoped-connections.h"
 
+/* A group row, with the counts of its presentities, so that neither
+ * showing it nor filtering it needs to walk its children */
+struct GroupRow
+{
+  GtkTreeIter iter;
+  int total;
+  int offline;  // offline or unknown, for the count shown
+  int visible;  // not offline, for the filter
+};
+
+typedef std::pair<Ekiga::Heap*, std::string> GroupKey;
+typedef std::pair<Ekiga::Presentity*, std::string> PresentityKey;
+
 /*
  * The Roster
  */
@@ -59,6 +74,12 @@ struct _RosterViewGtkPrivate
   GSList *folded_groups;
   gboolean show_offline_contacts;
   gpointer notifier;
+
+  /* the iters of a GtkTreeStore persist, so they index its rows : a
+   * presentity has a row in each of its groups */
+  std::map<Ekiga::Heap*, GtkTreeIter> heaps;
+  std::map<GroupKey, GroupRow> groups;
+  std::map<PresentityKey, GtkTreeIter> presentities;
 };
 
 typedef struct _StatusIconInfo {
@@ -156,7 +177,18 @@ static void on_clicked_trigger_presentity (Ekiga::Presentity* presentity);
  * PRE         : Both arguments have to be correct
  */
 static void update_offline_count (RosterViewGtk* self,
-				  GtkTreeIter* iter);
+				  const std::string name,
+				  GroupRow* group);
+
+/* DESCRIPTION : Called whenever a presentity row of the group is added,
+ *               changes presence, or is removed
+ * BEHAVIOUR   : Updates the counts of the group ; a NULL presence means
+ *               there was no row, or there is no row anymore
+ * PRE         : /
+ */
+static void update_group_counts (GroupRow* group,
+                                 const gchar* old_presence,
+                                 const gchar* new_presence);
 
 /* DESCRIPTION : Called when the user changes the preference for offline
  * BEHAVIOUR   : Updates things...
@@ -367,10 +399,34 @@ static void roster_view_gtk_find_iter_for_group (RosterViewGtk *view,
  */
 static void roster_view_gtk_find_iter_for_presentity (RosterViewGtk *view,
                                                       GtkTreeIter *group_iter,
+                                                      const std::string group,
                                                       Ekiga::PresentityPtr presentity,
                                                       GtkTreeIter *iter);
 
 
+/* DESCRIPTION  : /
+ * BEHAVIOR     : Removes the row of the given presentity in the given group
+ *                of the given Heap, if there is one.
+ * PRE          : /
+ */
+static void roster_view_gtk_remove_presentity (RosterViewGtk *view,
+                                               Ekiga::Heap* heap,
+                                               const std::string group,
+                                               Ekiga::Presentity* presentity);
+
+
+/* DESCRIPTION  : /
+ * BEHAVIOR     : Removes the group from the view if it is empty, or else
+ *                updates its count, and folds or unfolds it following the
+ *                value of the appropriate GMConf key.
+ * PRE          : /
+ */
+static void roster_view_gtk_update_group (RosterViewGtk *view,
+                                          GtkTreeIter *heap_iter,
+                                          Ekiga::Heap* heap,
+                                          const std::string name);
+
+
 /* DESCRIPTION  : /
  * BEHAVIOR     : Do a clean up in the RosterViewGtk to clean all empty groups
  *                from the view. It also folds or unfolds groups following
@@ -600,41 +656,41 @@ on_clicked_trigger_presentity (Ekiga::Presentity* presentity)
 
 static void
 update_offline_count (RosterViewGtk* self,
-		      GtkTreeIter* iter)
+		      const std::string name,
+		      GroupRow* group)
 {
-  GtkTreeModel *model = NULL;
-  GtkTreeIter loop_iter;
-  gint total = 0;
-  gint offline_count = 0;
-  gint column_type;
-  Ekiga::Presentity* presentity = NULL;
-  gchar *name = NULL;
   gchar *name_with_count = NULL;
 
-  model = GTK_TREE_MODEL (self->priv->store);
-
-  if (gtk_tree_model_iter_nth_child (model, &loop_iter, iter, 0)) {
+  /* this also tells the filter the group may have to be shown or hidden */
+  name_with_count = g_strdup_printf ("%s - (%d/%d)", name.c_str (),
+                                     group->total - group->offline, group->total);
+  gtk_tree_store_set (self->priv->store, &group->iter,
+                      COLUMN_NAME, name_with_count, -1);
+  g_free (name_with_count);
+}
 
-    do {
+static void
+update_group_counts (GroupRow* group,
+                     const gchar* old_presence,
+                     const gchar* new_presence)
+{
+  if (old_presence) {
 
-      gtk_tree_model_get (model, &loop_iter,
-                          COLUMN_TYPE, &column_type,
-                          COLUMN_PRESENTITY, &presentity,
-                          -1);
-      if (column_type == TYPE_PRESENTITY
-          && (presentity->get_presence () == "offline"
-              || presentity->get_presence () == "unknown"))
-        offline_count++;
-    } while (gtk_tree_model_iter_next (model, &loop_iter));
+    group->total--;
+    if (!g_strcmp0 (old_presence, "offline") || !g_strcmp0 (old_presence, "unknown"))
+      group->offline--;
+    if (g_strcmp0 (old_presence, "offline"))
+      group->visible--;
   }
 
-  total = gtk_tree_model_iter_n_children (model, iter);
-  gtk_tree_model_get (model, iter, COLUMN_GROUP_NAME, &name, -1);
-  name_with_count = g_strdup_printf ("%s - (%d/%d)", name, total - offline_count, total);
-  gtk_tree_store_set (GTK_TREE_STORE (model), iter,
-                      COLUMN_NAME, name_with_count, -1);
-  g_free (name);
-  g_free (name_with_count);
+  if (new_presence) {
+
+    group->total++;
+    if (!g_strcmp0 (new_presence, "offline") || !g_strcmp0 (new_presence, "unknown"))
+      group->offline++;
+    if (g_strcmp0 (new_presence, "offline"))
+      group->visible++;
+  }
 }
 
 static void
@@ -799,13 +855,20 @@ group_hide_show_offline (RosterViewGtk* self,
     result = TRUE;
   else {
 
-    GtkTreeIter child_iter;
-    if (gtk_tree_model_iter_nth_child (model, &child_iter, iter, 0)) {
+    Ekiga::Heap* heap = NULL;
+    gchar* name = NULL;
 
-      do {
+    gtk_tree_model_get (model, iter,
+                        COLUMN_HEAP, &heap,
+                        COLUMN_GROUP_NAME, &name,
+                        -1);
+    if (name) {
 
-        result = presentity_hide_show_offline (self, model, &child_iter);
-      } while (!result && gtk_tree_model_iter_next (model, &child_iter));
+      std::map<GroupKey, GroupRow>::const_iterator group
+        = self->priv->groups.find (GroupKey (heap, name));
+      if (group != self->priv->groups.end ())
+        result = (group->second.visible > 0);
+      g_free (name);
     }
   }
 
@@ -968,26 +1031,39 @@ on_heap_removed (RosterViewGtk* self,
   GtkTreeIter heap_iter;
   GtkTreeIter group_iter;
   guint timeout = 0;
+  gchar *group_name = NULL;
+  Ekiga::Presentity *presentity = NULL;
 
   roster_view_gtk_find_iter_for_heap (self, heap, &heap_iter);
 
-  // Remove all timeout-based effects for the heap presentities
+  // Remove all timeout-based effects for the heap presentities,
+  // and forget about their rows
   if (gtk_tree_model_iter_nth_child (GTK_TREE_MODEL (self->priv->store),
                                      &group_iter, &heap_iter, 0)) {
     do {
+      gtk_tree_model_get (GTK_TREE_MODEL (self->priv->store), &group_iter,
+                          COLUMN_GROUP_NAME, &group_name,
+                          -1);
       if (gtk_tree_model_iter_nth_child (GTK_TREE_MODEL (self->priv->store),
                                          &iter, &group_iter, 0)) {
         do {
           gtk_tree_model_get (GTK_TREE_MODEL (self->priv->store), &iter,
                               COLUMN_TIMEOUT, &timeout,
+                              COLUMN_PRESENTITY, &presentity,
                               -1);
           if (timeout > 0)
             g_source_remove (timeout);
+          if (group_name)
+            self->priv->presentities.erase (PresentityKey (presentity, group_name));
         } while (gtk_tree_model_iter_next (GTK_TREE_MODEL (self->priv->store), &iter));
       }
+      if (group_name)
+        self->priv->groups.erase (GroupKey (heap.get (), group_name));
+      g_free (group_name);
     } while (gtk_tree_model_iter_next (GTK_TREE_MODEL (self->priv->store), &group_iter));
   }
 
+  self->priv->heaps.erase (heap.get ());
   gtk_tree_store_remove (self->priv->store, &heap_iter);
 }
 
@@ -1037,7 +1113,8 @@ on_presentity_added (RosterViewGtk* self,
 
     roster_view_gtk_find_iter_for_group (self, heap, &heap_iter,
 					 *group, &group_iter);
-    roster_view_gtk_find_iter_for_presentity (self, &group_iter, presentity, &iter);
+    roster_view_gtk_find_iter_for_presentity (self, &group_iter, *group,
+                                              presentity, &iter);
 
     if (gtk_tree_model_filter_convert_child_iter_to_iter (filtered_model, &filtered_iter, &iter))
       if (gtk_tree_selection_iter_is_selected (selection, &filtered_iter))
@@ -1046,6 +1123,8 @@ on_presentity_added (RosterViewGtk* self,
     // Find out what our presence was
     gtk_tree_model_get (GTK_TREE_MODEL (self->priv->store), &iter,
                         COLUMN_PRESENCE, &old_presence, -1);
+    update_group_counts (&self->priv->groups[GroupKey (heap.get (), *group)],
+                         old_presence, presentity->get_presence ().c_str ());
 
     if (old_presence && presentity->get_presence () != old_presence
         && presentity->get_presence () != "unknown" && presentity->get_presence () != "offline"
@@ -1104,10 +1183,12 @@ on_presentity_added (RosterViewGtk* self,
     g_free (old_presence);
   }
 
-  GtkTreeModel* model = gtk_tree_view_get_model (self->priv->tree_view);
-  gtk_tree_model_filter_refilter (GTK_TREE_MODEL_FILTER (model));
-
-  roster_view_gtk_update_groups (self, &heap_iter);
+  /* the filter sees the rows which changed : there is no need to refilter
+   * the whole roster for a presentity */
+  for (std::set<std::string>::const_iterator group = groups.begin ();
+       group != groups.end ();
+       group++)
+    roster_view_gtk_update_group (self, &heap_iter, heap.get (), *group);
 
   if (should_emit)
     g_signal_emit (self, signals[SELECTION_CHANGED_SIGNAL], 0);
@@ -1120,15 +1201,9 @@ on_presentity_updated (RosterViewGtk* self,
 		       Ekiga::HeapPtr heap,
 		       Ekiga::PresentityPtr presentity)
 {
-  GtkTreeModel *model;
   GtkTreeIter heap_iter;
-  GtkTreeIter group_iter;
-  GtkTreeIter iter;
-  gchar *group_name = NULL;
-  int timeout = 0;
   std::set<std::string> groups = presentity->get_groups ();
-
-  model = GTK_TREE_MODEL (self->priv->store);
+  std::list<std::string> old_groups;
 
   if (groups.empty ())
     groups.insert (_("Unsorted"));
@@ -1139,34 +1214,20 @@ on_presentity_updated (RosterViewGtk* self,
   // Now let's remove from all the others
   roster_view_gtk_find_iter_for_heap (self, heap, &heap_iter);
 
-  if (gtk_tree_model_iter_nth_child (model, &group_iter, &heap_iter, 0)) {
-
-    do {
-
-      gtk_tree_model_get (model, &group_iter,
-                          COLUMN_GROUP_NAME, &group_name,
-                          -1);
-      if (group_name != NULL) {
+  for (std::map<PresentityKey, GtkTreeIter>::const_iterator iter
+         = self->priv->presentities.lower_bound (PresentityKey (presentity.get (), ""));
+       iter != self->priv->presentities.end () && iter->first.first == presentity.get ();
+       ++iter)
+    if (groups.find (iter->first.second) == groups.end ())
+      old_groups.push_back (iter->first.second);
 
-        if (groups.find (group_name) == groups.end ()) {
+  for (std::list<std::string>::const_iterator group = old_groups.begin ();
+       group != old_groups.end ();
+       ++group) {
 
-          roster_view_gtk_find_iter_for_presentity (self, &group_iter, presentity, &iter);
-          gtk_tree_model_get (GTK_TREE_MODEL (self->priv->store), &iter,
-                              COLUMN_TIMEOUT, &timeout,
-                              -1);
-          if (timeout > 0)
-            g_source_remove (timeout);
-          gtk_tree_store_remove (self->priv->store, &iter);
-        }
-        g_free (group_name);
-      }
-    } while (gtk_tree_model_iter_next (model, &group_iter));
+    roster_view_gtk_remove_presentity (self, heap.get (), *group, presentity.get ());
+    roster_view_gtk_update_group (self, &heap_iter, heap.get (), *group);
   }
-
-  model = gtk_tree_view_get_model (self->priv->tree_view);
-  gtk_tree_model_filter_refilter (GTK_TREE_MODEL_FILTER (model));
-
-  roster_view_gtk_update_groups (self, &heap_iter);
 }
 
 
@@ -1176,30 +1237,24 @@ on_presentity_removed (RosterViewGtk* self,
 		       Ekiga::HeapPtr heap,
 		       Ekiga::PresentityPtr presentity)
 {
-  GtkTreeModel *model = NULL;
   GtkTreeIter heap_iter;
-  GtkTreeIter group_iter;
-  GtkTreeIter iter;
-  int timeout = 0;
+  std::list<std::string> groups;
 
   roster_view_gtk_find_iter_for_heap (self, heap, &heap_iter);
-  model = GTK_TREE_MODEL (self->priv->store);
 
-  if (gtk_tree_model_iter_nth_child (model, &group_iter, &heap_iter, 0)) {
+  for (std::map<PresentityKey, GtkTreeIter>::const_iterator iter
+         = self->priv->presentities.lower_bound (PresentityKey (presentity.get (), ""));
+       iter != self->priv->presentities.end () && iter->first.first == presentity.get ();
+       ++iter)
+    groups.push_back (iter->first.second);
 
-    do {
+  for (std::list<std::string>::const_iterator group = groups.begin ();
+       group != groups.end ();
+       ++group) {
 
-      roster_view_gtk_find_iter_for_presentity (self, &group_iter, presentity, &iter);
-      gtk_tree_model_get (GTK_TREE_MODEL (self->priv->store), &iter,
-                          COLUMN_TIMEOUT, &timeout,
-                          -1);
-      if (timeout > 0)
-        g_source_remove (timeout);
-      gtk_tree_store_remove (self->priv->store, &iter);
-    } while (gtk_tree_model_iter_next (model, &group_iter));
+    roster_view_gtk_remove_presentity (self, heap.get (), *group, presentity.get ());
+    roster_view_gtk_update_group (self, &heap_iter, heap.get (), *group);
   }
-
-  roster_view_gtk_update_groups (self, &heap_iter);
 }
 
 static bool
@@ -1223,24 +1278,17 @@ roster_view_gtk_find_iter_for_heap (RosterViewGtk *view,
                                     Ekiga::HeapPtr heap,
                                     GtkTreeIter *iter)
 {
-  GtkTreeModel *model = NULL;
-  Ekiga::Heap *iter_heap = NULL;
-  gboolean found = FALSE;
+  std::map<Ekiga::Heap*, GtkTreeIter>::const_iterator found
+    = view->priv->heaps.find (heap.get ());
 
-  model = GTK_TREE_MODEL (view->priv->store);
-
-  if (gtk_tree_model_get_iter_first (model, iter)) {
-
-    do {
+  if (found != view->priv->heaps.end ()) {
 
-      gtk_tree_model_get (model, iter, COLUMN_HEAP, &iter_heap, -1);
-      if (iter_heap == heap.get ())
-        found = TRUE;
-    } while (!found && gtk_tree_model_iter_next (model, iter));
+    *iter = found->second;
+    return;
   }
 
-  if (!found)
-    gtk_tree_store_append (view->priv->store, iter, NULL);
+  gtk_tree_store_append (view->priv->store, iter, NULL);
+  view->priv->heaps[heap.get ()] = *iter;
 }
 
 
@@ -1251,136 +1299,167 @@ roster_view_gtk_find_iter_for_group (RosterViewGtk *view,
                                      const std::string name,
                                      GtkTreeIter *iter)
 {
-  GtkTreeModel *model = NULL;
-  gchar *group_name = NULL;
-  gboolean found = FALSE;
-
-  model = GTK_TREE_MODEL (view->priv->store);
+  std::map<GroupKey, GroupRow>::const_iterator found
+    = view->priv->groups.find (GroupKey (heap.get (), name));
 
-  if (gtk_tree_model_iter_nth_child (model, iter, heap_iter, 0)) {
+  if (found != view->priv->groups.end ()) {
 
-    do {
-
-      gtk_tree_model_get (model, iter, COLUMN_GROUP_NAME, &group_name, -1);
-      if (group_name != NULL && name == group_name)
-        found = TRUE;
-      if (group_name != NULL)
-        g_free (group_name);
-    } while (!found && gtk_tree_model_iter_next (model, iter));
+    *iter = found->second.iter;
+    return;
   }
 
-  if (!found) {
-
-    gtk_tree_store_append (view->priv->store, iter, heap_iter);
-    gtk_tree_store_set (view->priv->store, iter,
-                        COLUMN_TYPE, TYPE_GROUP,
-                        COLUMN_HEAP, heap.get (),
-                        COLUMN_NAME, name.c_str (),
-                        COLUMN_GROUP_NAME, name.c_str (),
-                        -1);
-  }
+  gtk_tree_store_append (view->priv->store, iter, heap_iter);
+
+  /* indexed before it is set, as the filter looks it up */
+  GroupRow& group = view->priv->groups[GroupKey (heap.get (), name)];
+  group.iter = *iter;
+  group.total = 0;
+  group.offline = 0;
+  group.visible = 0;
+
+  gtk_tree_store_set (view->priv->store, iter,
+                      COLUMN_TYPE, TYPE_GROUP,
+                      COLUMN_HEAP, heap.get (),
+                      COLUMN_NAME, name.c_str (),
+                      COLUMN_GROUP_NAME, name.c_str (),
+                      -1);
 }
 
 
 static void
 roster_view_gtk_find_iter_for_presentity (RosterViewGtk *view,
                                           GtkTreeIter *group_iter,
+                                          const std::string group,
                                           Ekiga::PresentityPtr presentity,
                                           GtkTreeIter *iter)
 {
-  GtkTreeModel *model = NULL;
-  Ekiga::Presentity *iter_presentity = NULL;
-  gboolean found = FALSE;
+  std::map<PresentityKey, GtkTreeIter>::const_iterator found
+    = view->priv->presentities.find (PresentityKey (presentity.get (), group));
 
-  model = GTK_TREE_MODEL (view->priv->store);
+  if (found != view->priv->presentities.end ()) {
 
-  if (gtk_tree_model_iter_nth_child (model, iter, group_iter, 0)) {
+    *iter = found->second;
+    return;
+  }
 
-    do {
+  gtk_tree_store_append (view->priv->store, iter, group_iter);
+  view->priv->presentities[PresentityKey (presentity.get (), group)] = *iter;
+}
 
-      gtk_tree_model_get (model, iter, COLUMN_PRESENTITY, &iter_presentity, -1);
-      if (iter_presentity == presentity.get ())
-        found = TRUE;
-    } while (!found && gtk_tree_model_iter_next (model, iter));
-  }
 
-  if (!found)
-    gtk_tree_store_append (view->priv->store, iter, group_iter);
+static void
+roster_view_gtk_remove_presentity (RosterViewGtk *view,
+                                   Ekiga::Heap* heap,
+                                   const std::string group,
+                                   Ekiga::Presentity* presentity)
+{
+  std::map<PresentityKey, GtkTreeIter>::iterator iter
+    = view->priv->presentities.find (PresentityKey (presentity, group));
+  std::map<GroupKey, GroupRow>::iterator group_row
+    = view->priv->groups.find (GroupKey (heap, group));
+  gchar *presence = NULL;
+  int timeout = 0;
+
+  if (iter == view->priv->presentities.end ())
+    return;
+
+  gtk_tree_model_get (GTK_TREE_MODEL (view->priv->store), &iter->second,
+                      COLUMN_TIMEOUT, &timeout,
+                      COLUMN_PRESENCE, &presence,
+                      -1);
+  if (timeout > 0)
+    g_source_remove (timeout);
+
+  if (group_row != view->priv->groups.end ())
+    update_group_counts (&group_row->second, presence ? presence : "unknown", NULL);
+
+  gtk_tree_store_remove (view->priv->store, &iter->second);
+  view->priv->presentities.erase (iter);
+
+  g_free (presence);
 }
 
 
 static void
-roster_view_gtk_update_groups (RosterViewGtk *view,
-                               GtkTreeIter *heap_iter)
+roster_view_gtk_update_group (RosterViewGtk *view,
+                              GtkTreeIter *heap_iter,
+                              Ekiga::Heap* heap,
+                              const std::string name)
 {
   GtkTreeModel *model = NULL;
   GtkTreePath *path = NULL;
-  GtkTreeIter iter;
-
   GSList *existing_group = NULL;
+  std::map<GroupKey, GroupRow>::iterator group
+    = view->priv->groups.find (GroupKey (heap, name));
 
-  int timeout = 0;
-  gboolean go_on = FALSE;
-  gchar *name = NULL;
+  if (group == view->priv->groups.end ())
+    return;
+
+  // remove the node if it has no children
+  if (group->second.total <= 0) {
+
+    gtk_tree_store_remove (view->priv->store, &group->second.iter);
+    view->priv->groups.erase (group);
+    return;
+  }
 
+  // else see if it must be folded or unfolded
   model = GTK_TREE_MODEL (view->priv->store);
 
-  if (gtk_tree_model_iter_nth_child (model, &iter, heap_iter, 0)) {
+  update_offline_count (view, name, &group->second);
 
-    do {
+  if (view->priv->folded_groups)
+    existing_group = g_slist_find_custom (view->priv->folded_groups,
+                                          name.c_str (),
+                                          (GCompareFunc) g_ascii_strcasecmp);
 
-      // If this node has children, see if it must be
-      // folded or unfolded
-      if (gtk_tree_model_iter_has_child (model, &iter)) {
-
-        update_offline_count (view, &iter);
-        gtk_tree_model_get (model, &iter,
-                            COLUMN_GROUP_NAME, &name, -1);
-        if (name) {
-
-          if (view->priv->folded_groups)
-            existing_group = g_slist_find_custom (view->priv->folded_groups,
-                                                  name,
-                                                  (GCompareFunc) g_ascii_strcasecmp);
-
-          path = gtk_tree_model_get_path (model, heap_iter);
-          gtk_tree_view_expand_row (view->priv->tree_view, path, FALSE);
-          gtk_tree_path_free (path);
-
-          path = gtk_tree_model_get_path (model, &iter);
-          if (path) {
-
-            if (existing_group == NULL) {
-              if (!gtk_tree_view_row_expanded (view->priv->tree_view, path)) {
-                gtk_tree_view_expand_row (view->priv->tree_view, path, TRUE);
-              }
-            }
-            else {
-              if (gtk_tree_view_row_expanded (view->priv->tree_view, path)) {
-                gtk_tree_view_collapse_row (view->priv->tree_view, path);
-              }
-            }
-
-            gtk_tree_path_free (path);
-          }
-
-          go_on = gtk_tree_model_iter_next (model, &iter);
-        }
-
-        g_free (name);
-      }
-      // else remove the node (no children)
-      else {
+  path = gtk_tree_model_get_path (model, heap_iter);
+  gtk_tree_view_expand_row (view->priv->tree_view, path, FALSE);
+  gtk_tree_path_free (path);
 
-        gtk_tree_model_get (GTK_TREE_MODEL (view->priv->store), &iter,
-                            COLUMN_TIMEOUT, &timeout,
-                            -1);
-        go_on = gtk_tree_store_remove (view->priv->store, &iter);
+  path = gtk_tree_model_get_path (model, &group->second.iter);
+  if (path) {
+
+    if (existing_group == NULL) {
+      if (!gtk_tree_view_row_expanded (view->priv->tree_view, path)) {
+        gtk_tree_view_expand_row (view->priv->tree_view, path, TRUE);
+      }
+    }
+    else {
+      if (gtk_tree_view_row_expanded (view->priv->tree_view, path)) {
+        gtk_tree_view_collapse_row (view->priv->tree_view, path);
       }
-    } while (go_on);
+    }
+
+    gtk_tree_path_free (path);
   }
 }
 
+
+static void
+roster_view_gtk_update_groups (RosterViewGtk *view,
+                               GtkTreeIter *heap_iter)
+{
+  Ekiga::Heap *heap = NULL;
+  std::list<std::string> names;
+
+  gtk_tree_model_get (GTK_TREE_MODEL (view->priv->store), heap_iter,
+                      COLUMN_HEAP, &heap,
+                      -1);
+
+  // updating a group may remove it
+  for (std::map<GroupKey, GroupRow>::const_iterator iter
+         = view->priv->groups.lower_bound (GroupKey (heap, ""));
+       iter != view->priv->groups.end () && iter->first.first == heap;
+       ++iter)
+    names.push_back (iter->first.second);
+
+  for (std::list<std::string>::const_iterator name = names.begin ();
+       name != names.end ();
+       ++name)
+    roster_view_gtk_update_group (view, heap_iter, heap, *name);
+}
+
 /*
  * GObject stuff
  */
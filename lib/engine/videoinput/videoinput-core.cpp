@@ -52,7 +52,6 @@ VideoInputCore::VideoPreviewManager::VideoPreviewManager (VideoInputCore& _video
   height = 144;;
   pause_thread = true;
   end_thread = false;
-  frame = NULL;
   // Since windows does not like to restart a thread that
   // was never started, we do so here
   this->Resume ();
@@ -74,7 +73,6 @@ void VideoInputCore::VideoPreviewManager::start (unsigned _width, unsigned _heig
   width = _width;
   height = _height;
   end_thread = false;
-  frame = (char*) malloc (unsigned (width * height * 3 / 2));
 
   videooutput_core->start();
   pause_thread = false;
@@ -87,10 +85,6 @@ void VideoInputCore::VideoPreviewManager::stop ()
   pause_thread = true;
   thread_paused.Wait();
 
-  if (frame) {
-    free (frame);
-    frame = NULL;
-  }
   videooutput_core->stop();
 }
 
@@ -104,10 +98,12 @@ void VideoInputCore::VideoPreviewManager::Main ()
     run_thread.Wait ();
 
     while (!pause_thread) {
-      if (frame) {
-        videoinput_core.get_frame_data(frame);
-        videooutput_core->set_frame_data(frame, width, height, 0, 1);
-      }
+      /* The frame is grabbed directly into a buffer of the video output
+       * pool and then handed over by reference */
+      VideoFramePtr frame = videooutput_core->acquire_frame (width, height);
+      videoinput_core.get_frame_data (frame->get_data ());
+      frame->set_timestamp (VideoFrame::now ());
+      videooutput_core->set_frame (frame, 0, 1);
       // We have to sleep some time outside the mutex lock
       // to give other threads time to get the mutex
       // It will be taken into account by PAdaptiveDelay
@@ -201,6 +197,8 @@ void VideoInputCore::get_devices (std::vector <VideoInputDevice> & devices)
 {
   PWaitAndSignal m(core_mutex);
 
+  PTime start;
+
   devices.clear();
 
   for (std::set<VideoInputManager *>::iterator iter = managers.begin ();
@@ -208,6 +206,9 @@ void VideoInputCore::get_devices (std::vector <VideoInputDevice> & devices)
        iter++)
     (*iter)->get_devices (devices);
 
+  PTRACE(4, "VidInputCore\tListed " << devices.size () << " devices in "
+         << (PTime () - start).GetMilliSeconds () << " ms");
+
 #if PTRACING
   for (std::vector<VideoInputDevice>::iterator iter = devices.begin ();
        iter != devices.end ();
@@ -217,6 +218,17 @@ void VideoInputCore::get_devices (std::vector <VideoInputDevice> & devices)
 #endif
 }
 
+void VideoInputCore::refresh_devices ()
+{
+  PTRACE(4, "VidInputCore\tRefreshing devices");
+  PWaitAndSignal m(core_mutex);
+
+  for (std::set<VideoInputManager *>::iterator iter = managers.begin ();
+       iter != managers.end ();
+       iter++)
+    (*iter)->refresh_devices ();
+}
+
 void VideoInputCore::set_device(const VideoInputDevice & device, int channel, VideoInputFormat format)
 {
   PWaitAndSignal m(core_mutex);
@@ -230,6 +242,13 @@ void VideoInputCore::add_device (const std::string & source, const std::string &
   PWaitAndSignal m(core_mutex);
 
   VideoInputDevice device;
+
+  /* the managers only know about the new device once they probed again */
+  for (std::set<VideoInputManager *>::iterator iter = managers.begin ();
+       iter != managers.end ();
+       iter++)
+    (*iter)->refresh_devices ();
+
   for (std::set<VideoInputManager *>::iterator iter = managers.begin ();
        iter != managers.end ();
        iter++) {
@@ -276,6 +295,12 @@ void VideoInputCore::remove_device (const std::string & source, const std::strin
        notification_core->push_notification (notif);
      }
   }
+
+  /* the managers had to know about the device to tell whether it was theirs */
+  for (std::set<VideoInputManager *>::iterator iter = managers.begin ();
+       iter != managers.end ();
+       iter++)
+    (*iter)->refresh_devices ();
 }
 
 void VideoInputCore::set_preview_config (unsigned width, unsigned height, unsigned fps)
@@ -154,6 +154,12 @@ namespace Ekiga
        */
       void get_devices(std::vector <VideoInputDevice> & devices);
 
+      /** Make all managers registered to the core probe their devices again.
+       * The devices are otherwise only probed when the core learns that one
+       * was added or removed, so that get_devices() doesn't cost a probe.
+       */
+      void refresh_devices ();
+
       /** Set a specific device
        * This function sets the current video input device. This function can
        * also be used while in a stream or in preview mode. In that case the old
@@ -348,7 +354,6 @@ private:
 
       protected:
         void Main ();
-        char* frame;
 
         bool end_thread;
         bool pause_thread;
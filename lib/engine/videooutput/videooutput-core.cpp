@@ -51,6 +51,8 @@ VideoOutputCore::VideoOutputCore ()
   videooutput_stats.tx_frames = 0;
   number_times_started = 0;
   videooutput_core_conf_bridge = NULL;
+
+  frame_pool = VideoFramePoolPtr (new VideoFramePool);
 }
 
 VideoOutputCore::~VideoOutputCore ()
@@ -149,6 +151,22 @@ void VideoOutputCore::set_frame_data (const char *data,
                                   unsigned type,
                                   int devices_nbr)
 {
+  set_frame (frame_pool->acquire_copy (data, width, height), type, devices_nbr);
+}
+
+VideoFramePtr VideoOutputCore::acquire_frame (unsigned width,
+                                              unsigned height)
+{
+  return frame_pool->acquire (width, height);
+}
+
+void VideoOutputCore::set_frame (VideoFramePtr frame,
+                                 unsigned type,
+                                 int devices_nbr)
+{
+  unsigned width = frame->get_width ();
+  unsigned height = frame->get_height ();
+
   core_mutex.Wait ();
 
   if (type == 0) { // LOCAL
@@ -181,8 +199,23 @@ void VideoOutputCore::set_frame_data (const char *data,
   for (std::set<VideoOutputManager *>::iterator iter = managers.begin ();
        iter != managers.end ();
        iter++) {
-    (*iter)->set_frame_data (data, width, height, type, devices_nbr);
+    (*iter)->set_frame (frame, type, devices_nbr);
+  }
+}
+
+bool VideoOutputCore::get_videooutput_latency_stats (VideoOutputLatencyStats & _latency_stats)
+{
+  PWaitAndSignal m(core_mutex);
+
+  /* only the displaying managers measure them, and there is one */
+  for (std::set<VideoOutputManager *>::iterator iter = managers.begin ();
+       iter != managers.end ();
+       iter++) {
+    if ((*iter)->get_latency_stats (_latency_stats))
+      return true;
   }
+
+  return false;
 }
 
 void VideoOutputCore::set_display_info (const DisplayInfo & _display_info)
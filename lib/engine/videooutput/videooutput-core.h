@@ -41,6 +41,7 @@
 
 #include "videooutput-gmconf-bridge.h"
 #include "videooutput-manager.h"
+#include "videooutput-frame.h"
 
 #include <boost/signals2.hpp>
 #include <boost/bind.hpp>
@@ -144,6 +145,27 @@ namespace Ekiga
                            unsigned type,
                            int devices_nbr);
 
+      /** Get a frame buffer to be filled and passed to set_frame()
+       * The buffer comes from a pool shared with the managers, so that
+       * producers can write their frames directly into it.
+       * @param width the width in pixels of the frame.
+       * @param height the height in pixels of the frame.
+       * @return the frame, whose content is undefined.
+       */
+      VideoFramePtr acquire_frame (unsigned width,
+                                   unsigned height);
+
+      /** Display a single frame by reference
+       * Pass the frame to all registered managers without copying it.
+       * The video output must have been started before.
+       * @param frame a frame obtained through acquire_frame().
+       * @param type the type of the frame: 0 - local video source or >0 from the remote end.
+       * @param devices_nbr 1 if only local or remote device has been opened, 2 if both have been opened.
+       */
+      void set_frame (VideoFramePtr frame,
+                      unsigned type,
+                      int devices_nbr);
+
       void set_display_info (const DisplayInfo & _display_info);
       void set_ext_display_info (const DisplayInfo & _display_info);
 
@@ -158,6 +180,15 @@ namespace Ekiga
         _videooutput_stats = videooutput_stats;
       };
 
+      /** Get the latencies of the displayed frames, from the time they
+       * were captured (local frames) or decoded (remote frames) to the time
+       * they were synced to the screen, and the number of skipped frames.
+       *
+       * @param _latency_stats the struct to be filled with the current values.
+       * @return false if no manager measures them.
+       */
+      bool get_videooutput_latency_stats (VideoOutputLatencyStats & _latency_stats);
+
 
       /*** Signals ***/
 
@@ -187,6 +218,8 @@ namespace Ekiga
 
       std::set<VideoOutputManager *> managers;
 
+      VideoFramePoolPtr frame_pool;
+
       VideoOutputStats videooutput_stats;
       GTimeVal last_stats;
       int number_times_started;
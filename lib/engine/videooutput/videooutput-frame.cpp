@@ -0,0 +1,229 @@
+/*
+ * Ekiga -- A VoIP and Video-Conferencing application
+ * Copyright (C) 2000-2009 Damien Sandras <dsandras@seconix.com>
+
+ * This program is free software; you can  redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version. This program is distributed in the hope
+ * that it will be useful, but WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Ekiga is licensed under the GPL license and as a special exception, you
+ * have permission to link or otherwise combine this program with the
+ * programs OPAL, OpenH323 and PWLIB, and distribute the combination, without
+ * applying the requirements of the GNU GPL to the OPAL, OpenH323 and PWLIB
+ * programs, as long as you do follow the requirements of the GNU GPL for all
+ * the rest of the software thus combined.
+ */
+
+
+/*
+ *                         videooutput-frame.cpp  -  description
+ *                         ------------------------------------------
+ *   begin                : written in 2012
+ *   copyright            : (c) 2012 by Damien Sandras
+ *   description          : Implementation of the reference-counted YUV420P
+ *                          frame buffers and of their pool.
+ *
+ */
+
+#include "videooutput-frame.h"
+
+#include <string.h>
+
+using namespace Ekiga;
+
+/* created before main, so that it is never created by two threads */
+static GTimer* frame_clock = g_timer_new ();
+
+VideoFrame::VideoFrame (unsigned _width,
+                        unsigned _height)
+  : width(_width), height(_height), timestamp(now ()),
+    buffer(size_for (_width, _height))
+{
+}
+
+double
+VideoFrame::now ()
+{
+  return g_timer_elapsed (frame_clock, NULL);
+}
+
+void
+VideoFrame::reset (unsigned _width,
+                   unsigned _height)
+{
+  width = _width;
+  height = _height;
+  timestamp = now ();
+
+  /* never shrinks: a stream going down and up again in resolution
+   * keeps using the same memory */
+  if (buffer.size () < size_for (width, height))
+    buffer.resize (size_for (width, height));
+}
+
+
+void
+VideoFramePool::Recycler::operator() (VideoFrame* frame)
+{
+  boost::shared_ptr<VideoFramePool> the_pool = pool.lock ();
+
+  if (the_pool)
+    the_pool->release (frame);
+  else
+    delete frame;
+}
+
+
+VideoFramePool::VideoFramePool (unsigned _max_free)
+  : max_free(_max_free), allocated(0)
+{
+}
+
+VideoFramePool::~VideoFramePool ()
+{
+  for (std::vector<VideoFrame*>::iterator iter = free_frames.begin ();
+       iter != free_frames.end ();
+       ++iter)
+    delete *iter;
+}
+
+VideoFramePtr
+VideoFramePool::acquire (unsigned width,
+                         unsigned height)
+{
+  VideoFrame* frame = NULL;
+
+  {
+    PWaitAndSignal m(mutex);
+
+    if (!free_frames.empty ()) {
+
+      frame = free_frames.back ();
+      free_frames.pop_back ();
+    }
+    else
+      allocated++;
+  }
+
+  /* allocating or resizing is done outside of the lock */
+  if (frame)
+    frame->reset (width, height);
+  else
+    frame = new VideoFrame (width, height);
+
+  return VideoFramePtr (frame, Recycler (shared_from_this ()));
+}
+
+VideoFramePtr
+VideoFramePool::acquire_copy (const char* data,
+                              unsigned width,
+                              unsigned height)
+{
+  VideoFramePtr frame = acquire (width, height);
+
+  memcpy (frame->get_data (), data, frame->get_size ());
+
+  return frame;
+}
+
+unsigned
+VideoFramePool::get_allocated () const
+{
+  PWaitAndSignal m(mutex);
+
+  return allocated;
+}
+
+void
+VideoFramePool::release (VideoFrame* frame)
+{
+  {
+    PWaitAndSignal m(mutex);
+
+    if (free_frames.size () < max_free) {
+
+      free_frames.push_back (frame);
+      return;
+    }
+  }
+
+  delete frame;
+}
+
+
+VideoFrameMailbox::VideoFrameMailbox ()
+  : write_index(0), read_index(1), state(2), published(0), dropped(0)
+{
+}
+
+int
+VideoFrameMailbox::exchange_state (int new_state)
+{
+  int old_state;
+
+  do {
+    old_state = g_atomic_int_get (&state);
+  } while (!g_atomic_int_compare_and_exchange (&state, old_state, new_state));
+
+  return old_state;
+}
+
+bool
+VideoFrameMailbox::publish (VideoFramePtr frame)
+{
+  PWaitAndSignal m(producers_mutex);
+  int old_state;
+
+  slots[write_index] = frame;
+  old_state = exchange_state (write_index | FRESH);
+  write_index = old_state & INDEX_MASK;
+
+  /* whatever we get back is either a dropped frame or one the consumer
+   * is done with : give it back to its pool right away */
+  slots[write_index].reset ();
+
+  g_atomic_int_inc (&published);
+  if (old_state & FRESH) {
+
+    g_atomic_int_inc (&dropped);
+    return true;
+  }
+
+  return false;
+}
+
+bool
+VideoFrameMailbox::take (VideoFramePtr & frame)
+{
+  int old_state;
+
+  if (!(g_atomic_int_get (&state) & FRESH))
+    return false;
+
+  old_state = exchange_state (read_index);
+  read_index = old_state & INDEX_MASK;
+
+  frame = slots[read_index];
+
+  return true;
+}
+
+unsigned
+VideoFrameMailbox::get_published () const
+{
+  return g_atomic_int_get (&published);
+}
+
+unsigned
+VideoFrameMailbox::get_dropped () const
+{
+  return g_atomic_int_get (&dropped);
+}
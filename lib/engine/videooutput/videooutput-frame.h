@@ -0,0 +1,252 @@
+
+/*
+ * Ekiga -- A VoIP and Video-Conferencing application
+ * Copyright (C) 2000-2009 Damien Sandras <dsandras@seconix.com>
+
+ * This program is free software; you can  redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version. This program is distributed in the hope
+ * that it will be useful, but WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Ekiga is licensed under the GPL license and as a special exception, you
+ * have permission to link or otherwise combine this program with the
+ * programs OPAL, OpenH323 and PWLIB, and distribute the combination, without
+ * applying the requirements of the GNU GPL to the OPAL, OpenH323 and PWLIB
+ * programs, as long as you do follow the requirements of the GNU GPL for all
+ * the rest of the software thus combined.
+ */
+
+
+/*
+ *                         videooutput-frame.h  -  description
+ *                         ------------------------------------------
+ *   begin                : written in 2012
+ *   copyright            : (c) 2012 by Damien Sandras
+ *   description          : Declaration of the reference-counted YUV420P
+ *                          frame buffers exchanged between the video
+ *                          producers and the VideoOutputManagers.
+ *
+ */
+
+#ifndef __VIDEOOUTPUT_FRAME_H__
+#define __VIDEOOUTPUT_FRAME_H__
+
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/weak_ptr.hpp>
+#include <boost/enable_shared_from_this.hpp>
+
+#include <glib.h>
+#include <ptlib.h>
+
+namespace Ekiga
+{
+
+/**
+ * @addtogroup videooutput
+ * @{
+ */
+
+  /** A YUV420P video frame buffer.
+   *
+   * Frames are obtained from a VideoFramePool, filled once by the producer
+   * (the OPAL decoder output or the preview thread) and then handed around by
+   * pointer: the producer, the VideoOutputCore and the display thread of each
+   * VideoOutputManager only ever exchange boost::shared_ptr<VideoFrame>. When
+   * the last reference goes away, the buffer goes back to its pool.
+   */
+  class VideoFrame
+  {
+  public:
+
+    VideoFrame (unsigned _width,
+                unsigned _height);
+
+    /** Returns the size in bytes of a YUV420P frame of the given dimensions.
+     */
+    static unsigned size_for (unsigned width,
+                              unsigned height)
+    { return (width * height * 3) >> 1; }
+
+    unsigned get_width () const
+    { return width; }
+
+    unsigned get_height () const
+    { return height; }
+
+    unsigned get_size () const
+    { return size_for (width, height); }
+
+    char* get_data ()
+    { return &buffer[0]; }
+
+    const char* get_data () const
+    { return &buffer[0]; }
+
+    /** Returns the time at which the frame was produced, in seconds on the
+     * clock of now(). It is the time the frame was acquired from its pool,
+     * unless the producer set a more accurate one.
+     */
+    double get_timestamp () const
+    { return timestamp; }
+
+    void set_timestamp (double _timestamp)
+    { timestamp = _timestamp; }
+
+    /** Returns the current time, in seconds, on the clock used for the
+     * frame timestamps. It can be used from any thread.
+     */
+    static double now ();
+
+  private:
+
+    friend class VideoFramePool;
+
+    /** Re-purposes the buffer for frames of the given dimensions,
+     * reallocating only when it has to grow.
+     */
+    void reset (unsigned _width,
+                unsigned _height);
+
+    unsigned width;
+    unsigned height;
+    double timestamp;
+    std::vector<char> buffer;
+  };
+
+  typedef boost::shared_ptr<VideoFrame> VideoFramePtr;
+
+
+  /** A pool of recycled VideoFrame buffers.
+   *
+   * The pool is thread-safe and is meant to be shared between the producer
+   * threads and the display thread; since a frame keeps only a weak reference
+   * to its pool, frames may safely outlive it.
+   */
+  class VideoFramePool
+    : public boost::enable_shared_from_this<VideoFramePool>
+  {
+  public:
+
+    /** The constructor
+     * @param max_free the number of unused buffers kept around for reuse.
+     */
+    VideoFramePool (unsigned max_free = 8);
+
+    ~VideoFramePool ();
+
+    /** Returns a frame of the given dimensions, recycling an unused
+     * buffer when one is available. The content of the frame is undefined.
+     * @param width the width in pixels of the frame.
+     * @param height the height in pixels of the frame.
+     * @return a frame which returns to the pool when released.
+     */
+    VideoFramePtr acquire (unsigned width,
+                           unsigned height);
+
+    /** Returns a frame holding a copy of the given YUV420P data.
+     * This is the single copy needed for producers which do not own the
+     * memory they are handed, like the OPAL decoder output.
+     */
+    VideoFramePtr acquire_copy (const char* data,
+                                unsigned width,
+                                unsigned height);
+
+    /** Returns the number of buffers allocated since the pool was created.
+     * It should stop growing once a stream has reached its steady state.
+     */
+    unsigned get_allocated () const;
+
+  private:
+
+    struct Recycler
+    {
+      Recycler (boost::weak_ptr<VideoFramePool> _pool): pool(_pool)
+      {}
+
+      void operator() (VideoFrame* frame);
+
+      boost::weak_ptr<VideoFramePool> pool;
+    };
+
+    void release (VideoFrame* frame);
+
+    std::vector<VideoFrame*> free_frames;
+    unsigned max_free;
+    unsigned allocated;
+    mutable PMutex mutex;
+  };
+
+  typedef boost::shared_ptr<VideoFramePool> VideoFramePoolPtr;
+
+
+  /** A "latest frame wins" mailbox for one video stream.
+   *
+   * This is a triple buffer: the producer always owns one slot, the consumer
+   * owns another one and the third slot is exchanged between them with a
+   * single atomic operation, so that neither side ever waits for the other.
+   * If the producer publishes a new frame before the consumer took the
+   * previous one, that previous frame is dropped and counted as such.
+   *
+   * Producers of the same stream are serialized among themselves, but never
+   * with the consumer, which has to be a single thread.
+   */
+  class VideoFrameMailbox
+  {
+  public:
+
+    VideoFrameMailbox ();
+
+    /** Makes the given frame the latest one of the stream.
+     * @param frame the frame to publish.
+     * @return true if a frame which had not been taken yet was replaced.
+     */
+    bool publish (VideoFramePtr frame);
+
+    /** Takes the latest frame of the stream, if there is a new one.
+     * @param frame is set to the new frame when there is one, and left
+     * untouched otherwise.
+     * @return true if a new frame was taken.
+     */
+    bool take (VideoFramePtr & frame);
+
+    /** Returns the number of frames published since the creation.
+     */
+    unsigned get_published () const;
+
+    /** Returns the number of frames which were replaced before the consumer
+     * could take them.
+     */
+    unsigned get_dropped () const;
+
+  private:
+
+    /* the state holds the index of the exchanged slot and a flag
+     * telling whether that slot holds a frame not taken yet */
+    enum { INDEX_MASK = 3, FRESH = 4 };
+
+    int exchange_state (int new_state);
+
+    VideoFramePtr slots[3];
+    int write_index;          /* owned by the producers */
+    int read_index;           /* owned by the consumer */
+    volatile gint state;      /* accessed atomically only */
+    mutable volatile gint published;
+    mutable volatile gint dropped;
+    PMutex producers_mutex;
+  };
+
+/**
+ * @}
+ */
+};
+
+#endif
@@ -101,6 +101,75 @@ namespace Ekiga {
     unsigned tx_frames;
   } VideoOutputStats;
 
+  /* Histogram of the latencies of the displayed frames, in milliseconds */
+  class VideoOutputLatency
+  {
+  public:
+
+    enum { NB_BUCKETS = 8 };
+
+    VideoOutputLatency () { reset (); }
+
+    void reset () {
+      for (unsigned i = 0 ; i < NB_BUCKETS ; i++)
+        buckets[i] = 0;
+      count = 0;
+      total = 0;
+      max = 0;
+    };
+
+    void add (double milliseconds) {
+      unsigned i = 0;
+      while (i < NB_BUCKETS - 1 && milliseconds >= get_bucket_limit (i))
+        i++;
+      buckets[i]++;
+      count++;
+      total += milliseconds;
+      if (milliseconds > max)
+        max = milliseconds;
+    };
+
+    /* Upper limit of the given bucket : 5, 10, 20 ... 320 ms, the last
+     * bucket holding everything above */
+    static double get_bucket_limit (unsigned bucket) {
+      return 5.0 * (1 << bucket);
+    };
+
+    double get_mean () const {
+      return count > 0 ? total / count : 0;
+    };
+
+    /* Upper limit of the bucket holding the given percentile */
+    double get_percentile (double percent) const {
+      unsigned seen = 0;
+      for (unsigned i = 0 ; i < NB_BUCKETS - 1 ; i++) {
+        seen += buckets[i];
+        if (seen * 100.0 >= percent * count)
+          return get_bucket_limit (i);
+      }
+      return max;
+    };
+
+    unsigned buckets[NB_BUCKETS];
+    unsigned count;
+    double total;
+    double max;
+  };
+
+  struct VideoOutputLatencyStats
+  {
+    VideoOutputLatencyStats () {
+      skipped_local = skipped_remote = skipped_ext = 0;
+    };
+
+    VideoOutputLatency capture_to_display; // local frames
+    VideoOutputLatency decode_to_display;  // remote and extended frames
+    VideoOutputLatency sync_wait;          // time spent in sync, waiting for vblank
+    unsigned skipped_local;
+    unsigned skipped_remote;
+    unsigned skipped_ext;
+  };
+
   class DisplayInfo
   {
   public:
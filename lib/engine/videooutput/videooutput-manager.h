@@ -42,6 +42,7 @@
 #include <boost/bind.hpp>
 
 #include "videooutput-info.h"
+#include "videooutput-frame.h"
 
 namespace Ekiga
 {
@@ -96,9 +97,29 @@ namespace Ekiga
                                    unsigned type,
                                    int devices_nbr) = 0;
 
+      /** Set one video frame by reference.
+       * Requires the device to be opened.
+       * The manager keeps a reference to the frame for as long as it needs it,
+       * so that the producer does not have to wait for the frame to be displayed.
+       * The default implementation falls back to set_frame_data().
+       * @param frame the YUV420P frame to be displayed.
+       * @param type the type of the frame: 0 - local video source or >0 from the remote end.
+       * @param devices_nbr 1 if only local or remote device has been opened, 2 if both have been opened.
+       */
+      virtual void set_frame (VideoFramePtr frame,
+                              unsigned type,
+                              int devices_nbr)
+      { set_frame_data (frame->get_data (), frame->get_width (), frame->get_height (), type, devices_nbr); }
+
       virtual void set_display_info (const DisplayInfo &) { };
       virtual void set_ext_display_info (const DisplayInfo &) { };
 
+      /** Get the latencies of the frames displayed since the device was opened.
+       * @param stats the struct to be filled with the current values.
+       * @return false if the manager doesn't measure them.
+       */
+      virtual bool get_latency_stats (VideoOutputLatencyStats & /*stats*/) { return false; };
+
 
       /*** API to act on VideoOutputDevice events ***/
 
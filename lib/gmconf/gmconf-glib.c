@@ -65,6 +65,9 @@
  * - the implementation of gmconf.h's api.
  */
 
+/* the size from which the journal is folded into the database */
+#define GM_CONF_JOURNAL_MAX_SIZE (64 * 1024)
+
 #define check_entry_type_return(entry,_type,val) G_STMT_START{ \
   if (G_LIKELY(entry != NULL && entry->type == _type)) \
     {} \
@@ -94,11 +97,14 @@
 
 /* this is the main structure, in which all known entries are stored
  * we just store them as a list, with a boolean to know if we should trigger
- * the notifiers or not
+ * the notifiers or not ; the entries changed since the last save are kept
+ * apart, so that a save only has to write those
  */
 typedef struct _DataBase
 {
   GData *entries;
+  GSList *dirty;
+  gsize journal_size;
 } DataBase;
 
 /* for that implementation, a notifier is the function to call, together with
@@ -127,6 +133,7 @@ struct _GmConfEntry
     GmConfEntry *redirect; /* for GM_CONF_OTHER entries */
   } value;
   GSList *notifiers;
+  gboolean dirty; /* whether it is in the database's dirty list */
 };
 
 /* those data types are just for the loading of the gconf schema:
@@ -170,6 +177,7 @@ typedef struct _NamespcWrapper
  */
 static GSList *string_list_deep_copy (const GSList *);
 static void string_list_deep_destroy (GSList *);
+static gboolean string_list_equal (const GSList *, const GSList *);
 
 static gchar *string_from_bool (const gboolean);
 static gchar *string_from_int (const gint);
@@ -243,9 +251,14 @@ static const GMarkupParser sch_parser = {
 };
 
 static gboolean database_load_file (DataBase *, const gchar *);
-static void database_save_entry (GQuark quark, gpointer data,
-				 gpointer user_data);
-static gboolean database_save_file (DataBase *, const gchar *);
+static void database_save_entry (const GmConfEntry *, GString *);
+static void database_save_entry_in_list (GQuark quark, gpointer data,
+					 gpointer user_data);
+static gboolean database_save_file (DataBase *, const gchar *,
+				    const gchar *);
+static gboolean database_save_journal (DataBase *, const gchar *);
+static void database_mark_dirty (DataBase *, GmConfEntry *);
+static void database_clear_dirty (DataBase *);
 static void database_add_entry (DataBase *, GmConfEntry *);
 static GmConfEntry *database_get_entry_for_key (DataBase *, const gchar *);
 static GmConfEntry *database_get_entry_for_key_create (DataBase *,
@@ -257,6 +270,7 @@ static void database_notify_on_namespace (DataBase *, const gchar *);
  * Configuration file functions
  */
 static gchar *gm_conf_get_user_conf_filename ();
+static gchar *gm_conf_get_user_journal_filename ();
 static gboolean gm_conf_load_user_conf (DataBase *);
 static gboolean gm_conf_load_sys_conf (DataBase *);
 
@@ -284,6 +298,17 @@ string_list_deep_destroy (GSList *list)
 }
 
 
+static gboolean
+string_list_equal (const GSList *a,
+		   const GSList *b)
+{
+  for (; a != NULL && b != NULL; a = a->next, b = b->next)
+    if (g_strcmp0 ((const gchar *)a->data, (const gchar *)b->data) != 0)
+      return FALSE;
+
+  return a == NULL && b == NULL;
+}
+
 static gchar *
 string_from_bool (const gboolean val)
 {
@@ -481,6 +506,7 @@ entry_new ()
   entry->type = GM_CONF_OTHER;
   entry->value.redirect = NULL;
   entry->notifiers = NULL;
+  entry->dirty = FALSE;
   return entry;
 }
 
@@ -495,6 +521,12 @@ entry_destroy (gpointer ent)
 
   entry = (GmConfEntry *)ent;
 
+  if (entry->dirty) {
+
+    DataBase *db = database_get_default ();
+    db->dirty = g_slist_remove (db->dirty, entry);
+  }
+
   g_free (entry->key);
 
   switch (entry->type) {
@@ -712,12 +744,15 @@ database_new ()
   db = g_new (DataBase, 1);
   db->entries = NULL;
   g_datalist_init (&db->entries);
+  db->dirty = NULL;
+  db->journal_size = 0;
   return db;
 }
 
 static void
 database_destroy (DataBase *db)
 {
+  database_clear_dirty (db);
   g_datalist_clear (&db->entries);
   g_free (db);
 }
@@ -840,16 +875,16 @@ database_load_file (DataBase *db,
 {
   SchParser *parser = NULL;
   GMarkupParseContext *context = NULL;
-  GIOChannel *io = NULL;
-  GIOStatus status;
-  gchar buffer[4096];
-  gsize len = 0;
+  GMappedFile *file = NULL;
+  gboolean result = FALSE;
 
   g_return_val_if_fail (db != NULL, FALSE);
   g_return_val_if_fail (filename != NULL, FALSE);
 
-  io = g_io_channel_new_file (filename, "r", NULL);
-  if (!io)
+  /* the file is mapped and parsed at once, instead of being copied
+   * chunk by chunk to the parser */
+  file = g_mapped_file_new (filename, FALSE, NULL);
+  if (!file)
     return FALSE;
   parser = g_new (SchParser, 1);
   parser->state = START;
@@ -857,80 +892,62 @@ database_load_file (DataBase *db,
   parser->entry = NULL;
   context = g_markup_parse_context_new (&sch_parser, 0,
 					(gpointer)parser, g_free);
-  g_io_channel_set_encoding (io, "UTF-8", NULL); /* useful? */
-  while (TRUE)
-    {
-      status = g_io_channel_read_chars (io, buffer, sizeof (buffer),
-					&len, NULL);
-      switch (status)
-        {
-        case G_IO_STATUS_ERROR:
-	  g_io_channel_unref (io);
-          return FALSE;
-        case G_IO_STATUS_EOF:
-	  g_io_channel_unref (io);
-          return g_markup_parse_context_end_parse (context, NULL);
-        case G_IO_STATUS_NORMAL:
-        case G_IO_STATUS_AGAIN:
-	default:
-          break;
-        }
-      if (!g_markup_parse_context_parse (context, buffer, len, NULL))
-	{
-	  g_io_channel_unref (io);
-	  return FALSE;
-	}
-    }
-  /* does it ever come here? */
-  g_io_channel_unref (io);
-  return TRUE;
+
+  /* an empty file is mapped to NULL */
+  if (g_mapped_file_get_length (file) > 0)
+    result = g_markup_parse_context_parse (context,
+					   g_mapped_file_get_contents (file),
+					   g_mapped_file_get_length (file),
+					   NULL);
+  if (result)
+    result = g_markup_parse_context_end_parse (context, NULL);
+
+  g_markup_parse_context_free (context);
+  g_mapped_file_unref (file);
+
+  return result;
 }
 
 static void
-database_save_entry (G_GNUC_UNUSED GQuark quark,
-		     gpointer data,
-		     gpointer user_data)
+database_save_entry (const GmConfEntry *entry,
+		     GString *contents)
 {
-  GmConfEntry *entry = NULL;
-  GIOChannel *io = NULL;
   gchar *value = NULL;
   gchar *txt = NULL;
 
-  g_return_if_fail (data != NULL);
-  g_return_if_fail (user_data != NULL);
+  g_return_if_fail (entry != NULL);
+  g_return_if_fail (contents != NULL);
 
-  entry = (GmConfEntry *)data;
-  io = (GIOChannel *)user_data;
-  g_io_channel_write_chars (io, "<schema>\n", -1, NULL, NULL);
+  g_string_append (contents, "<schema>\n");
 
-  g_io_channel_write_chars (io, "<applyto>", -1, NULL, NULL);
-  g_io_channel_write_chars (io, entry_get_key (entry), -1, NULL, NULL);
-  g_io_channel_write_chars (io, "</applyto>\n", -1, NULL, NULL);
+  g_string_append (contents, "<applyto>");
+  g_string_append (contents, entry_get_key (entry));
+  g_string_append (contents, "</applyto>\n");
 
-  g_io_channel_write_chars (io, "<type>", -1, NULL, NULL);
+  g_string_append (contents, "<type>");
   switch (entry_get_type (entry)) {
   case GM_CONF_OTHER:
-    g_io_channel_write_chars (io, "other", -1, NULL, NULL);
+    g_string_append (contents, "other");
     break;
   case GM_CONF_BOOL:
-    g_io_channel_write_chars (io, "bool", -1, NULL, NULL);
+    g_string_append (contents, "bool");
     break;
   case GM_CONF_INT:
-    g_io_channel_write_chars (io, "int", -1, NULL, NULL);
+    g_string_append (contents, "int");
     break;
   case GM_CONF_STRING:
-    g_io_channel_write_chars (io, "string", -1, NULL, NULL);
+    g_string_append (contents, "string");
     break;
   case GM_CONF_LIST:
-    g_io_channel_write_chars (io, "list", -1, NULL, NULL);
+    g_string_append (contents, "list");
     break;
   default:
-    g_io_channel_write_chars (io, "unknown", -1, NULL, NULL);
+    g_string_append (contents, "unknown");
     break;
   }
-  g_io_channel_write_chars (io, "</type>\n", -1, NULL, NULL);
+  g_string_append (contents, "</type>\n");
 
-  g_io_channel_write_chars (io, "<default>", -1, NULL, NULL);
+  g_string_append (contents, "<default>");
   switch (entry_get_type (entry)) {
   case GM_CONF_OTHER:
     value = g_strdup ("none");
@@ -958,41 +975,128 @@ database_save_entry (G_GNUC_UNUSED GQuark quark,
     value = g_strdup ("unknown");
     break;
   }
-  g_io_channel_write_chars (io, value, -1, NULL, NULL);
+  g_string_append (contents, value);
   g_free (value);
-  g_io_channel_write_chars (io, "</default>\n", -1, NULL, NULL);
+  g_string_append (contents, "</default>\n");
 
-  g_io_channel_write_chars (io, "</schema>\n", -1, NULL, NULL);
+  g_string_append (contents, "</schema>\n");
 }
 
+static void
+database_save_entry_in_list (G_GNUC_UNUSED GQuark quark,
+			     gpointer data,
+			     gpointer user_data)
+{
+  g_return_if_fail (data != NULL);
+  g_return_if_fail (user_data != NULL);
+
+  database_save_entry ((GmConfEntry *)data, (GString *)user_data);
+}
+
+/* writes the whole database, and folds the journal into it */
 static gboolean
 database_save_file (DataBase *db,
-		    const gchar *filename)
+		    const gchar *filename,
+		    const gchar *journal)
 {
-  GIOChannel *io = NULL;
+  GString *contents = NULL;
   gchar *dirname = NULL;
+  gboolean result = FALSE;
 
   g_return_val_if_fail (db != NULL, FALSE);
   g_return_val_if_fail (filename != NULL, FALSE);
+  g_return_val_if_fail (journal != NULL, FALSE);
 
   dirname = g_path_get_dirname (filename);
   if (!g_file_test (dirname, G_FILE_TEST_IS_DIR)) {
-    if (!g_mkdir_with_parents (dirname, S_IRWXU))
+    if (g_mkdir_with_parents (dirname, S_IRWXU) != 0)
       g_warning ("Unable to create directory %s\n", dirname);
   }
   g_free (dirname);
 
-  io = g_io_channel_new_file (filename, "w", NULL);
+  contents = g_string_new (NULL);
+  g_datalist_foreach (&db->entries, database_save_entry_in_list, contents);
 
-  if (io) {
+  /* g_file_set_contents writes to a temporary file first, so a crash
+   * leaves either the old or the new database */
+  result = g_file_set_contents (filename, contents->str, contents->len, NULL);
+  g_string_free (contents, TRUE);
 
-    g_datalist_foreach (&db->entries, database_save_entry, io);
-    g_io_channel_unref (io);
+  if (result) {
+
+    g_unlink (journal);
+    db->journal_size = 0;
+    database_clear_dirty (db);
   }
   else
     g_warning ("Couldn't save conf database in %s\n", filename);
 
-  return TRUE;
+  return result;
+}
+
+/* appends the entries changed since the last save to the journal, in the
+ * format of the database itself : loading the journal after the database
+ * replaces those entries */
+static gboolean
+database_save_journal (DataBase *db,
+		       const gchar *journal)
+{
+  GString *contents = NULL;
+  GSList *ptr = NULL;
+  FILE *file = NULL;
+  gboolean result = FALSE;
+
+  g_return_val_if_fail (db != NULL, FALSE);
+  g_return_val_if_fail (journal != NULL, FALSE);
+
+  contents = g_string_new (NULL);
+  for (ptr = db->dirty; ptr != NULL; ptr = ptr->next)
+    database_save_entry ((GmConfEntry *)ptr->data, contents);
+
+  file = g_fopen (journal, "ab");
+  if (file) {
+
+    result = (fwrite (contents->str, 1, contents->len, file) == contents->len);
+    if (fclose (file) != 0)
+      result = FALSE;
+  }
+
+  /* even a partial write grew the file */
+  db->journal_size += contents->len;
+  g_string_free (contents, TRUE);
+
+  if (result)
+    database_clear_dirty (db);
+
+  return result;
+}
+
+static void
+database_mark_dirty (DataBase *db,
+		     GmConfEntry *entry)
+{
+  g_return_if_fail (db != NULL);
+  g_return_if_fail (entry != NULL);
+
+  if (!entry->dirty) {
+
+    entry->dirty = TRUE;
+    db->dirty = g_slist_prepend (db->dirty, entry);
+  }
+}
+
+static void
+database_clear_dirty (DataBase *db)
+{
+  GSList *ptr = NULL;
+
+  g_return_if_fail (db != NULL);
+
+  for (ptr = db->dirty; ptr != NULL; ptr = ptr->next)
+    ((GmConfEntry *)ptr->data)->dirty = FALSE;
+
+  g_slist_free (db->dirty);
+  db->dirty = NULL;
 }
 
 static void
@@ -1096,16 +1200,43 @@ gm_conf_get_user_conf_filename ()
 }
 
 
+static gchar *
+gm_conf_get_user_journal_filename ()
+{
+  gchar *filename = NULL;
+  gchar *journal = NULL;
+
+  filename = gm_conf_get_user_conf_filename ();
+  journal = g_strconcat (filename, ".journal", NULL);
+  g_free (filename);
+
+  return journal;
+}
+
+
 static gboolean
 gm_conf_load_user_conf (DataBase *db)
 {
   gchar *filename = NULL;
+  gchar *journal = NULL;
   gboolean result = FALSE;
 
   g_return_val_if_fail (db != NULL, FALSE);
 
   filename = gm_conf_get_user_conf_filename ();
+  journal = gm_conf_get_user_journal_filename ();
   result = database_load_file (db, filename);
+
+  /* what was changed after the last full save ; a record cut by a crash
+   * stops the parsing, but the ones before it are kept, and the journal is
+   * folded into the database right away */
+  if (g_file_test (journal, G_FILE_TEST_EXISTS)) {
+
+    database_load_file (db, journal);
+    database_save_file (db, filename, journal);
+  }
+
+  g_free (journal);
   g_free (filename);
 
   return result;
@@ -1137,10 +1268,23 @@ saveconf_timer_callback (G_GNUC_UNUSED gpointer unused)
 {
   DataBase *db = database_get_default ();
   gchar *user_conf = NULL;
+  gchar *journal = NULL;
+
+  /* nothing changed : nothing to do */
+  if (db->dirty == NULL)
+    return TRUE;
 
   user_conf = gm_conf_get_user_conf_filename ();
-  database_save_file (db, user_conf);
+  journal = gm_conf_get_user_journal_filename ();
 
+  /* the changes are appended to the journal, until it is big enough to be
+   * worth folding into the database ; a journal which couldn't be written
+   * properly is folded right away */
+  if (db->journal_size >= GM_CONF_JOURNAL_MAX_SIZE
+      || !database_save_journal (db, journal))
+    database_save_file (db, user_conf, journal);
+
+  g_free (journal);
   g_free (user_conf);
 
   return TRUE;
@@ -1176,11 +1320,17 @@ gm_conf_save ()
 {
   DataBase *db = database_get_default ();
   gchar *user_conf = NULL;
+  gchar *journal = NULL;
+
+  if (db->dirty == NULL && db->journal_size == 0)
+    return;
 
   user_conf = gm_conf_get_user_conf_filename ();
+  journal = gm_conf_get_user_journal_filename ();
 
-  database_save_file (db, user_conf);
+  database_save_file (db, user_conf, journal);
 
+  g_free (journal);
   g_free (user_conf);
 }
 
@@ -1283,6 +1433,8 @@ gm_conf_set_bool (const gchar *key,
 
   g_return_if_fail (entry != NULL);
 
+  if (entry_get_type (entry) != GM_CONF_BOOL || entry->value.boolean != val)
+    database_mark_dirty (db, entry);
   entry_set_bool (entry, val);
   database_notify_on_namespace (db, entry_get_key (entry));
 }
@@ -1315,6 +1467,8 @@ gm_conf_set_int (const gchar *key,
 
   g_return_if_fail (entry != NULL);
 
+  if (entry_get_type (entry) != GM_CONF_INT || entry->value.integer != val)
+    database_mark_dirty (db, entry);
   entry_set_int (entry, val);
   database_notify_on_namespace (db, entry_get_key (entry));
 }
@@ -1347,6 +1501,9 @@ gm_conf_set_string (const gchar *key,
 
   g_return_if_fail (entry != NULL);
 
+  if (entry_get_type (entry) != GM_CONF_STRING
+      || g_strcmp0 (entry->value.string, val) != 0)
+    database_mark_dirty (db, entry);
   entry_set_string (entry, val);
   database_notify_on_namespace (db, entry_get_key (entry));
 }
@@ -1379,6 +1536,9 @@ gm_conf_set_string_list (const gchar *key,
 
   g_return_if_fail (entry != NULL);
 
+  if (entry_get_type (entry) != GM_CONF_LIST
+      || !string_list_equal (entry->value.list, val))
+    database_mark_dirty (db, entry);
   entry_set_list (entry, val);
   database_notify_on_namespace (db, entry_get_key (entry));
 }
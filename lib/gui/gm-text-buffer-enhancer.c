@@ -145,8 +145,10 @@ gm_text_buffer_enhancer_insert_text (GmTextBufferEnhancer* self,
   gint best_length = 0;
   GSList* helper_ptr = NULL;
   GmTextBufferEnhancerHelper* considered_helper = NULL;
-  gint considered_start = 0;
-  gint considered_length = 0;
+  guint n_helpers = 0;
+  guint helper = 0;
+  gint* found_starts = NULL;
+  gint* found_lengths = NULL;
   GSList* tag_ptr = NULL;
   GtkTextMark* mark = NULL;
   GtkTextIter tag_start_iter;
@@ -164,6 +166,16 @@ gm_text_buffer_enhancer_insert_text (GmTextBufferEnhancer* self,
 
   mark = gtk_text_buffer_create_mark (priv->buffer, NULL, iter, TRUE);
 
+  /* what each helper found last : the first match after a position is
+   * still the first one after any later position before it, so a helper
+   * is only asked again once the text went past its match -- hence each
+   * helper goes through the text about once */
+  n_helpers = g_slist_length (priv->helpers);
+  found_starts = g_new (gint, n_helpers);
+  found_lengths = g_new (gint, n_helpers);
+  for (helper = 0; helper < n_helpers; helper++)
+    found_starts[helper] = -1;
+
   while (position < length) {
 
     /* try to find the best helper,
@@ -171,24 +183,35 @@ gm_text_buffer_enhancer_insert_text (GmTextBufferEnhancer* self,
     best_helper = NULL;
     best_start = length;
     best_length = 0;
-    for (helper_ptr = priv->helpers ;
+    for (helper_ptr = priv->helpers, helper = 0 ;
 	 helper_ptr != NULL ;
-	 helper_ptr = g_slist_next (helper_ptr)) {
+	 helper_ptr = g_slist_next (helper_ptr), helper++) {
 
       considered_helper
 	= GM_TEXT_BUFFER_ENHANCER_HELPER (helper_ptr->data);
-      gm_text_buffer_enhancer_helper_check (considered_helper,
-					    text, position,
-					    &considered_start,
-					    &considered_length);
-      if (((considered_start < best_start)
-	   && (considered_length > 0))
-	  || ((considered_start == best_start)
-	      && (considered_length > best_length))) {
+
+      if (found_starts[helper] < position) {
+
+	found_starts[helper] = length;
+	found_lengths[helper] = 0;
+	gm_text_buffer_enhancer_helper_check (considered_helper,
+					      text, position,
+					      &found_starts[helper],
+					      &found_lengths[helper]);
+
+	/* nothing more to find for that one */
+	if (found_lengths[helper] <= 0)
+	  found_starts[helper] = length;
+      }
+
+      if (((found_starts[helper] < best_start)
+	   && (found_lengths[helper] > 0))
+	  || ((found_starts[helper] == best_start)
+	      && (found_lengths[helper] > best_length))) {
 
 	best_helper = considered_helper;
-	best_start = considered_start;
-	best_length = considered_length;
+	best_start = found_starts[helper];
+	best_length = found_lengths[helper];
       }
     }
 
@@ -225,4 +248,6 @@ gm_text_buffer_enhancer_insert_text (GmTextBufferEnhancer* self,
 
   gtk_text_buffer_delete_mark (priv->buffer, mark);
   g_slist_free (active_tags);
+  g_free (found_lengths);
+  g_free (found_starts);
 }
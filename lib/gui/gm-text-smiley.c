@@ -64,6 +64,9 @@ G_DEFINE_TYPE_EXTENDED (GmTextSmiley, gm_text_smiley, G_TYPE_OBJECT, 0,
 			G_IMPLEMENT_INTERFACE (GM_TYPE_TEXT_BUFFER_ENHANCER_HELPER,
 					       enhancer_helper_interface_init));
 
+/* the bytes a smiley can start with */
+static gboolean smiley_starts[256];
+
 /* implementation of the GmTextBufferEnhancerHelperInterface code */
 
 static void
@@ -74,40 +77,45 @@ enhancer_helper_check (G_GNUC_UNUSED GmTextBufferEnhancerHelper* self,
 		       gint* length)
 {
   const gchar **smileys = gm_get_smileys ();
+  const gchar* ptr = NULL;
   gint smiley = 0;
-  gint best_start = 0;
   gint best_smiley = -1;
-  char* found = NULL;
-  gint found_start = 0;
+  gsize best_length = 0;
+  gsize smiley_length = 0;
 
-  /* all smileys are checked, and the one chosen is:
+  /* the text is walked once, and the smiley chosen is:
      - the one which starts the soonest;
      - in case of equality, the one which is the longest.
+     Only the places where a smiley can start are compared with them.
   */
-  for (smiley = 0;
-       smileys[smiley] != NULL;
-       smiley = smiley + 2) {
+  for (ptr = full_text + from;
+       *ptr != '\0';
+       ptr++) {
 
-    found = strstr (full_text + from, smileys[smiley]);
-    if (found != NULL) {
+    if (!smiley_starts[(guchar) *ptr])
+      continue;
 
-      found_start = found - full_text;
-      if ((best_smiley == -1)
-          || (found_start < best_start)
-	  || ((found_start == best_start)
-	      && (strlen (smileys[smiley]) > strlen (smileys[best_smiley])))) {
+    for (smiley = 0;
+	 smileys[smiley] != NULL;
+	 smiley = smiley + 2) {
+
+      smiley_length = strlen (smileys[smiley]);
+      if (smiley_length > best_length
+	  && strncmp (ptr, smileys[smiley], smiley_length) == 0) {
 
 	best_smiley = smiley;
-	best_start = found_start;
+	best_length = smiley_length;
       }
     }
-  }
 
+    if (best_smiley != -1)
+      break;
+  }
 
   if (best_smiley != -1) {
 
-    *start = best_start;
-    *length = strlen (smileys[best_smiley]);
+    *start = ptr - full_text;
+    *length = best_length;
   } else
     *length = 0;
 }
@@ -163,6 +171,13 @@ enhancer_helper_interface_init (GmTextBufferEnhancerHelperInterface* iface)
 static void
 gm_text_smiley_class_init (G_GNUC_UNUSED GmTextSmileyClass* g_class)
 {
+  const gchar **smileys = gm_get_smileys ();
+  gint smiley = 0;
+
+  for (smiley = 0;
+       smileys[smiley] != NULL;
+       smiley = smiley + 2)
+    smiley_starts[(guchar) smileys[smiley][0]] = TRUE;
 }
 
 static void
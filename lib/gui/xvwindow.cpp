@@ -245,67 +245,75 @@ XVWindow::Init (Display* dp,
 }
 
 
-void 
-XVWindow::PutFrame (uint8_t* frame, 
-                    uint16_t width, 
-                    uint16_t height)
+void
+XVWindow::CopyFrame (XvImage* image,
+                     const uint8_t* frame)
 {
-  if (!_XVImage[_curBuffer]) 
-    return;
-  
-  if (width != _XVImage[_curBuffer]->width || height != _XVImage[_curBuffer]->height) {
-     PTRACE (1, "XVideo\tDynamic switching of resolution not supported\n");
-     return;
-  }
-
-  XLockDisplay (_display);
-
-  if (_XVImage[_curBuffer]->pitches [0] ==_XVImage[_curBuffer]->width
-      && _XVImage[_curBuffer]->pitches [2] == (int) (_XVImage[_curBuffer]->width / 2) 
-      && _XVImage[_curBuffer]->pitches [1] == (int) (_XVImage[_curBuffer]->width / 2)) {
+  if (image->pitches [0] ==image->width
+      && image->pitches [2] == (int) (image->width / 2) 
+      && image->pitches [1] == (int) (image->width / 2)) {
   
-    memcpy (_XVImage[_curBuffer]->data, 
+    memcpy (image->data, 
             frame, 
-            (int) (_XVImage[_curBuffer]->width * _XVImage[_curBuffer]->height));
-    memcpy (_XVImage[_curBuffer]->data + (int) (_XVImage[_curBuffer]->width * _XVImage[_curBuffer]->height), 
-            frame + _XVImage[_curBuffer]->offsets [2], 
-            (int) (_XVImage[_curBuffer]->width * _XVImage[_curBuffer]->height / 4));
-    memcpy (_XVImage[_curBuffer]->data + (int) (_XVImage[_curBuffer]->width * _XVImage[_curBuffer]->height * 5 / 4), 
-            frame + _XVImage[_curBuffer]->offsets [1], 
-            (int) (_XVImage[_curBuffer]->width * _XVImage[_curBuffer]->height / 4));
+            (int) (image->width * image->height));
+    memcpy (image->data + (int) (image->width * image->height), 
+            frame + image->offsets [2], 
+            (int) (image->width * image->height / 4));
+    memcpy (image->data + (int) (image->width * image->height * 5 / 4), 
+            frame + image->offsets [1], 
+            (int) (image->width * image->height / 4));
   } 
   else {
   
     unsigned int i = 0;
-    int width2 = (int) (_XVImage[_curBuffer]->width / 2);
+    int width2 = (int) (image->width / 2);
 
-    uint8_t* dstY = (uint8_t*) _XVImage[_curBuffer]->data;
-    uint8_t* dstV = (uint8_t*) _XVImage[_curBuffer]->data + (_XVImage[_curBuffer]->pitches [0] * _XVImage[_curBuffer]->height);
-    uint8_t* dstU = (uint8_t*) _XVImage[_curBuffer]->data + (_XVImage[_curBuffer]->pitches [0] * _XVImage[_curBuffer]->height) 
-                                              + (_XVImage[_curBuffer]->pitches [1] * (_XVImage[_curBuffer]->height/2));
+    uint8_t* dstY = (uint8_t*) image->data;
+    uint8_t* dstV = (uint8_t*) image->data + (image->pitches [0] * image->height);
+    uint8_t* dstU = (uint8_t*) image->data + (image->pitches [0] * image->height) 
+                                              + (image->pitches [1] * (image->height/2));
 
-    uint8_t* srcY = frame;
-    uint8_t* srcV = frame + (int) (_XVImage[_curBuffer]->width * _XVImage[_curBuffer]->height * 5 / 4);
-    uint8_t* srcU = frame + (int) (_XVImage[_curBuffer]->width * _XVImage[_curBuffer]->height);
+    const uint8_t* srcY = frame;
+    const uint8_t* srcV = frame + (int) (image->width * image->height * 5 / 4);
+    const uint8_t* srcU = frame + (int) (image->width * image->height);
 
-    for (i = 0 ; i < (unsigned int)_XVImage[_curBuffer]->height ; i+=2) {
+    for (i = 0 ; i < (unsigned int)image->height ; i+=2) {
 
-      memcpy (dstY, srcY, _XVImage[_curBuffer]->width); 
-      dstY +=_XVImage[_curBuffer]->pitches [0]; 
-      srcY +=_XVImage[_curBuffer]->width;
+      memcpy (dstY, srcY, image->width); 
+      dstY +=image->pitches [0]; 
+      srcY +=image->width;
       
-      memcpy (dstY, srcY, _XVImage[_curBuffer]->width); 
-      dstY +=_XVImage[_curBuffer]->pitches [0]; 
-      srcY +=_XVImage[_curBuffer]->width;
+      memcpy (dstY, srcY, image->width); 
+      dstY +=image->pitches [0]; 
+      srcY +=image->width;
       
       memcpy (dstV, srcV, width2); 
-      dstV +=_XVImage[_curBuffer]->pitches [1]; 
+      dstV +=image->pitches [1]; 
       srcV += width2;
       
-      memcpy(dstU, srcU, width2); dstU+=_XVImage[_curBuffer]->pitches [2]; 
+      memcpy(dstU, srcU, width2); dstU+=image->pitches [2]; 
       srcU += width2;
     }
   }
+}
+
+void 
+XVWindow::PutFrame (uint8_t* frame, 
+                    uint16_t width, 
+                    uint16_t height)
+{
+  if (!_XVImage[_curBuffer]) 
+    return;
+  
+  if (width != _XVImage[_curBuffer]->width || height != _XVImage[_curBuffer]->height) {
+     PTRACE (1, "XVideo\tDynamic switching of resolution not supported\n");
+     return;
+  }
+
+  XLockDisplay (_display);
+
+  CopyFrame (_XVImage[_curBuffer], frame);
+
 #ifdef HAVE_SHM
   if (_useShm) 
   {
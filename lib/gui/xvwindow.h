@@ -96,6 +96,15 @@ public:
 
   virtual void Sync();
 
+  /**
+   * Copy a YUV420P frame into an XvImage of the same dimensions,
+   * following the pitches of its planes.
+   * This is the part of PutFrame which doesn't need the X server,
+   * exposed so that it can be measured on its own.
+   */
+  static void CopyFrame (XvImage *image,
+                         const uint8_t *frame);
+
 private:
   unsigned int _XVPort;
   XvImage * _XVImage[NUM_BUFFERS];
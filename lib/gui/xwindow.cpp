@@ -42,6 +42,7 @@
 
 extern "C" {
 #include <pixops.h>
+#include <yuv-scale.h>
 }
 
 #ifdef HAVE_SHM
@@ -125,6 +126,8 @@ XWindow::XWindow()
   _outOffset = 0;
    snprintf (_colorFormat, sizeof(_colorFormat), "NONE");
   _planes = 0;
+  _yuvScale = false;
+  _yuvScaleBgr = false;
   _colorConverter = NULL;
 
 #ifdef HAVE_SHM
@@ -263,6 +266,15 @@ XWindow::Init (Display* dp,
   PTRACE(4, "X11\tUsing color format: " << _colorFormat);
   PTRACE(4, "X11\tPlanes: " << _planes);
 
+  _yuvScale = (_planes == 4
+               && (_imageWidth % 2) == 0 && (_imageHeight % 2) == 0
+               && (g_strcmp0 (_colorFormat, "RGB32") == 0
+                   || g_strcmp0 (_colorFormat, "BGR32") == 0));
+  _yuvScaleBgr = (g_strcmp0 (_colorFormat, "BGR32") == 0);
+  PTRACE(4, "X11\tFused YUV420P conversion and scaling: "
+         << (_yuvScale ? "yes" : "no")
+         << ", CPU path: " << pixops_yuv420p_scale_get_cpu ());
+
   PVideoFrameInfo srcFrameInfo, dstFrameInfo;
   srcFrameInfo.SetFrameSize(_imageWidth,_imageHeight);
   dstFrameInfo.SetFrameSize(_imageWidth,_imageHeight);
@@ -300,25 +312,41 @@ XWindow::PutFrame (uint8_t* frame,
   if ((_state.curWidth != _XImage->width) || (_state.curHeight!=_XImage->height))
     CreateXImage(_state.curWidth, _state.curHeight);
 
-  _colorConverter->Convert((BYTE*)frame, (BYTE*)_frameBuffer.get ());
-
-  pixops_scale ((guchar*) _XImage->data,
-                 0,0,
-                 _state.curWidth, _state.curHeight,
-                 _state.curWidth * _planes, //dest_rowstride
-                 _planes,                   //dest_channels,
-                 FALSE,                     //dest_has_alpha,
-
-		(const guchar*) _frameBuffer.get (),
-                 width,
-                 height,
-                 width * _planes,           //src_rowstride
-                 _planes,                   //src_channels,
-                 FALSE,                     //src_has_alpha,
-
-                 (double) _state.curWidth / width,
-                 (double) _state.curHeight / height,
-                 (PixopsInterpType) _scalingAlgorithm);
+  if (_yuvScale
+      && pixops_yuv420p_scale_supports ((PixopsInterpType) _scalingAlgorithm)) {
+
+    // converting while scaling touches each destination pixel only once
+    pixops_yuv420p_scale ((guchar*) _XImage->data,
+                          _state.curWidth, _state.curHeight,
+                          _state.curWidth * _planes, //dest_rowstride
+                          _yuvScaleBgr,
+                          (const guchar*) frame,
+                          width,
+                          height,
+                          (PixopsInterpType) _scalingAlgorithm);
+  }
+  else {
+
+    _colorConverter->Convert((BYTE*)frame, (BYTE*)_frameBuffer.get ());
+
+    pixops_scale ((guchar*) _XImage->data,
+                   0,0,
+                   _state.curWidth, _state.curHeight,
+                   _state.curWidth * _planes, //dest_rowstride
+                   _planes,                   //dest_channels,
+                   FALSE,                     //dest_has_alpha,
+
+                   (const guchar*) _frameBuffer.get (),
+                   width,
+                   height,
+                   width * _planes,           //src_rowstride
+                   _planes,                   //src_channels,
+                   FALSE,                     //src_has_alpha,
+
+                   (double) _state.curWidth / width,
+                   (double) _state.curHeight / height,
+                   (PixopsInterpType) _scalingAlgorithm);
+  }
 
        _XImage->data += _outOffset;
 #ifdef HAVE_SHM
@@ -243,6 +243,8 @@ private:
   int _outOffset;
   char _colorFormat[6];
   int _planes;
+  bool _yuvScale;      // the XImage format allows the fused conversion and scaling
+  bool _yuvScaleBgr;
 
   PColourConverter* _colorConverter;
   boost::shared_ptr<void> _frameBuffer;
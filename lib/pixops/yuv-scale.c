@@ -0,0 +1,590 @@
+/* Ekiga -- A VoIP and Video-Conferencing application
+ * Copyright (C) 2000-2009 Damien Sandras <dsandras@seconix.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ *
+ * Ekiga is licensed under the GPL license and as a special exception,
+ * you have permission to link or otherwise combine this program with the
+ * programs OPAL, OpenH323 and PWLIB, and distribute the combination,
+ * without applying the requirements of the GNU GPL to the OPAL, OpenH323
+ * and PWLIB programs, as long as you do follow the requirements of the
+ * GNU GPL for all the rest of the software thus combined.
+ */
+
+
+/*
+ *                        yuv-scale.c  -  description
+ *                         --------------------------------
+ *   begin                : written in 2012
+ *   copyright            : (C) 2012 by Damien Sandras
+ *   description          : Implementation of a fused YUV420P to 32 bits RGB
+ *                          colour conversion and scaling
+ *
+ */
+
+/* The image is processed one destination row at a time:
+ *  1. the two source rows surrounding it are blended vertically, for the
+ *     luma and both chroma planes;
+ *  2. the result is resampled horizontally to the destination width;
+ *  3. the Y, U and V rows are converted to RGB and stored.
+ * Steps 1 and 3 are where the time goes, and they have SSE2 and AVX2
+ * versions; step 2 is a gather, which doesn't vectorize well.
+ *
+ * All computations are done on 16 bits integers, with the very same
+ * rounding and saturation in every implementation, so that the results
+ * are identical whatever the CPU.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include "yuv-scale.h"
+
+#ifdef HAVE_X86_SIMD
+#include <emmintrin.h>
+#include <immintrin.h>
+#endif
+
+/* BT.601 coefficients, with 6 bits of fraction ; the luma one is 74.5,
+ * applied as 74 plus a half */
+#define Y_COEF   74
+#define V_R_COEF 102
+#define U_G_COEF 25
+#define V_G_COEF 52
+#define U_B_COEF 129
+
+typedef void (*BlendRowFunc) (guchar *dest,
+                              const guchar *a,
+                              const guchar *b,
+                              int weight,
+                              int n);
+
+typedef void (*ConvertRowFunc) (guchar *dest,
+                                const guchar *y,
+                                const guchar *u,
+                                const guchar *v,
+                                int n,
+                                gboolean bgr);
+
+
+/* Portable implementation
+ */
+
+static inline int
+saturate16 (int v)
+{
+  return v < -32768 ? -32768 : (v > 32767 ? 32767 : v);
+}
+
+static inline guchar
+clamp8 (int v)
+{
+  return v < 0 ? 0 : (v > 255 ? 255 : v);
+}
+
+static void
+blend_row_c (guchar *dest,
+             const guchar *a,
+             const guchar *b,
+             int weight,
+             int n)
+{
+  int i;
+
+  for (i = 0 ; i < n ; i++)
+    dest[i] = (a[i] * (256 - weight) + b[i] * weight + 128) >> 8;
+}
+
+static inline void
+convert_pixel (guchar *dest,
+               guchar y,
+               guchar u,
+               guchar v,
+               gboolean bgr)
+{
+  int c = (y - 16) * Y_COEF + ((y - 16) >> 1);
+  int d = u - 128;
+  int e = v - 128;
+  guchar r, g, b;
+
+  r = clamp8 (saturate16 (saturate16 (c + V_R_COEF * e) + 32) >> 6);
+  g = clamp8 (saturate16 (saturate16 (c - (U_G_COEF * d + V_G_COEF * e)) + 32) >> 6);
+  b = clamp8 (saturate16 (saturate16 (c + U_B_COEF * d) + 32) >> 6);
+
+  dest[0] = bgr ? b : r;
+  dest[1] = g;
+  dest[2] = bgr ? r : b;
+  dest[3] = 0xff;
+}
+
+static void
+convert_row_c (guchar *dest,
+               const guchar *y,
+               const guchar *u,
+               const guchar *v,
+               int n,
+               gboolean bgr)
+{
+  int i;
+
+  for (i = 0 ; i < n ; i++)
+    convert_pixel (dest + 4 * i, y[i], u[i], v[i], bgr);
+}
+
+
+#ifdef HAVE_X86_SIMD
+
+/* SSE2 implementation
+ */
+
+__attribute__ ((target ("sse2")))
+static void
+blend_row_sse2 (guchar *dest,
+                const guchar *a,
+                const guchar *b,
+                int weight,
+                int n)
+{
+  const __m128i zero = _mm_setzero_si128 ();
+  const __m128i wa = _mm_set1_epi16 (256 - weight);
+  const __m128i wb = _mm_set1_epi16 (weight);
+  const __m128i round = _mm_set1_epi16 (128);
+  int i;
+
+  for (i = 0 ; i + 16 <= n ; i += 16) {
+
+    __m128i va = _mm_loadu_si128 ((const __m128i *) (a + i));
+    __m128i vb = _mm_loadu_si128 ((const __m128i *) (b + i));
+    __m128i lo, hi;
+
+    /* the sums fit in 16 bits unsigned, hence the logical shift */
+    lo = _mm_add_epi16 (_mm_mullo_epi16 (_mm_unpacklo_epi8 (va, zero), wa),
+                        _mm_mullo_epi16 (_mm_unpacklo_epi8 (vb, zero), wb));
+    hi = _mm_add_epi16 (_mm_mullo_epi16 (_mm_unpackhi_epi8 (va, zero), wa),
+                        _mm_mullo_epi16 (_mm_unpackhi_epi8 (vb, zero), wb));
+    lo = _mm_srli_epi16 (_mm_add_epi16 (lo, round), 8);
+    hi = _mm_srli_epi16 (_mm_add_epi16 (hi, round), 8);
+
+    _mm_storeu_si128 ((__m128i *) (dest + i), _mm_packus_epi16 (lo, hi));
+  }
+
+  blend_row_c (dest + i, a + i, b + i, weight, n - i);
+}
+
+__attribute__ ((target ("sse2")))
+static void
+convert_row_sse2 (guchar *dest,
+                  const guchar *y,
+                  const guchar *u,
+                  const guchar *v,
+                  int n,
+                  gboolean bgr)
+{
+  const __m128i zero = _mm_setzero_si128 ();
+  const __m128i x = _mm_set1_epi8 ((char) 0xff);
+  const __m128i offset_y = _mm_set1_epi16 (16);
+  const __m128i offset_uv = _mm_set1_epi16 (128);
+  const __m128i round = _mm_set1_epi16 (32);
+  const __m128i y_coef = _mm_set1_epi16 (Y_COEF);
+  const __m128i v_r_coef = _mm_set1_epi16 (V_R_COEF);
+  const __m128i u_g_coef = _mm_set1_epi16 (U_G_COEF);
+  const __m128i v_g_coef = _mm_set1_epi16 (V_G_COEF);
+  const __m128i u_b_coef = _mm_set1_epi16 (U_B_COEF);
+  int i;
+
+  for (i = 0 ; i + 8 <= n ; i += 8) {
+
+    __m128i c, d, e, r, g, b, first, second;
+
+    c = _mm_unpacklo_epi8 (_mm_loadl_epi64 ((const __m128i *) (y + i)), zero);
+    d = _mm_unpacklo_epi8 (_mm_loadl_epi64 ((const __m128i *) (u + i)), zero);
+    e = _mm_unpacklo_epi8 (_mm_loadl_epi64 ((const __m128i *) (v + i)), zero);
+    c = _mm_sub_epi16 (c, offset_y);
+    c = _mm_add_epi16 (_mm_mullo_epi16 (c, y_coef), _mm_srai_epi16 (c, 1));
+    d = _mm_sub_epi16 (d, offset_uv);
+    e = _mm_sub_epi16 (e, offset_uv);
+
+    r = _mm_adds_epi16 (c, _mm_mullo_epi16 (e, v_r_coef));
+    g = _mm_subs_epi16 (c, _mm_add_epi16 (_mm_mullo_epi16 (d, u_g_coef),
+                                          _mm_mullo_epi16 (e, v_g_coef)));
+    b = _mm_adds_epi16 (c, _mm_mullo_epi16 (d, u_b_coef));
+    r = _mm_packus_epi16 (_mm_srai_epi16 (_mm_adds_epi16 (r, round), 6), zero);
+    g = _mm_packus_epi16 (_mm_srai_epi16 (_mm_adds_epi16 (g, round), 6), zero);
+    b = _mm_packus_epi16 (_mm_srai_epi16 (_mm_adds_epi16 (b, round), 6), zero);
+
+    if (bgr) {
+      first = _mm_unpacklo_epi8 (b, g);
+      second = _mm_unpacklo_epi8 (r, x);
+    }
+    else {
+      first = _mm_unpacklo_epi8 (r, g);
+      second = _mm_unpacklo_epi8 (b, x);
+    }
+
+    _mm_storeu_si128 ((__m128i *) (dest + 4 * i),
+                      _mm_unpacklo_epi16 (first, second));
+    _mm_storeu_si128 ((__m128i *) (dest + 4 * i + 16),
+                      _mm_unpackhi_epi16 (first, second));
+  }
+
+  convert_row_c (dest + 4 * i, y + i, u + i, v + i, n - i, bgr);
+}
+
+
+/* AVX2 implementation
+ */
+
+__attribute__ ((target ("avx2")))
+static void
+blend_row_avx2 (guchar *dest,
+                const guchar *a,
+                const guchar *b,
+                int weight,
+                int n)
+{
+  const __m256i wa = _mm256_set1_epi16 (256 - weight);
+  const __m256i wb = _mm256_set1_epi16 (weight);
+  const __m256i round = _mm256_set1_epi16 (128);
+  int i;
+
+  for (i = 0 ; i + 32 <= n ; i += 32) {
+
+    __m256i lo, hi;
+
+    lo = _mm256_add_epi16 (_mm256_mullo_epi16 (_mm256_cvtepu8_epi16 (_mm_loadu_si128 ((const __m128i *) (a + i))), wa),
+                           _mm256_mullo_epi16 (_mm256_cvtepu8_epi16 (_mm_loadu_si128 ((const __m128i *) (b + i))), wb));
+    hi = _mm256_add_epi16 (_mm256_mullo_epi16 (_mm256_cvtepu8_epi16 (_mm_loadu_si128 ((const __m128i *) (a + i + 16))), wa),
+                           _mm256_mullo_epi16 (_mm256_cvtepu8_epi16 (_mm_loadu_si128 ((const __m128i *) (b + i + 16))), wb));
+    lo = _mm256_srli_epi16 (_mm256_add_epi16 (lo, round), 8);
+    hi = _mm256_srli_epi16 (_mm256_add_epi16 (hi, round), 8);
+
+    /* packing works within the 128 bits lanes : put them back in order */
+    _mm256_storeu_si256 ((__m256i *) (dest + i),
+                         _mm256_permute4x64_epi64 (_mm256_packus_epi16 (lo, hi), 0xd8));
+  }
+
+  blend_row_sse2 (dest + i, a + i, b + i, weight, n - i);
+}
+
+__attribute__ ((target ("avx2")))
+static void
+convert_row_avx2 (guchar *dest,
+                  const guchar *y,
+                  const guchar *u,
+                  const guchar *v,
+                  int n,
+                  gboolean bgr)
+{
+  const __m256i x = _mm256_set1_epi8 ((char) 0xff);
+  const __m256i offset_y = _mm256_set1_epi16 (16);
+  const __m256i offset_uv = _mm256_set1_epi16 (128);
+  const __m256i round = _mm256_set1_epi16 (32);
+  const __m256i y_coef = _mm256_set1_epi16 (Y_COEF);
+  const __m256i v_r_coef = _mm256_set1_epi16 (V_R_COEF);
+  const __m256i u_g_coef = _mm256_set1_epi16 (U_G_COEF);
+  const __m256i v_g_coef = _mm256_set1_epi16 (V_G_COEF);
+  const __m256i u_b_coef = _mm256_set1_epi16 (U_B_COEF);
+  int i;
+
+  for (i = 0 ; i + 16 <= n ; i += 16) {
+
+    __m256i c, d, e, r, g, b, first, second, lo, hi;
+
+    c = _mm256_cvtepu8_epi16 (_mm_loadu_si128 ((const __m128i *) (y + i)));
+    d = _mm256_cvtepu8_epi16 (_mm_loadu_si128 ((const __m128i *) (u + i)));
+    e = _mm256_cvtepu8_epi16 (_mm_loadu_si128 ((const __m128i *) (v + i)));
+    c = _mm256_sub_epi16 (c, offset_y);
+    c = _mm256_add_epi16 (_mm256_mullo_epi16 (c, y_coef), _mm256_srai_epi16 (c, 1));
+    d = _mm256_sub_epi16 (d, offset_uv);
+    e = _mm256_sub_epi16 (e, offset_uv);
+
+    r = _mm256_adds_epi16 (c, _mm256_mullo_epi16 (e, v_r_coef));
+    g = _mm256_subs_epi16 (c, _mm256_add_epi16 (_mm256_mullo_epi16 (d, u_g_coef),
+                                                _mm256_mullo_epi16 (e, v_g_coef)));
+    b = _mm256_adds_epi16 (c, _mm256_mullo_epi16 (d, u_b_coef));
+    r = _mm256_srai_epi16 (_mm256_adds_epi16 (r, round), 6);
+    g = _mm256_srai_epi16 (_mm256_adds_epi16 (g, round), 6);
+    b = _mm256_srai_epi16 (_mm256_adds_epi16 (b, round), 6);
+
+    /* lane 0 gets pixels 0-7 and lane 1 pixels 8-15 */
+    r = _mm256_packus_epi16 (r, r);
+    g = _mm256_packus_epi16 (g, g);
+    b = _mm256_packus_epi16 (b, b);
+
+    if (bgr) {
+      first = _mm256_unpacklo_epi8 (b, g);
+      second = _mm256_unpacklo_epi8 (r, x);
+    }
+    else {
+      first = _mm256_unpacklo_epi8 (r, g);
+      second = _mm256_unpacklo_epi8 (b, x);
+    }
+
+    /* lo holds pixels 0-3 and 8-11, hi holds pixels 4-7 and 12-15 */
+    lo = _mm256_unpacklo_epi16 (first, second);
+    hi = _mm256_unpackhi_epi16 (first, second);
+
+    _mm256_storeu_si256 ((__m256i *) (dest + 4 * i),
+                         _mm256_permute2x128_si256 (lo, hi, 0x20));
+    _mm256_storeu_si256 ((__m256i *) (dest + 4 * i + 32),
+                         _mm256_permute2x128_si256 (lo, hi, 0x31));
+  }
+
+  convert_row_sse2 (dest + 4 * i, y + i, u + i, v + i, n - i, bgr);
+}
+
+#endif /* HAVE_X86_SIMD */
+
+
+/* The driver, common to all implementations
+ */
+
+/* Maps the destination coordinate d to the source coordinates i0 and i1 to
+ * interpolate between with the 8 bits weight w, pixel centers aligned */
+static inline void
+map_coordinate (int d,
+                int dest_size,
+                int src_size,
+                PixopsInterpType interp_type,
+                int *i0,
+                int *i1,
+                int *w)
+{
+  gint64 pos;
+
+  if (interp_type == PIXOPS_INTERP_NEAREST) {
+
+    *i0 = ((gint64) (2 * d + 1) * src_size) / (2 * dest_size);
+    if (*i0 > src_size - 1)
+      *i0 = src_size - 1;
+    *i1 = *i0;
+    *w = 0;
+    return;
+  }
+
+  pos = ((gint64) (2 * d + 1) * src_size * 256) / (2 * dest_size) - 128;
+  if (pos < 0)
+    pos = 0;
+
+  *i0 = (int) (pos >> 8);
+  *w = (int) (pos & 0xff);
+  if (*i0 >= src_size - 1) {
+    *i0 = src_size - 1;
+    *w = 0;
+  }
+  *i1 = (*i0 < src_size - 1) ? *i0 + 1 : *i0;
+}
+
+static inline void
+resample_row (guchar *dest,
+              const guchar *src,
+              const int *i0,
+              const int *i1,
+              const int *w,
+              int n)
+{
+  int i;
+
+  for (i = 0 ; i < n ; i++)
+    dest[i] = (src[i0[i]] * (256 - w[i]) + src[i1[i]] * w[i] + 128) >> 8;
+}
+
+static void
+yuv420p_scale (BlendRowFunc blend_row,
+               ConvertRowFunc convert_row,
+               guchar *dest_buf,
+               int dest_width,
+               int dest_height,
+               int dest_rowstride,
+               gboolean bgr,
+               const guchar *src_buf,
+               int src_width,
+               int src_height,
+               PixopsInterpType interp_type)
+{
+  int chroma_width = src_width / 2;
+  int chroma_height = src_height / 2;
+  const guchar *src_y = src_buf;
+  const guchar *src_u = src_y + src_width * src_height;
+  const guchar *src_v = src_u + chroma_width * chroma_height;
+
+  int *tables = NULL;
+  int *luma_i0, *luma_i1, *luma_w;
+  int *chroma_i0, *chroma_i1, *chroma_w;
+
+  guchar *rows = NULL;
+  guchar *luma_src, *u_src, *v_src;
+  guchar *luma_dest, *u_dest, *v_dest;
+
+  int x, y;
+
+  g_return_if_fail (dest_width > 0 && dest_height > 0);
+  g_return_if_fail (src_width > 1 && src_height > 1);
+
+  tables = g_new (int, 6 * dest_width);
+  luma_i0 = tables;
+  luma_i1 = luma_i0 + dest_width;
+  luma_w = luma_i1 + dest_width;
+  chroma_i0 = luma_w + dest_width;
+  chroma_i1 = chroma_i0 + dest_width;
+  chroma_w = chroma_i1 + dest_width;
+
+  for (x = 0 ; x < dest_width ; x++) {
+
+    map_coordinate (x, dest_width, src_width, interp_type,
+                    &luma_i0[x], &luma_i1[x], &luma_w[x]);
+    map_coordinate (x, dest_width, chroma_width, interp_type,
+                    &chroma_i0[x], &chroma_i1[x], &chroma_w[x]);
+  }
+
+  rows = g_new (guchar, src_width + 2 * chroma_width + 3 * dest_width);
+  luma_src = rows;
+  u_src = luma_src + src_width;
+  v_src = u_src + chroma_width;
+  luma_dest = v_src + chroma_width;
+  u_dest = luma_dest + dest_width;
+  v_dest = u_dest + dest_width;
+
+  for (y = 0 ; y < dest_height ; y++) {
+
+    int i0, i1, w;
+
+    map_coordinate (y, dest_height, src_height, interp_type, &i0, &i1, &w);
+    if (w == 0)
+      memcpy (luma_src, src_y + i0 * src_width, src_width);
+    else
+      blend_row (luma_src,
+                 src_y + i0 * src_width, src_y + i1 * src_width,
+                 w, src_width);
+
+    map_coordinate (y, dest_height, chroma_height, interp_type, &i0, &i1, &w);
+    if (w == 0) {
+      memcpy (u_src, src_u + i0 * chroma_width, chroma_width);
+      memcpy (v_src, src_v + i0 * chroma_width, chroma_width);
+    }
+    else {
+      blend_row (u_src,
+                 src_u + i0 * chroma_width, src_u + i1 * chroma_width,
+                 w, chroma_width);
+      blend_row (v_src,
+                 src_v + i0 * chroma_width, src_v + i1 * chroma_width,
+                 w, chroma_width);
+    }
+
+    resample_row (luma_dest, luma_src, luma_i0, luma_i1, luma_w, dest_width);
+    resample_row (u_dest, u_src, chroma_i0, chroma_i1, chroma_w, dest_width);
+    resample_row (v_dest, v_src, chroma_i0, chroma_i1, chroma_w, dest_width);
+
+    convert_row (dest_buf + y * dest_rowstride,
+                 luma_dest, u_dest, v_dest, dest_width, bgr);
+  }
+
+  g_free (rows);
+  g_free (tables);
+}
+
+
+/* Public api
+ */
+
+gboolean
+pixops_yuv420p_scale_supports (PixopsInterpType interp_type)
+{
+  return (interp_type == PIXOPS_INTERP_NEAREST
+          || interp_type == PIXOPS_INTERP_BILINEAR);
+}
+
+PixopsYuvCpu
+pixops_yuv420p_scale_get_cpu (void)
+{
+  static int cpu = -1;
+
+  if (cpu == -1) {
+
+    cpu = PIXOPS_YUV_CPU_C;
+#ifdef HAVE_X86_SIMD
+    __builtin_cpu_init ();
+    if (__builtin_cpu_supports ("avx2"))
+      cpu = PIXOPS_YUV_CPU_AVX2;
+    else if (__builtin_cpu_supports ("sse2"))
+      cpu = PIXOPS_YUV_CPU_SSE2;
+#endif
+  }
+
+  return (PixopsYuvCpu) cpu;
+}
+
+void
+pixops_yuv420p_scale (guchar          *dest_buf,
+                      int              dest_width,
+                      int              dest_height,
+                      int              dest_rowstride,
+                      gboolean         bgr,
+                      const guchar    *src_buf,
+                      int              src_width,
+                      int              src_height,
+                      PixopsInterpType interp_type)
+{
+  pixops_yuv420p_scale_with_cpu (pixops_yuv420p_scale_get_cpu (),
+                                 dest_buf, dest_width, dest_height,
+                                 dest_rowstride, bgr,
+                                 src_buf, src_width, src_height,
+                                 interp_type);
+}
+
+void
+pixops_yuv420p_scale_with_cpu (PixopsYuvCpu     cpu,
+                               guchar          *dest_buf,
+                               int              dest_width,
+                               int              dest_height,
+                               int              dest_rowstride,
+                               gboolean         bgr,
+                               const guchar    *src_buf,
+                               int              src_width,
+                               int              src_height,
+                               PixopsInterpType interp_type)
+{
+  BlendRowFunc blend_row = blend_row_c;
+  ConvertRowFunc convert_row = convert_row_c;
+
+  g_return_if_fail (pixops_yuv420p_scale_supports (interp_type));
+
+  switch (cpu) {
+#ifdef HAVE_X86_SIMD
+  case PIXOPS_YUV_CPU_AVX2:
+    blend_row = blend_row_avx2;
+    convert_row = convert_row_avx2;
+    break;
+  case PIXOPS_YUV_CPU_SSE2:
+    blend_row = blend_row_sse2;
+    convert_row = convert_row_sse2;
+    break;
+#else
+  case PIXOPS_YUV_CPU_AVX2:
+  case PIXOPS_YUV_CPU_SSE2:
+#endif
+  case PIXOPS_YUV_CPU_C:
+  default:
+    break;
+  }
+
+  yuv420p_scale (blend_row, convert_row,
+                 dest_buf, dest_width, dest_height, dest_rowstride, bgr,
+                 src_buf, src_width, src_height, interp_type);
+}
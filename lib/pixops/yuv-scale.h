@@ -0,0 +1,109 @@
+/* Ekiga -- A VoIP and Video-Conferencing application
+ * Copyright (C) 2000-2009 Damien Sandras <dsandras@seconix.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ *
+ * Ekiga is licensed under the GPL license and as a special exception,
+ * you have permission to link or otherwise combine this program with the
+ * programs OPAL, OpenH323 and PWLIB, and distribute the combination,
+ * without applying the requirements of the GNU GPL to the OPAL, OpenH323
+ * and PWLIB programs, as long as you do follow the requirements of the
+ * GNU GPL for all the rest of the software thus combined.
+ */
+
+
+/*
+ *                        yuv-scale.h  -  description
+ *                         --------------------------------
+ *   begin                : written in 2012
+ *   copyright            : (C) 2012 by Damien Sandras
+ *   description          : Declaration of a fused YUV420P to 32 bits RGB
+ *                          colour conversion and scaling, with SSE2 and
+ *                          AVX2 implementations picked at runtime
+ *
+ */
+
+#ifndef __YUV_SCALE_H__
+#define __YUV_SCALE_H__
+
+#include <glib.h>
+
+#include "pixops.h"
+
+G_BEGIN_DECLS
+
+typedef enum
+{
+  PIXOPS_YUV_CPU_C,     /* the portable reference implementation */
+  PIXOPS_YUV_CPU_SSE2,
+  PIXOPS_YUV_CPU_AVX2
+} PixopsYuvCpu;
+
+/* DESCRIPTION  :  /
+ * BEHAVIOR     :  Returns TRUE if the fused conversion supports the given
+ *                 interpolation type (nearest and bilinear are supported,
+ *                 the other ones need the generic pixops_scale path).
+ * PRE          :  /
+ */
+gboolean pixops_yuv420p_scale_supports (PixopsInterpType interp_type);
+
+/* DESCRIPTION  :  /
+ * BEHAVIOR     :  Returns the best implementation available on this CPU.
+ * PRE          :  /
+ */
+PixopsYuvCpu pixops_yuv420p_scale_get_cpu (void);
+
+/* DESCRIPTION  :  /
+ * BEHAVIOR     :  Scales the YUV420P src_buf to dest_width x dest_height and
+ *                 converts it to 32 bits pixels (ITU-R BT.601, studio swing),
+ *                 in one pass and with the best implementation available.
+ *                 The pixels are stored as R, G, B, X bytes, or B, G, R, X
+ *                 bytes if bgr is TRUE. The X byte is set to 0xff.
+ * PRE          :  src_width and src_height are even, interp_type is supported,
+ *                 dest_rowstride >= 4 * dest_width.
+ */
+void pixops_yuv420p_scale (guchar          *dest_buf,
+                           int              dest_width,
+                           int              dest_height,
+                           int              dest_rowstride,
+                           gboolean         bgr,
+                           const guchar    *src_buf,
+                           int              src_width,
+                           int              src_height,
+                           PixopsInterpType interp_type);
+
+/* DESCRIPTION  :  /
+ * BEHAVIOR     :  Same as pixops_yuv420p_scale, but forces the given
+ *                 implementation. All of them give exactly the same result,
+ *                 which makes PIXOPS_YUV_CPU_C the reference to check and
+ *                 benchmark the others against.
+ * PRE          :  Same as pixops_yuv420p_scale, and cpu is supported by
+ *                 the processor (see pixops_yuv420p_scale_get_cpu).
+ */
+void pixops_yuv420p_scale_with_cpu (PixopsYuvCpu     cpu,
+                                    guchar          *dest_buf,
+                                    int              dest_width,
+                                    int              dest_height,
+                                    int              dest_rowstride,
+                                    gboolean         bgr,
+                                    const guchar    *src_buf,
+                                    int              src_width,
+                                    int              src_height,
+                                    PixopsInterpType interp_type);
+
+G_END_DECLS
+
+#endif /* __YUV_SCALE_H__ */
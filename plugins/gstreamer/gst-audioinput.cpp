@@ -57,7 +57,8 @@ GST::AudioInputManager::~AudioInputManager ()
 void
 GST::AudioInputManager::get_devices (std::vector<Ekiga::AudioInputDevice>& devices)
 {
-  detect_devices ();
+  if ( !already_detected_devices)
+    detect_devices ();
 
   for (std::map<std::pair<std::string, std::string>, std::string>::const_iterator iter
 	 = devices_by_name.begin ();
@@ -172,9 +173,18 @@ GST::AudioInputManager::has_device (const std::string& source,
 				    const std::string& device_name,
 				    Ekiga::AudioInputDevice& /*device*/)
 {
+  if ( !already_detected_devices)
+    detect_devices ();
+
   return (devices_by_name.find (std::pair<std::string,std::string>(source, device_name)) != devices_by_name.end ());
 }
 
+void
+GST::AudioInputManager::refresh_devices ()
+{
+  already_detected_devices = false;
+}
+
 void
 GST::AudioInputManager::detect_devices ()
 {
@@ -78,6 +78,8 @@ namespace GST
     bool has_device (const std::string& source,
 		     const std::string& device_name,
 		     Ekiga::AudioInputDevice& device);
+
+    void refresh_devices ();
   private:
 
     bool already_detected_devices;
@@ -59,7 +59,8 @@ GST::AudioOutputManager::~AudioOutputManager ()
 void
 GST::AudioOutputManager::get_devices (std::vector<Ekiga::AudioOutputDevice>& devices)
 {
-  detect_devices ();
+  if ( !already_detected_devices)
+    detect_devices ();
 
   for (std::map<std::pair<std::string, std::string>, std::string>::const_iterator iter
 	 = devices_by_name.begin ();
@@ -199,12 +200,22 @@ GST::AudioOutputManager::has_device (const std::string& source,
 				     const std::string& device_name,
 				     Ekiga::AudioOutputDevice& /*device*/)
 {
+  if ( !already_detected_devices)
+    detect_devices ();
+
   return (devices_by_name.find (std::pair<std::string,std::string>(source, device_name)) != devices_by_name.end ());
 }
 
+void
+GST::AudioOutputManager::refresh_devices ()
+{
+  already_detected_devices = false;
+}
+
 void
 GST::AudioOutputManager::detect_devices ()
 {
+  already_detected_devices = true;
   devices_by_name.clear ();
   detect_fakesink_devices ();
   detect_alsasink_devices ();
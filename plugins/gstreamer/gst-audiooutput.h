@@ -81,6 +81,8 @@ namespace GST
     bool has_device (const std::string& source,
 		     const std::string& device_name,
 		     Ekiga::AudioOutputDevice& device);
+
+    void refresh_devices ();
   private:
 
     bool already_detected_devices;
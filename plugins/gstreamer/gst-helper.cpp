@@ -40,7 +40,6 @@
 #include <gst/base/gstadapter.h>
 #include <gst/app/gstappsrc.h>
 #include <gst/app/gstappsink.h>
-#include <gst/app/gstappbuffer.h>
 
 struct gst_helper
 {
@@ -78,6 +77,12 @@ gst_helper_new (const gchar* command)
 
     self->active = gst_bin_get_by_name (GST_BIN (self->pipeline), "ekiga_src");
   }
+
+  /* pushing data blocks while the source is full, so the writer is paced by
+   * the sink's clock */
+  if (self->active != NULL && GST_IS_APP_SRC (self->active))
+    g_object_set (G_OBJECT (self->active), "block", TRUE, NULL);
+
   (void)gst_element_set_state (self->pipeline, GST_STATE_PLAYING);
 
   return self;
@@ -97,14 +102,23 @@ gst_helper_get_frame_data (gst_helper* self,
 {
   GstBuffer* buffer = NULL;
 
-  buffer = gst_app_sink_pull_buffer (GST_APP_SINK (self->active));
-  if (buffer != NULL)
+  /* pulling blocks until the pipeline has produced a buffer, so the reader
+   * is paced by the source */
+  while (gst_adapter_available (self->adapter) < size) {
+
+    buffer = gst_app_sink_pull_buffer (GST_APP_SINK (self->active));
+    if (buffer == NULL)
+      break;
     gst_adapter_push (self->adapter, buffer);
+  }
 
   read = MIN(size, gst_adapter_available (self->adapter));
   gst_adapter_copy (self->adapter, (guint8*)data, 0, read);
   gst_adapter_flush (self->adapter, read);
-  g_usleep (20 * G_TIME_SPAN_MILLISECOND);
+
+  /* the pipeline stopped : don't let the caller spin */
+  if (buffer == NULL && read == 0)
+    g_usleep (20 * G_TIME_SPAN_MILLISECOND);
 
   return true;
 }
@@ -114,17 +128,14 @@ gst_helper_set_frame_data (gst_helper* self,
 			   const char* data,
 			   unsigned size)
 {
-  gchar* tmp = NULL;
   GstBuffer* buffer = NULL;
 
   if (self->active) {
 
-    tmp = (gchar*)g_malloc0 (size);
-    memcpy (tmp, data, size);
-    buffer = gst_app_buffer_new (tmp, size,
-				 (GstAppBufferFinalizeFunc)g_free, tmp);
+    /* the caller reuses its data, so it has to be copied once */
+    buffer = gst_buffer_new_and_alloc (size);
+    memcpy (GST_BUFFER_DATA (buffer), data, size);
     gst_app_src_push_buffer (GST_APP_SRC (self->active), buffer);
-    g_usleep (20 * G_TIME_SPAN_MILLISECOND);
   }
 }
 
@@ -158,4 +169,9 @@ gst_helper_set_buffer_size (gst_helper* self,
     g_object_set (G_OBJECT (self->active),
 		  "blocksize", size,
 		  NULL);
+
+  if (self->active && GST_IS_APP_SRC (self->active))
+    g_object_set (G_OBJECT (self->active),
+		  "max-bytes", (guint64) size * GST_HELPER_QUEUED_BUFFERS,
+		  NULL);
 }
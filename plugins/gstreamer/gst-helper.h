@@ -50,6 +50,10 @@
 
 #include <glib/gi18n.h>
 
+/* how many buffers of the buffer size an appsrc queues before pushing more
+ * blocks */
+#define GST_HELPER_QUEUED_BUFFERS 4
+
 struct gst_helper;
 
 gst_helper* gst_helper_new (const gchar* command);
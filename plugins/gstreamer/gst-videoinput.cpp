@@ -57,7 +57,8 @@ GST::VideoInputManager::~VideoInputManager ()
 void
 GST::VideoInputManager::get_devices (std::vector<Ekiga::VideoInputDevice>& devices)
 {
-  detect_devices ();
+  if ( !already_detected_devices)
+    detect_devices ();
 
   for (std::map<std::pair<std::string, std::string>, std::string>::const_iterator iter
 	 = devices_by_name.begin ();
@@ -164,9 +165,18 @@ GST::VideoInputManager::has_device (const std::string& source,
 				    G_GNUC_UNUSED unsigned capabilities,
 				    G_GNUC_UNUSED Ekiga::VideoInputDevice& device)
 {
+  if ( !already_detected_devices)
+    detect_devices ();
+
   return (devices_by_name.find (std::pair<std::string,std::string> (source, device_name)) != devices_by_name.end ());
 }
 
+void
+GST::VideoInputManager::refresh_devices ()
+{
+  already_detected_devices = false;
+}
+
 void
 GST::VideoInputManager::detect_devices ()
 {
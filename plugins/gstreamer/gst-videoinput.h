@@ -72,6 +72,8 @@ namespace GST
 		     const std::string& device_name,
 		     unsigned capabilities,
 		     Ekiga::VideoInputDevice& device);
+
+    void refresh_devices ();
   private:
 
     bool already_detected_devices;
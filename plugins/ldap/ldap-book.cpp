@@ -73,25 +73,76 @@ fix_to_utf8 (const std::string str)
   return result;
 }
 
-/* parses a message to construct a nice contact */
-OPENLDAP::ContactPtr
-OPENLDAP::Book::parse_result (LDAPMessage* message)
+/* how long we wait for the server between two answers, in ms */
+#define SEARCH_PATIENCE 63000
+
+/* how often the search thread checks whether it was cancelled, in ms */
+#define SEARCH_POLL 100
+
+/* how many entries we ask the server per page, and push to the book
+ * at once */
+#define SEARCH_PAGE_SIZE 200
+#define SEARCH_BATCH_SIZE 50
+
+/* how long a complete listing of the directory can be brought up to date
+ * with only what changed since, in seconds */
+#define CACHE_MAX_AGE (24 * 60 * 60)
+
+namespace OPENLDAP
+{
+  /* this allows us to do the searching in a thread: we put all needed
+   * data in this structure, let everything happen elsewhere, then push
+   * the results back into the main thread.
+   * The book pointer, full_listing and seen are only used in the main
+   * thread, and cancelled is how it tells the search thread to give up.
+   * The entries are parsed in the search thread, but the contacts are
+   * only created in the main thread.
+   */
+  struct Search
+  {
+    Book *book;
+    volatile gint cancelled;
+
+    struct ldap *ldap_context;
+    bool bound;
+    BookInfo bookinfo;
+    std::string filter;
+
+    /* if not empty, only ask what changed since that modifyTimestamp */
+    std::string since;
+
+    /* whether the server gave all the entries, without hitting a limit */
+    bool complete;
+
+    bool full_listing;
+    std::set<std::string> seen;
+  };
+};
+
+/* parses a message to construct a nice entry */
+static bool
+parse_entry (struct ldap *ldap_context,
+	     LDAPMessage* message,
+	     char **attributes,
+	     OPENLDAP::SearchEntry &entry)
 {
-  ContactPtr result;
   BerElement *ber = NULL;
   struct berval bv, *bvals;
   std::string username;
   std::map<std::string, std::string> call_addresses;
-  char **attributes = bookinfo.urld->lud_attrs;
   int i, rc;
 
-  /* skip past entry DN */
   rc = ldap_get_dn_ber (ldap_context, message, &ber, &bv);
+  if (rc == LDAP_SUCCESS && bv.bv_val != NULL)
+    entry.dn = std::string (bv.bv_val, bv.bv_len);
 
   while (rc == LDAP_SUCCESS) {
     rc = ldap_get_attribute_ber (ldap_context, message, ber, &bv, &bvals);
     if (bv.bv_val == NULL) break;
-    if (attributes[0] == NULL || !g_ascii_strcasecmp(bv.bv_val, attributes[0])) {
+    if (!g_ascii_strcasecmp(bv.bv_val, "modifyTimestamp")) {
+      if (bvals && bvals[0].bv_val)
+        entry.timestamp = std::string (bvals[0].bv_val, bvals[0].bv_len);
+    } else if (attributes[0] == NULL || !g_ascii_strcasecmp(bv.bv_val, attributes[0])) {
       username = std::string (bvals[0].bv_val, bvals[0].bv_len);
     } else {
       for (i=1; attributes[i]; i++) {
@@ -112,60 +163,51 @@ OPENLDAP::Book::parse_result (LDAPMessage* message)
 
   ber_free (ber, 0);
 
-  if (!username.empty () && !call_addresses.empty()) {
+  if (entry.dn.empty () || username.empty () || call_addresses.empty())
+    return false;
 
-    result = ContactPtr(new Contact (core, fix_to_utf8 (username), call_addresses));
-  }
+  entry.username = fix_to_utf8 (username);
+  entry.call_addresses = call_addresses;
 
-  return result;
+  return true;
 }
 
-
-#if 0  /* seems to be unused / unneeded */
-/* this allows us to do the refreshing in a thread: we put all needed
- * data in this structure, let everything happen elsewhere, then push back
- * into the main thread
+/* waits for the next message of the given operation : returns its type,
+ * 0 if the server took too long to answer, -1 on error, and -2 if the
+ * search was cancelled meanwhile
  */
-struct RefreshData
+static int
+wait_result (OPENLDAP::Search &search,
+	     int msgid,
+	     int all,
+	     LDAPMessage **message)
 {
+  int result = 0;
+  unsigned waited = 0;
 
-  RefreshData (Ekiga::ServiceCore &_core,
-	       const std::string _name,
-	       const std::string _uri,
-	       const std::string _base,
-	       const std::string _scope,
-	       const std::string _call_attribute,
-	       const std::string _authcID,
-	       const std::string _password,
-	       const std::string _search_string,
-	       boost::function1<void, std::vector<OPENLDAP::Contact *> > _publish_results):
-    core(_core), name(_name), uri(_uri),
-    base(_base), scope(_scope), call_attribute(_call_attribute),
-    authcID(_authcID), password(_password), search_string(_search_string),
-    error(false), publish_results (_publish_results)
-  {
+  *message = NULL;
+
+  do {
+
+    struct timeval timeout = { 0, SEARCH_POLL * 1000 };
+
+    if (g_atomic_int_get (&search.cancelled))
+      return -2;
+
+    result = ldap_result (search.ldap_context, msgid, all,
+			  &timeout, message);
+    waited += SEARCH_POLL;
+  } while (result == 0 && waited < SEARCH_PATIENCE);
+
+  if (result <= 0 && *message != NULL) {
+
+    ldap_msgfree (*message);
+    *message = NULL;
   }
 
-  /* search data */
-  Ekiga::ServiceCore &core;
-  std::string name;
-  std::string uri;
-  std::string base;
-  std::string scope;
-  std::string call_attribute;
-  std::string authcID;
-  std::string password;
-  std::string search_string;
-
-  /* result data */
-  bool error;
-  std::vector<OPENLDAP::Contact *> contacts;
-  std::string error_message;
-
-  /* callback */
-  boost::function1<void, std::vector<OPENLDAP::Contact *> > publish_results;
-};
-#endif
+  return result;
+}
+
 
 /* actual implementation */
 
@@ -173,8 +215,7 @@ OPENLDAP::Book::Book (Ekiga::ServiceCore &_core,
 		      boost::shared_ptr<xmlDoc> _doc,
 		      xmlNodePtr _node):
   saslform(NULL), core(_core), doc(_doc), node(_node),
-  name_node(NULL), uri_node(NULL), authcID_node(NULL), password_node(NULL),
-  ldap_context(NULL), patience(0)
+  name_node(NULL), uri_node(NULL), authcID_node(NULL), password_node(NULL)
 {
   xmlChar *xml_str;
   bool upgrade_config = false;
@@ -345,8 +386,7 @@ OPENLDAP::Book::Book (Ekiga::ServiceCore &_core,
 		      boost::shared_ptr<xmlDoc> _doc,
 		      OPENLDAP::BookInfo _bookinfo):
   saslform(NULL), core(_core), doc(_doc), name_node(NULL),
-  uri_node(NULL), authcID_node(NULL), password_node(NULL),
-  ldap_context(NULL), patience(0)
+  uri_node(NULL), authcID_node(NULL), password_node(NULL)
 {
   node = xmlNewNode (NULL, BAD_CAST "server");
 
@@ -380,6 +420,7 @@ OPENLDAP::Book::Book (Ekiga::ServiceCore &_core,
 
 OPENLDAP::Book::~Book ()
 {
+  cancel_search ();
 }
 
 bool
@@ -458,16 +499,37 @@ OPENLDAP::Book::get_status () const
 void
 OPENLDAP::Book::refresh ()
 {
+  /* a search with an older filter is of no use anymore */
+  cancel_search ();
+
   /* we flush */
   remove_all_objects ();
+  contacts_by_dn.clear ();
+
+  show_cached ();
+
+  refresh_start ();
+}
 
-  if (ldap_context == NULL)
-    refresh_start ();
+void
+OPENLDAP::Book::cancel_search ()
+{
+  if (!search)
+    return;
+
+  /* the search thread will unbind when it notices */
+  g_atomic_int_set (&search->cancelled, 1);
+  search->book = NULL;
+  search.reset ();
 }
 
 void
 OPENLDAP::Book::remove ()
 {
+  cancel_search ();
+  if (cache)
+    cache->clear ();
+
   xmlUnlinkNode (node);
   xmlFreeNode (node);
 
@@ -673,9 +735,12 @@ extern "C" {
 void
 OPENLDAP::Book::refresh_start ()
 {
-  int msgid = -1;
   int result = LDAP_SUCCESS;
   int ldap_version = LDAP_VERSION3;
+  struct timeval network_timeout = { 10, 0 };
+  struct ldap *ldap_context = NULL;
+  GThread *thread = NULL;
+  boost::shared_ptr<Search> *data = NULL;
 
   status = std::string (_("Refreshing"));
   updated ();
@@ -694,21 +759,27 @@ OPENLDAP::Book::refresh_start ()
   (void)ldap_set_option (ldap_context,
 			 LDAP_OPT_PROTOCOL_VERSION, &ldap_version);
 
-  if (bookinfo.starttls) {
-    result = ldap_start_tls_s (ldap_context, NULL, NULL);
-    if (result != LDAP_SUCCESS) {
-      status = std::string (_("LDAP Error: ")) +
-        std::string (ldap_err2string (result));
-      updated ();
-      ldap_unbind_ext (ldap_context, NULL, NULL);
-      ldap_context = NULL;
-      return;
-    }
-  }
+  /* so an unreachable server doesn't keep the search thread forever */
+  (void)ldap_set_option (ldap_context,
+			 LDAP_OPT_NETWORK_TIMEOUT, &network_timeout);
 
+  /* SASL may need to ask the user questions, so it binds from here ;
+   * the simple bind is left to the search thread
+   */
   if (bookinfo.sasl) {
     interctx ctx;
 
+    if (bookinfo.starttls) {
+      result = ldap_start_tls_s (ldap_context, NULL, NULL);
+      if (result != LDAP_SUCCESS) {
+	status = std::string (_("LDAP Error: ")) +
+	  std::string (ldap_err2string (result));
+	updated ();
+	ldap_unbind_ext (ldap_context, NULL, NULL);
+	return;
+      }
+    }
+
     ctx.book = this;
     ctx.authcID = bookinfo.authcID;
     ctx.password = bookinfo.password;
@@ -716,7 +787,125 @@ OPENLDAP::Book::refresh_start ()
 					   bookinfo.saslMech.c_str(), NULL, NULL, LDAP_SASL_QUIET,
 					   book_saslinter, &ctx);
 
+    if (result != LDAP_SUCCESS) {
+
+      status = std::string (_("LDAP Error: ")) +
+	std::string (ldap_err2string (result));
+      updated ();
+
+      ldap_unbind_ext (ldap_context, NULL, NULL);
+      return;
+    }
+
+    status = std::string (_("Contacted server"));
+    updated ();
+  }
+
+  search = boost::shared_ptr<Search> (new Search);
+  search->book = this;
+  search->cancelled = 0;
+  search->ldap_context = ldap_context;
+  search->bound = bookinfo.sasl;
+  search->bookinfo = bookinfo;
+  search->filter = get_filter ();
+  search->complete = false;
+  search->full_listing = search_filter.empty ();
+
+  /* a recent enough listing only needs what changed since */
+  if (search->full_listing
+      && cache->get_complete_time () + CACHE_MAX_AGE > time (NULL)
+      && !cache->get_newest_timestamp ().empty ())
+    search->since = cache->get_newest_timestamp ();
+
+  data = new boost::shared_ptr<Search> (search);
+#if GLIB_CHECK_VERSION(2,32,0)
+  thread = g_thread_try_new ("ldap-search", search_thread, data, NULL);
+  if (thread)
+    g_thread_unref (thread);
+#else
+  thread = g_thread_create (search_thread, data, FALSE, NULL);
+#endif
+
+  if (thread == NULL) {
+
+    delete data;
+    search.reset ();
+
+    status = std::string (_("Could not search"));
+    updated ();
+
+    ldap_unbind_ext (ldap_context, NULL, NULL);
+  }
+}
+
+const std::string
+OPENLDAP::Book::get_filter () const
+{
+  std::string filter, fterm;
+  size_t pos;
+
+  if (!search_filter.empty ()) {
+    if (search_filter[0] == '(' &&
+        search_filter[search_filter.length()-1] == ')')
+      return search_filter;
+    fterm = "*" + search_filter + "*";
   } else {
+    fterm = "*";
+  }
+  if (bookinfo.urld->lud_filter != NULL)
+    filter = std::string (bookinfo.urld->lud_filter);
+  else
+    filter="";
+  pos = 0;
+  while ((pos=filter.find('$', pos)) != std::string::npos) {
+    filter.replace (pos, 1, fterm);
+    pos += fterm.length();
+  }
+
+  return filter;
+}
+
+gpointer
+OPENLDAP::Book::search_thread (gpointer data)
+{
+  boost::shared_ptr<Search> search = *(boost::shared_ptr<Search> *) data;
+  std::string error;
+
+  delete (boost::shared_ptr<Search> *) data;
+
+  error = run_search (search);
+
+  ldap_unbind_ext (search->ldap_context, NULL, NULL);
+  search->ldap_context = NULL;
+
+  if (!g_atomic_int_get (&search->cancelled))
+    Ekiga::Runtime::run_in_main (boost::bind (&OPENLDAP::Book::on_search_done, search, error));
+
+  return NULL;
+}
+
+const std::string
+OPENLDAP::Book::run_search (boost::shared_ptr<Search> search)
+{
+  int result = LDAP_SUCCESS;
+  int msgid = -1;
+  LDAPMessage *message = NULL;
+  struct berval cookie = { 0, NULL };
+  boost::shared_ptr<std::vector<SearchEntry> > entries (new std::vector<SearchEntry>);
+  struct ldap *ldap_context = search->ldap_context;
+  const BookInfo &bookinfo = search->bookinfo;
+  std::vector<char *> attributes;
+  std::string filter = search->filter;
+
+  if (!search->bound) {
+
+    if (bookinfo.starttls) {
+      result = ldap_start_tls_s (ldap_context, NULL, NULL);
+      if (result != LDAP_SUCCESS)
+	return std::string (_("LDAP Error: ")) +
+	  std::string (ldap_err2string (result));
+    }
+
     /* Simple Bind */
     if (bookinfo.password.empty ()) {
       struct berval bv={0,NULL};
@@ -738,184 +927,284 @@ OPENLDAP::Book::refresh_start ()
 
       g_free (passwd.bv_val);
     }
+
+    if (result != LDAP_SUCCESS)
+      return std::string (_("LDAP Error: ")) +
+	std::string (ldap_err2string (result));
+
+    result = wait_result (*search, msgid, LDAP_MSG_ALL, &message);
+    if (result == -2)
+      return "";
+    if (result <= 0)
+      return _("Could not connect to server");
+    (void) ldap_msgfree (message);
   }
 
-  if (result != LDAP_SUCCESS) {
+  /* an empty batch tells the book we are bound */
+  Ekiga::Runtime::run_in_main (boost::bind (&OPENLDAP::Book::on_search_entries, search,
+					    boost::shared_ptr<std::vector<SearchEntry> > (new std::vector<SearchEntry>)));
 
-    status = std::string (_("LDAP Error: ")) +
-      std::string (ldap_err2string (result));
-    updated ();
+  /* we also ask for the modification times, to later only ask for what
+   * changed since */
+  if (bookinfo.urld->lud_attrs != NULL) {
 
-    ldap_unbind_ext (ldap_context, NULL, NULL);
-    ldap_context = NULL;
-    return;
+    for (int i = 0; bookinfo.urld->lud_attrs[i] != NULL; i++)
+      attributes.push_back (bookinfo.urld->lud_attrs[i]);
+    attributes.push_back ((char *) "modifyTimestamp");
+    attributes.push_back (NULL);
   }
 
-  status = std::string (_("Contacted server"));
-  updated ();
+  if (!search->since.empty ()) {
 
-  patience = 3;
-  refresh_bound ();
-}
+    if (!filter.empty () && filter[0] != '(')
+      filter = "(" + filter + ")";
+    filter = "(&" + filter + "(modifyTimestamp>=" + search->since + "))";
+  }
 
-void
-OPENLDAP::Book::refresh_bound ()
-{
-  int result = LDAP_SUCCESS;
-  struct timeval timeout = { 1, 0}; /* block 1s */
-  LDAPMessage *msg_entry = NULL;
-  int msgid;
-  std::string filter, fterm;
-  const char *fstr;
-  size_t pos;
+  search->complete = true;
 
-  if (bookinfo.sasl)
-    goto sasl_bound;
+  /* we ask for the results page by page (RFC 2696), so big directories
+   * do not come all at once ; servers which don't know about it will
+   * ignore the control, since it isn't critical
+   */
+  do {
 
-  result = ldap_result (ldap_context, LDAP_RES_ANY, LDAP_MSG_ALL,
-			&timeout, &msg_entry);
+    LDAPControl *page_control = NULL;
+    LDAPControl *server_controls[2] = { NULL, NULL };
+    bool page_done = false;
 
-  if (result <= 0) {
+    if (ldap_create_page_control (ldap_context, SEARCH_PAGE_SIZE, &cookie,
+				  0, &page_control) == LDAP_SUCCESS)
+      server_controls[0] = page_control;
 
-    if (patience == 3) {
-      patience--;
-      Ekiga::Runtime::run_in_main (boost::bind (&OPENLDAP::Book::refresh_bound, this), 12);
-    } else if (patience == 2) {
+    ber_memfree (cookie.bv_val);
+    cookie.bv_val = NULL;
+    cookie.bv_len = 0;
 
-      patience--;
-      Ekiga::Runtime::run_in_main (boost::bind (&OPENLDAP::Book::refresh_bound, this), 21);
-    } else if (patience == 1) {
+    result = ldap_search_ext (ldap_context,
+			      bookinfo.urld->lud_dn,
+			      bookinfo.urld->lud_scope,
+			      filter.c_str (),
+			      attributes.empty () ? NULL : &attributes[0],
+			      0, /* attrsonly */
+			      server_controls, NULL,
+			      NULL, 0, &msgid);
 
-      patience--;
-      Ekiga::Runtime::run_in_main (boost::bind (&OPENLDAP::Book::refresh_bound, this), 30);
-    } else { // patience == 0
+    if (page_control != NULL)
+      ldap_control_free (page_control);
 
-      status = std::string (_("Could not connect to server"));
-      updated ();
+    if (result != LDAP_SUCCESS)
+      return _("Could not search");
 
-      ldap_unbind_ext (ldap_context, NULL, NULL);
-      ldap_context = NULL;
+    while (!page_done) {
+
+      result = wait_result (*search, msgid, LDAP_MSG_ONE, &message);
+
+      if (result <= 0) {
+
+	ldap_abandon_ext (ldap_context, msgid, NULL, NULL);
+	if (result == -2)
+	  return "";
+	return _("Could not search");
+      }
+
+      if (result == LDAP_RES_SEARCH_ENTRY) {
+
+	SearchEntry entry;
+	if (parse_entry (ldap_context, message,
+			 bookinfo.urld->lud_attrs, entry))
+	  entries->push_back (entry);
+      }
+      else if (result == LDAP_RES_SEARCH_RESULT) {
+
+	LDAPControl **controls = NULL;
+	LDAPControl *page_response = NULL;
+	int error = LDAP_OTHER;
+
+	if (ldap_parse_result (ldap_context, message, &error,
+			       NULL, NULL, NULL, &controls, 0) == LDAP_SUCCESS
+	    && controls != NULL) {
+
+	  page_response = ldap_control_find (LDAP_CONTROL_PAGEDRESULTS,
+					     controls, NULL);
+	  if (page_response != NULL) {
+
+	    ber_int_t estimate;
+	    (void) ldap_parse_pageresponse_control (ldap_context, page_response,
+						    &estimate, &cookie);
+	  }
+	  ldap_controls_free (controls);
+	}
+
+	if (error != LDAP_SUCCESS)
+	  search->complete = false;
+
+	page_done = true;
+      }
+
+      (void) ldap_msgfree (message);
+
+      if (entries->size () >= SEARCH_BATCH_SIZE
+	  || (page_done && !entries->empty ())) {
+
+	Ekiga::Runtime::run_in_main (boost::bind (&OPENLDAP::Book::on_search_entries, search, entries));
+	entries = boost::shared_ptr<std::vector<SearchEntry> > (new std::vector<SearchEntry>);
+      }
     }
+  } while (cookie.bv_len > 0 && !g_atomic_int_get (&search->cancelled));
 
-    if (msg_entry != NULL)
-      ldap_msgfree (msg_entry);
+  ber_memfree (cookie.bv_val);
 
+  return "";
+}
+
+void
+OPENLDAP::Book::on_search_entries (boost::shared_ptr<Search> search,
+				   boost::shared_ptr<std::vector<SearchEntry> > entries)
+{
+  Book *book = search->book;
+
+  /* the book is gone, or has started another search */
+  if (book == NULL || book->search != search)
     return;
-  }
-  (void) ldap_msgfree (msg_entry);
 
- sasl_bound:
-  if (!search_filter.empty ()) {
-    if (search_filter[0] == '(' &&
-        search_filter[search_filter.length()-1] == ')') {
-      fstr = search_filter.c_str();
-      goto do_search;
+  /* an empty batch only says we're bound */
+  if (entries->empty ()) {
+
+    if (book->contacts_by_dn.empty ()) {
+
+      book->status = std::string (_("Waiting for search results"));
+      book->updated ();
     }
-    fterm = "*" + search_filter + "*";
-  } else {
-    fterm = "*";
+    return;
   }
-  if (bookinfo.urld->lud_filter != NULL)
-    filter = std::string (bookinfo.urld->lud_filter);
-  else
-    filter="";
-  pos = 0;
-  while ((pos=filter.find('$', pos)) != std::string::npos) {
-    filter.replace (pos, 1, fterm);
-    pos += fterm.length();
+
+  book->hold_updates ();
+
+  for (std::vector<SearchEntry>::const_iterator iter = entries->begin ();
+       iter != entries->end ();
+       ++iter) {
+
+    search->seen.insert (iter->dn);
+    book->show_entry (*iter);
+    book->cache->add (*iter);
   }
-  fstr = filter.c_str();
 
- do_search:
-  msgid = ldap_search_ext (ldap_context,
-			   bookinfo.urld->lud_dn,
-			   bookinfo.urld->lud_scope,
-			   fstr,
-			   bookinfo.urld->lud_attrs,
-			   0, /* attrsonly */
-			   NULL, NULL,
-			   NULL, 0, &msgid);
+  book->release_updates ();
+  book->update_status ();
+}
 
-  if (msgid == -1) {
+void
+OPENLDAP::Book::on_search_done (boost::shared_ptr<Search> search,
+				const std::string error)
+{
+  Book *book = search->book;
 
-    status = std::string (_("Could not search"));
-    updated ();
+  if (book == NULL || book->search != search)
+    return;
 
-    ldap_unbind_ext (ldap_context, NULL, NULL);
-    ldap_context = NULL;
+  book->search.reset ();
+
+  if (!error.empty ()) {
+
+    book->status = error;
+    book->updated ();
     return;
-  } else {
+  }
 
-    status = std::string (_("Waiting for search results"));
-    updated ();
+  /* what the server didn't give anymore is gone ; when only what changed
+   * was asked, nothing can be said about the rest */
+  if (search->complete && search->since.empty ()) {
+
+    std::vector<std::string> gone;
+
+    for (std::map<std::string, ContactPtr>::iterator iter = book->contacts_by_dn.begin ();
+	 iter != book->contacts_by_dn.end ();
+	 ++iter)
+      if (search->seen.find (iter->first) == search->seen.end ())
+	gone.push_back (iter->first);
+
+    book->hold_updates ();
+
+    for (std::vector<std::string>::iterator iter = gone.begin ();
+	 iter != gone.end ();
+	 ++iter) {
+
+      book->remove_contact (book->contacts_by_dn[*iter]);
+      book->contacts_by_dn.erase (*iter);
+    }
+
+    book->release_updates ();
+
+    if (search->full_listing) {
+
+      book->cache->prune (search->seen);
+      book->cache->set_complete_time (time (NULL));
+    }
   }
 
-  patience = 3;
-  refresh_result ();
+  book->cache->save ();
+  book->update_status ();
 }
 
 void
-OPENLDAP::Book::refresh_result ()
+OPENLDAP::Book::show_cached ()
 {
-  int result = LDAP_SUCCESS;
-  int nbr = 0;
-  struct timeval timeout = { 1, 0}; /* block 1s */
-  LDAPMessage *msg_entry = NULL;
-  LDAPMessage *msg_result = NULL;
-  gchar* c_status = NULL;
-
-  result = ldap_result (ldap_context, LDAP_RES_ANY, LDAP_MSG_ALL,
-			&timeout, &msg_entry);
+  std::vector<SearchEntry> entries;
 
+  if (!cache || cache->get_uri () != bookinfo.uri) {
 
-  if (result <= 0) {
+    cache = boost::shared_ptr<Cache> (new Cache (bookinfo.uri));
+    cache->load ();
+  }
 
-    if (patience == 3) {
+  /* raw LDAP filters can only be answered by the server */
+  if (!search_filter.empty () && search_filter[0] == '(')
+    return;
 
-      patience--;
-      Ekiga::Runtime::run_in_main (boost::bind (&OPENLDAP::Book::refresh_result, this),
-				   12);
-    } else if (patience == 2) {
+  cache->lookup (search_filter, entries);
 
-      patience--;
-      Ekiga::Runtime::run_in_main (boost::bind (&OPENLDAP::Book::refresh_result, this),
-				   21);
-    } else if (patience == 1) {
+  hold_updates ();
+  for (std::vector<SearchEntry>::const_iterator iter = entries.begin ();
+       iter != entries.end ();
+       ++iter)
+    show_entry (*iter);
+  release_updates ();
 
-      patience--;
-      Ekiga::Runtime::run_in_main (boost::bind (&OPENLDAP::Book::refresh_result, this),
-				   30);
-    } else { // patience == 0
+  if (!entries.empty ())
+    update_status ();
+}
 
-      status = std::string (_("Could not search"));
-      updated ();
+void
+OPENLDAP::Book::show_entry (const SearchEntry &entry)
+{
+  std::map<std::string, ContactPtr>::iterator iter = contacts_by_dn.find (entry.dn);
+  const SearchEntry *cached = cache->find (entry.dn);
 
-      ldap_unbind_ext (ldap_context, NULL, NULL);
-      ldap_context = NULL;
-    }
+  if (iter != contacts_by_dn.end ()) {
 
-    if (msg_entry != NULL)
-      ldap_msgfree (msg_entry);
+    /* shown already, and the server didn't change it */
+    if (cached != NULL
+	&& cached->username == entry.username
+	&& cached->call_addresses == entry.call_addresses)
+      return;
 
-    return;
+    remove_contact (iter->second);
   }
 
-  msg_result = ldap_first_message (ldap_context, msg_entry);
-  do {
-
-    if (ldap_msgtype (msg_result) == LDAP_RES_SEARCH_ENTRY) {
+  ContactPtr contact (new Contact (core, entry.username, entry.call_addresses));
+  contacts_by_dn[entry.dn] = contact;
+  add_contact (contact);
+}
 
-      ContactPtr contact = parse_result (msg_result);
-      if (contact) {
-	add_contact (contact);
-        nbr++;
-      }
-    }
-    msg_result = ldap_next_message (ldap_context, msg_result);
-  } while (msg_result != NULL);
+void
+OPENLDAP::Book::update_status ()
+{
+  gchar* c_status = NULL;
+  int nbr = contacts_by_dn.size ();
 
   // Do not count ekiga.net's first entry "Search Results ... 100 entries"
-  if (bookinfo.uri_host == EKIGA_NET_URI)
+  if (bookinfo.uri_host == EKIGA_NET_URI && nbr > 0)
     nbr--;
   c_status = g_strdup_printf (ngettext ("%d user found",
 					"%d users found", nbr), nbr);
@@ -923,11 +1212,6 @@ OPENLDAP::Book::refresh_result ()
   g_free (c_status);
 
   updated ();
-
-  (void)ldap_msgfree (msg_entry);
-
-  ldap_unbind_ext (ldap_context, NULL, NULL);
-  ldap_context = NULL;
 }
 
 void
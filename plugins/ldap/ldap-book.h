@@ -51,6 +51,7 @@
 #include "form-request-simple.h"
 
 #include "ldap-contact.h"
+#include "ldap-cache.h"
 
 #include <ldap.h>
 
@@ -83,6 +84,9 @@ namespace OPENLDAP
 
   void BookInfoParse (struct BookInfo &info);
 
+  /* see ldap-book.cpp */
+  struct Search;
+
 /**
  * @addtogroup contacts
  * @internal
@@ -135,10 +139,22 @@ namespace OPENLDAP
   private:
 
     void refresh_start ();
-    void refresh_bound ();
-    void refresh_result ();
+    void cancel_search ();
+    const std::string get_filter () const;
+
+    void show_cached ();
+    void show_entry (const SearchEntry &entry);
+    void update_status ();
+
+    /* those run in the search thread */
+    static gpointer search_thread (gpointer data);
+    static const std::string run_search (boost::shared_ptr<Search> search);
 
-    ContactPtr parse_result(struct ldapmsg *);
+    /* those run in the main thread */
+    static void on_search_entries (boost::shared_ptr<Search> search,
+				   boost::shared_ptr<std::vector<SearchEntry> > entries);
+    static void on_search_done (boost::shared_ptr<Search> search,
+				const std::string error);
 
     void parse_uri();
 
@@ -157,8 +173,9 @@ namespace OPENLDAP
 
     struct BookInfo bookinfo;
 
-    struct ldap *ldap_context;
-    unsigned int patience;
+    boost::shared_ptr<Search> search;
+    boost::shared_ptr<Cache> cache;
+    std::map<std::string, ContactPtr> contacts_by_dn;
 
     std::string status;
     std::string search_filter;
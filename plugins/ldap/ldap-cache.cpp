@@ -0,0 +1,424 @@
+/* Ekiga -- A VoIP and Video-Conferencing application
+ * Copyright (C) 2000-2009 Damien Sandras <dsandras@seconix.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ *
+ * Ekiga is licensed under the GPL license and as a special exception,
+ * you have permission to link or otherwise combine this program with the
+ * programs OPAL, OpenH323 and PWLIB, and distribute the combination,
+ * without applying the requirements of the GNU GPL to the OPAL, OpenH323
+ * and PWLIB programs, as long as you do follow the requirements of the
+ * GNU GPL for all the rest of the software thus combined.
+ */
+
+
+/*
+ *                         ldap-cache.cpp  -  description
+ *                         ------------------------------------------
+ *   begin                : written in 2012
+ *   copyright            : (c) 2012 by Damien Sandras
+ *   description          : implementation of the local cache of the entries
+ *                          of a LDAP book
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <glib/gstdio.h>
+
+#include "ldap-cache.h"
+
+/* the first line of the cache files, followed by the complete time and
+ * the newest timestamp ; then come the entries, one per line, with their
+ * DN, timestamp, name, then their attributes and addresses */
+#define CACHE_MAGIC "ekiga-ldap-cache 1"
+
+/* appends a field, escaping the separators */
+static void
+append_field (std::string &line,
+	      const std::string field)
+{
+  line += '\t';
+  for (std::string::const_iterator iter = field.begin ();
+       iter != field.end ();
+       ++iter) {
+
+    switch (*iter) {
+
+    case '\\':
+      line += "\\\\";
+      break;
+    case '\t':
+      line += "\\t";
+      break;
+    case '\n':
+      line += "\\n";
+      break;
+    default:
+      line += *iter;
+    }
+  }
+}
+
+static void
+split_fields (const char *begin,
+	      const char *end,
+	      std::vector<std::string> &fields)
+{
+  std::string field;
+
+  fields.clear ();
+
+  for (const char *ptr = begin; ptr < end; ptr++) {
+
+    if (*ptr == '\t') {
+
+      fields.push_back (field);
+      field.clear ();
+    }
+    else if (*ptr == '\\' && ptr + 1 < end) {
+
+      ptr++;
+      if (*ptr == 't')
+	field += '\t';
+      else if (*ptr == 'n')
+	field += '\n';
+      else
+	field += *ptr;
+    }
+    else
+      field += *ptr;
+  }
+  fields.push_back (field);
+}
+
+static guint32
+trigram_at (const std::string &str,
+	    size_t pos)
+{
+  return ((guint32) (guchar) str[pos] << 16)
+    | ((guint32) (guchar) str[pos + 1] << 8)
+    | (guint32) (guchar) str[pos + 2];
+}
+
+
+OPENLDAP::Cache::Cache (const std::string _uri):
+  uri(_uri), removed(0), complete_time(0), dirty(false)
+{
+  gchar *checksum = g_compute_checksum_for_string (G_CHECKSUM_SHA1,
+						   uri.c_str (), -1);
+  gchar *filename = g_build_filename (g_get_user_cache_dir (),
+				      "ekiga", "ldap", checksum, NULL);
+
+  path = filename;
+
+  g_free (filename);
+  g_free (checksum);
+}
+
+void
+OPENLDAP::Cache::load ()
+{
+  GMappedFile *file = NULL;
+  const char *ptr = NULL;
+  const char *end = NULL;
+  std::vector<std::string> fields;
+  bool header = true;
+
+  file = g_mapped_file_new (path.c_str (), FALSE, NULL);
+  if (file == NULL)
+    return;
+
+  ptr = g_mapped_file_get_contents (file);
+  end = ptr + g_mapped_file_get_length (file);
+
+  while (ptr < end) {
+
+    const char *eol = (const char *) memchr (ptr, '\n', end - ptr);
+    if (eol == NULL)
+      break; // a truncated last line is ignored
+
+    split_fields (ptr, eol, fields);
+    ptr = eol + 1;
+
+    if (header) {
+
+      if (fields.size () != 3 || fields[0] != CACHE_MAGIC)
+	break;
+
+      complete_time = (time_t) g_ascii_strtoull (fields[1].c_str (), NULL, 10);
+      newest_timestamp = fields[2];
+      header = false;
+    }
+    else if (fields.size () >= 3) {
+
+      SearchEntry entry;
+
+      entry.dn = fields[0];
+      entry.timestamp = fields[1];
+      entry.username = fields[2];
+      for (unsigned i = 3; i + 1 < fields.size (); i += 2)
+	entry.call_addresses[fields[i]] = fields[i + 1];
+
+      slots[entry.dn] = entries.size ();
+      entries.push_back (entry);
+    }
+  }
+
+  g_mapped_file_unref (file);
+
+  reindex ();
+  dirty = false;
+}
+
+void
+OPENLDAP::Cache::save ()
+{
+  std::string contents;
+  gchar *dirname = NULL;
+  gchar *time_str = NULL;
+
+  if (!dirty)
+    return;
+
+  contents = CACHE_MAGIC;
+  time_str = g_strdup_printf ("%lu", (unsigned long) complete_time);
+  append_field (contents, time_str);
+  g_free (time_str);
+  append_field (contents, newest_timestamp);
+  contents += '\n';
+
+  for (std::vector<SearchEntry>::const_iterator iter = entries.begin ();
+       iter != entries.end ();
+       ++iter) {
+
+    std::string line;
+
+    if (iter->dn.empty ())
+      continue;
+
+    append_field (line, iter->dn);
+    append_field (line, iter->timestamp);
+    append_field (line, iter->username);
+    for (std::map<std::string, std::string>::const_iterator addr = iter->call_addresses.begin ();
+	 addr != iter->call_addresses.end ();
+	 ++addr) {
+
+      append_field (line, addr->first);
+      append_field (line, addr->second);
+    }
+
+    contents += line.substr (1) + '\n'; // without the leading tab
+  }
+
+  dirname = g_path_get_dirname (path.c_str ());
+  g_mkdir_with_parents (dirname, 0700);
+  g_free (dirname);
+
+  /* g_file_set_contents writes to a temporary file first, so a crash
+   * leaves either the old or the new cache */
+  if (g_file_set_contents (path.c_str (), contents.c_str (),
+			   contents.length (), NULL))
+    dirty = false;
+}
+
+void
+OPENLDAP::Cache::clear ()
+{
+  entries.clear ();
+  haystacks.clear ();
+  slots.clear ();
+  trigrams.clear ();
+  removed = 0;
+  complete_time = 0;
+  newest_timestamp = "";
+  dirty = false;
+
+  g_unlink (path.c_str ());
+}
+
+const OPENLDAP::SearchEntry *
+OPENLDAP::Cache::find (const std::string dn) const
+{
+  std::map<std::string, unsigned>::const_iterator iter = slots.find (dn);
+
+  if (iter == slots.end ())
+    return NULL;
+
+  return &entries[iter->second];
+}
+
+void
+OPENLDAP::Cache::add (const SearchEntry &entry)
+{
+  const SearchEntry *old = find (entry.dn);
+
+  if (old != NULL
+      && old->timestamp == entry.timestamp
+      && old->username == entry.username
+      && old->call_addresses == entry.call_addresses)
+    return;
+
+  if (remove (entry.dn) && removed > entries.size () / 2)
+    reindex ();
+
+  slots[entry.dn] = entries.size ();
+  entries.push_back (entry);
+  index (entries.size () - 1);
+
+  /* generalized times compare as strings */
+  if (entry.timestamp > newest_timestamp)
+    newest_timestamp = entry.timestamp;
+
+  dirty = true;
+}
+
+void
+OPENLDAP::Cache::prune (const std::set<std::string> &dns)
+{
+  std::vector<std::string> gone;
+
+  for (std::map<std::string, unsigned>::const_iterator iter = slots.begin ();
+       iter != slots.end ();
+       ++iter)
+    if (dns.find (iter->first) == dns.end ())
+      gone.push_back (iter->first);
+
+  for (std::vector<std::string>::const_iterator iter = gone.begin ();
+       iter != gone.end ();
+       ++iter)
+    remove (*iter);
+
+  if (removed > entries.size () / 2)
+    reindex ();
+}
+
+void
+OPENLDAP::Cache::lookup (const std::string term,
+			 std::vector<SearchEntry> &result) const
+{
+  gchar *down = g_ascii_strdown (term.c_str (), -1);
+  std::string needle = down;
+  const std::vector<unsigned> *candidates = NULL;
+
+  g_free (down);
+
+  /* the rarest trigram of the term gives the candidates */
+  for (size_t pos = 0; pos + 3 <= needle.length (); pos++) {
+
+    std::map<guint32, std::vector<unsigned> >::const_iterator iter
+      = trigrams.find (trigram_at (needle, pos));
+
+    if (iter == trigrams.end ())
+      return;
+
+    if (candidates == NULL || iter->second.size () < candidates->size ())
+      candidates = &iter->second;
+  }
+
+  if (candidates != NULL) {
+
+    for (std::vector<unsigned>::const_iterator iter = candidates->begin ();
+	 iter != candidates->end ();
+	 ++iter)
+      if (!entries[*iter].dn.empty ()
+	  && haystacks[*iter].find (needle) != std::string::npos)
+	result.push_back (entries[*iter]);
+  }
+  else {
+
+    /* too short a term to have a trigram */
+    for (unsigned slot = 0; slot < entries.size (); slot++)
+      if (!entries[slot].dn.empty ()
+	  && haystacks[slot].find (needle) != std::string::npos)
+	result.push_back (entries[slot]);
+  }
+}
+
+void
+OPENLDAP::Cache::set_complete_time (time_t time)
+{
+  complete_time = time;
+  dirty = true;
+}
+
+void
+OPENLDAP::Cache::index (unsigned slot)
+{
+  const SearchEntry &entry = entries[slot];
+  std::string haystack = entry.username;
+  std::set<guint32> seen;
+  gchar *down = NULL;
+
+  for (std::map<std::string, std::string>::const_iterator iter = entry.call_addresses.begin ();
+       iter != entry.call_addresses.end ();
+       ++iter)
+    haystack += "\n" + iter->second;
+
+  down = g_ascii_strdown (haystack.c_str (), -1);
+  haystack = down;
+  g_free (down);
+
+  if (haystacks.size () <= slot)
+    haystacks.resize (slot + 1);
+  haystacks[slot] = haystack;
+
+  for (size_t pos = 0; pos + 3 <= haystack.length (); pos++)
+    if (seen.insert (trigram_at (haystack, pos)).second)
+      trigrams[trigram_at (haystack, pos)].push_back (slot);
+}
+
+void
+OPENLDAP::Cache::reindex ()
+{
+  std::vector<SearchEntry> live;
+
+  for (std::vector<SearchEntry>::iterator iter = entries.begin ();
+       iter != entries.end ();
+       ++iter)
+    if (!iter->dn.empty ())
+      live.push_back (*iter);
+
+  entries.swap (live);
+  haystacks.clear ();
+  slots.clear ();
+  trigrams.clear ();
+  removed = 0;
+
+  for (unsigned slot = 0; slot < entries.size (); slot++) {
+
+    slots[entries[slot].dn] = slot;
+    index (slot);
+  }
+}
+
+bool
+OPENLDAP::Cache::remove (const std::string dn)
+{
+  std::map<std::string, unsigned>::iterator iter = slots.find (dn);
+
+  if (iter == slots.end ())
+    return false;
+
+  /* the trigrams still point to the slot, but lookup skips it */
+  entries[iter->second] = SearchEntry ();
+  haystacks[iter->second].clear ();
+  slots.erase (iter);
+  removed++;
+  dirty = true;
+
+  return true;
+}
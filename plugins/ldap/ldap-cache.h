@@ -0,0 +1,145 @@
+
+/* Ekiga -- A VoIP and Video-Conferencing application
+ * Copyright (C) 2000-2009 Damien Sandras <dsandras@seconix.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ *
+ * Ekiga is licensed under the GPL license and as a special exception,
+ * you have permission to link or otherwise combine this program with the
+ * programs OPAL, OpenH323 and PWLIB, and distribute the combination,
+ * without applying the requirements of the GNU GPL to the OPAL, OpenH323
+ * and PWLIB programs, as long as you do follow the requirements of the
+ * GNU GPL for all the rest of the software thus combined.
+ */
+
+
+/*
+ *                         ldap-cache.h  -  description
+ *                         ------------------------------------------
+ *   begin                : written in 2012
+ *   copyright            : (c) 2012 by Damien Sandras
+ *   description          : declaration of the local cache of the entries
+ *                          of a LDAP book
+ *
+ */
+
+#ifndef __LDAP_CACHE_H__
+#define __LDAP_CACHE_H__
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include <time.h>
+
+#include <glib.h>
+
+namespace OPENLDAP
+{
+
+/**
+ * @addtogroup contacts
+ * @internal
+ * @{
+ */
+
+  /* an entry as parsed from the server */
+  struct SearchEntry
+  {
+    std::string dn;
+    std::string timestamp; // its modifyTimestamp, if the server gave it
+    std::string username;
+    std::map<std::string, std::string> call_addresses;
+  };
+
+  /* The entries of a book which were already fetched from the server,
+   * kept in a file of the user cache directory so that searches can be
+   * answered right away, while the server is asked again.
+   *
+   * The entries are indexed by the trigrams of their name and addresses.
+   * The cache is only used from the main thread.
+   */
+  class Cache
+  {
+  public:
+
+    Cache (const std::string _uri);
+
+    const std::string get_uri () const
+    { return uri; }
+
+    /* reads the cache file, if there is one */
+    void load ();
+
+    /* writes the cache file, if something changed */
+    void save ();
+
+    /* forgets everything, and removes the cache file */
+    void clear ();
+
+    /* returns the entry with that DN, or NULL */
+    const SearchEntry *find (const std::string dn) const;
+
+    /* adds an entry, or replaces the one with the same DN */
+    void add (const SearchEntry &entry);
+
+    /* removes the entries whose DN isn't in the given set */
+    void prune (const std::set<std::string> &dns);
+
+    /* the entries whose name or an address contains term, regardless
+     * of the case */
+    void lookup (const std::string term,
+		 std::vector<SearchEntry> &result) const;
+
+    /* when the whole directory was last listed (0 if never), and the most
+     * recent modifyTimestamp seen since : searching for what changed
+     * after it is enough to bring the cache up to date */
+    time_t get_complete_time () const
+    { return complete_time; }
+
+    void set_complete_time (time_t time);
+
+    const std::string get_newest_timestamp () const
+    { return newest_timestamp; }
+
+  private:
+
+    void index (unsigned slot);
+    void reindex ();
+    bool remove (const std::string dn);
+
+    std::string uri;
+    std::string path;
+
+    /* removed entries leave an empty slot, until the next reindex */
+    std::vector<SearchEntry> entries;
+    std::vector<std::string> haystacks;
+    std::map<std::string, unsigned> slots;
+    std::map<guint32, std::vector<unsigned> > trigrams;
+    unsigned removed;
+
+    time_t complete_time;
+    std::string newest_timestamp;
+    bool dirty;
+  };
+
+/**
+ * @}
+ */
+
+};
+
+#endif
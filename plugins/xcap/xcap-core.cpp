@@ -40,7 +40,7 @@
 #include "xcap-core.h"
 
 #include <libsoup/soup.h>
-#include <iostream>
+#include <map>
 
 /* declaration of XCAP::CoreImpl */
 
@@ -63,38 +63,53 @@ public:
 
   /* public to be used by C callbacks */
 
-  /* The memory management is a little complex, here is how it works :
+  /* The requests of an account all go through the same SOUP session, so
+   * the connections to the server (and their TLS sessions) are kept alive
+   * and reused from one request to the next, instead of a new session per
+   * request.
    *
-   * There are two kinds of live SOUP sessions :
-   * - the old sessions : we have to keep them around because we can't unref
-   * a SOUP session from result_callback, so we need to keep it
-   * around for later ;
-   * - the pending ones : we keep them around to be able to cancel them if
-   * we destroy the core (and cancelling calls result_callback with an
-   * error -- the sessions get pushed from pending to old) ;
+   * There is one session per username : a session remembers which
+   * credentials worked on a server, and gives them to the next requests
+   * to that server without being asked, so two accounts on the same server
+   * can't share one.
    *
-   * So the problem of freeing the SOUP sessions becomes one is reduced to
-   * that of freeing the old sessions :
-   * - in the read method, we check this old_sessions list and unref any old
-   * session we find : ok ;
-   * - in the destructor, we check the old_sesssions list and unref any old
-   * session we find.
-   *
-   * That means if you launch a thousand reads fast then nothing,
-   * we will end up with a thousand SOUP sessions in old_sessions. But any
-   * subsequent read will clear them all.
-   *
-   * If you launch a thousand reads not fast enough, the last reads will
-   * already find the first sessions and get rid of them.
+   * The sessions live as long as the core : the destructor aborts what is
+   * still pending (which calls the result callbacks with an error) before
+   * freeing them.
+   */
+  std::map<std::string, SoupSession*> sessions;
+  SoupSession* get_session (const std::string username);
+
+  /* The credentials last tried for each pending request : a request
+   * refused with them is only retried if the path got new ones meanwhile
+   * (for instance if the user fixed a wrong password).
+   */
+  struct PendingRequest
+  {
+    boost::shared_ptr<Path> path;
+    std::string username;
+    std::string password;
+  };
+  std::map<SoupMessage*, PendingRequest> pending;
+  void queue (SoupMessage* message,
+	      boost::shared_ptr<Path> path,
+	      SoupSessionCallback callback,
+	      gpointer data);
+
+  /* The documents read so far, with their entity tag, by uri : the next
+   * read of the same uri asks the server to answer only if it changed, and
+   * gets the cached document back if it didn't.
    *
-   * In short this code guarantees :
-   * - the number of old sessions can't really grow if we have reads from time
-   * to time  ;
-   * - all the sessions will get freed eventually -- no leak!
+   * The entity tag of a node is the one of its whole document, so any
+   * write or erase under a document forgets what was read from it.
    */
-  std::list<SoupSession*> pending_sessions;
-  std::list<SoupSession*> old_sessions;
-  void clear_old_sessions ();
+  struct CachedDocument
+  {
+    std::string etag;
+    std::string content;
+  };
+  std::map<std::string, CachedDocument> cache;
+  void forget_document (const std::string uri);
 };
 
 /* soup callbacks */
@@ -102,79 +117,108 @@ public:
 struct cb_read_data
 {
   XCAP::CoreImpl* core;
-  boost::shared_ptr<XCAP::Path> path;
+  std::string uri;
   boost::function2<void, bool, std::string> callback;
+
+  /* the cached document the request asked about, if any : a write may
+   * forget it from the cache before the server answers it didn't change */
+  std::string etag;
+  std::string content;
 };
 
 struct cb_other_data
 {
   XCAP::CoreImpl* core;
-  boost::shared_ptr<XCAP::Path> path;
+  std::string uri;
   boost::function1<void, std::string> callback;
 };
 
-static void
-authenticate_read_callback (G_GNUC_UNUSED SoupSession* session,
-			    G_GNUC_UNUSED SoupMessage* message,
-			    SoupAuth* auth,
-			    gboolean retrying,
-			    gpointer data)
+/* the uri of the document a node belongs to */
+static std::string
+document_uri (const std::string uri)
 {
-  cb_read_data* cb = (cb_read_data*)data;
-
-  if ( !retrying) {
-
-    soup_auth_authenticate (auth,
-			    cb->path->get_username ().c_str (),
-			    cb->path->get_password ().c_str ());
-  }
+  return uri.substr (0, uri.find ("/~~"));
 }
 
 static void
-authenticate_other_callback (G_GNUC_UNUSED SoupSession* session,
-			     G_GNUC_UNUSED SoupMessage* message,
-			     SoupAuth* auth,
-			     gboolean retrying,
-			     gpointer data)
+authenticate_callback (G_GNUC_UNUSED SoupSession* session,
+		       SoupMessage* message,
+		       SoupAuth* auth,
+		       gboolean retrying,
+		       gpointer data)
 {
-  cb_other_data* cb = (cb_other_data*)data;
+  XCAP::CoreImpl* core = (XCAP::CoreImpl*)data;
+  std::map<SoupMessage*, XCAP::CoreImpl::PendingRequest>::iterator iter
+    = core->pending.find (message);
+
+  if (iter == core->pending.end ())
+    return;
 
-  if ( !retrying) {
+  XCAP::CoreImpl::PendingRequest& request = iter->second;
+  const std::string username = request.path->get_username ();
+  const std::string password = request.path->get_password ();
 
-    soup_auth_authenticate (auth,
-			    cb->path->get_username ().c_str (),
-			    cb->path->get_password ().c_str ());
+  if ( !retrying
+      || username != request.username || password != request.password) {
+
+    request.username = username;
+    request.password = password;
+    soup_auth_authenticate (auth, username.c_str (), password.c_str ());
   }
 }
 
 static void
-result_read_callback (SoupSession* session,
+result_read_callback (G_GNUC_UNUSED SoupSession* session,
 		      SoupMessage* message,
 		      gpointer data)
 {
   cb_read_data* cb = (cb_read_data*)data;
+  std::map<std::string, XCAP::CoreImpl::CachedDocument>::iterator iter
+    = cb->core->cache.find (cb->uri);
 
-  if (message->status_code == SOUP_STATUS_OK) {
+  cb->core->pending.erase (message);
 
-    cb->callback (false, message->response_body->data);
+  if (message->status_code == SOUP_STATUS_NOT_MODIFIED
+      && !cb->etag.empty ()) {
+
+    cb->callback (false, cb->content);
+  } else if (message->status_code == SOUP_STATUS_OK) {
+
+    const char* etag = soup_message_headers_get_one (message->response_headers,
+						     "ETag");
+    std::string content (message->response_body->data,
+			 message->response_body->length);
+
+    if (etag != NULL) {
+
+      cb->core->cache[cb->uri].etag = etag;
+      cb->core->cache[cb->uri].content = content;
+    } else if (iter != cb->core->cache.end ()) {
+
+      cb->core->cache.erase (iter);
+    }
+
+    cb->callback (false, content);
   } else {
 
     cb->callback (true, message->reason_phrase);
   }
 
-  cb->core->pending_sessions.remove (session);
-  cb->core->old_sessions.push_back (session);
-
   delete cb;
 }
 
 static void
-result_other_callback (SoupSession* session,
+result_other_callback (G_GNUC_UNUSED SoupSession* session,
 		       SoupMessage* message,
 		       gpointer data)
 {
   cb_other_data* cb = (cb_other_data*)data;
 
+  cb->core->pending.erase (message);
+
+  /* even a failed request may have changed the document */
+  cb->core->forget_document (cb->uri);
+
   if (message->status_code == SOUP_STATUS_OK) {
 
     cb->callback ("");
@@ -183,9 +227,6 @@ result_other_callback (SoupSession* session,
     cb->callback (message->reason_phrase);
   }
 
-  cb->core->pending_sessions.remove (session);
-  cb->core->old_sessions.push_back (session);
-
   delete cb;
 }
 
@@ -197,55 +238,90 @@ XCAP::CoreImpl::CoreImpl ()
 
 XCAP::CoreImpl::~CoreImpl ()
 {
-  /* we loop like this because aborting calls result_callback, and hence
-   * makes the current iterator invalid : it gets pushed to the old sessions
-   * list!
-   */
-  while ( !pending_sessions.empty ())
-    soup_session_abort (*pending_sessions.begin ());
+  for (std::map<std::string, SoupSession*>::iterator iter = sessions.begin ();
+       iter != sessions.end ();
+       ++iter) {
+
+    /* this calls the result callbacks of the pending requests */
+    soup_session_abort (iter->second);
+
+    g_object_unref (iter->second);
+  }
+}
 
-  /* now all pending sessions have been made old, so we can do that: */
-  clear_old_sessions ();
+SoupSession*
+XCAP::CoreImpl::get_session (const std::string username)
+{
+  std::map<std::string, SoupSession*>::iterator iter = sessions.find (username);
+
+  if (iter != sessions.end ())
+    return iter->second;
+
+  SoupSession* session = soup_session_async_new_with_options ("user-agent", "ekiga", NULL);
+
+  g_signal_connect (session, "authenticate",
+		    G_CALLBACK (authenticate_callback), this);
+  sessions[username] = session;
+
+  return session;
 }
 
 void
-XCAP::CoreImpl::clear_old_sessions ()
+XCAP::CoreImpl::forget_document (const std::string uri)
 {
-  for (std::list<SoupSession*>::iterator iter = old_sessions.begin ();
-       iter != old_sessions.end ();
-       ++iter) {
+  const std::string document = document_uri (uri);
+  std::map<std::string, CachedDocument>::iterator iter = cache.begin ();
 
-    soup_session_abort (*iter); // needed ?
-    g_object_unref (*iter);
+  while (iter != cache.end ()) {
+
+    if (document_uri (iter->first) == document)
+      cache.erase (iter++);
+    else
+      ++iter;
   }
-  old_sessions.clear ();
+}
+
+void
+XCAP::CoreImpl::queue (SoupMessage* message,
+		       boost::shared_ptr<Path> path,
+		       SoupSessionCallback callback,
+		       gpointer data)
+{
+  PendingRequest& request = pending[message];
+
+  request.path = path;
+  request.username = path->get_username ();
+  request.password = path->get_password ();
+
+  soup_session_queue_message (get_session (request.username),
+			      message, callback, data);
 }
 
 void
 XCAP::CoreImpl::read (boost::shared_ptr<Path> path,
 		      boost::function2<void, bool, std::string> callback)
 {
-  SoupSession* session = NULL;
   SoupMessage* message = NULL;
   cb_read_data* data = NULL;
+  std::map<std::string, CachedDocument>::const_iterator iter;
 
-  clear_old_sessions ();
-
-  /* all of this is freed in the result callback */
-  session = soup_session_async_new_with_options ("user-agent", "ekiga", NULL);
-  message = soup_message_new ("GET", path->to_uri ().c_str ());
+  /* the message is freed by the session, the data in the result callback */
   data = new cb_read_data;
   data->core = this;
-  data->path = path;
+  data->uri = path->to_uri ();
   data->callback = callback;
+  message = soup_message_new ("GET", data->uri.c_str ());
 
-  g_signal_connect (session, "authenticate",
-		    G_CALLBACK (authenticate_read_callback), data);
+  iter = cache.find (data->uri);
+  if (iter != cache.end ()) {
 
-  soup_session_queue_message (session, message,
-			      result_read_callback, data);
+    data->etag = iter->second.etag;
+    data->content = iter->second.content;
+    soup_message_headers_append (message->request_headers,
+				 "If-None-Match", data->etag.c_str ());
+  }
 
-  pending_sessions.push_back (session);
+  queue (message, path, result_read_callback, data);
 }
 
 void
@@ -254,58 +330,37 @@ XCAP::CoreImpl::write (boost::shared_ptr<Path> path,
 		       const std::string content,
 		       boost::function1<void,std::string> callback)
 {
-  SoupSession* session = NULL;
   SoupMessage* message = NULL;
   cb_other_data* data = NULL;
 
-  clear_old_sessions ();
-
-  /* all of this is freed in the result callback */
-  session = soup_session_async_new_with_options ("user-agent", "ekiga", NULL);
-  message = soup_message_new ("PUT", path->to_uri ().c_str ());
-  soup_message_set_request (message, content_type.c_str (),
-			    SOUP_MEMORY_COPY,
-			    content.c_str (), content.length ());
-
+  /* the message is freed by the session, the data in the result callback */
   data = new cb_other_data;
   data->core = this;
-  data->path = path;
+  data->uri = path->to_uri ();
   data->callback = callback;
+  message = soup_message_new ("PUT", data->uri.c_str ());
+  soup_message_set_request (message, content_type.c_str (),
+			    SOUP_MEMORY_COPY,
+			    content.c_str (), content.length ());
 
-  g_signal_connect (session, "authenticate",
-		    G_CALLBACK (authenticate_other_callback), data);
-
-  soup_session_queue_message (session, message,
-			      result_other_callback, data);
-
-  pending_sessions.push_back (session);
+  queue (message, path, result_other_callback, data);
 }
 
 void
 XCAP::CoreImpl::erase (boost::shared_ptr<Path> path,
 		       boost::function1<void,std::string> callback)
 {
-  SoupSession* session = NULL;
   SoupMessage* message = NULL;
   cb_other_data* data = NULL;
 
-  clear_old_sessions ();
-
-  /* all of this is freed in the result callback */
-  session = soup_session_async_new_with_options ("user-agent", "ekiga", NULL);
-  message = soup_message_new ("DELETE", path->to_uri ().c_str ());
+  /* the message is freed by the session, the data in the result callback */
   data = new cb_other_data;
   data->core = this;
-  data->path = path;
+  data->uri = path->to_uri ();
   data->callback = callback;
+  message = soup_message_new ("DELETE", data->uri.c_str ());
 
-  g_signal_connect (session, "authenticate",
-		    G_CALLBACK (authenticate_other_callback), data);
-
-  soup_session_queue_message (session, message,
-			      result_other_callback, data);
-
-  pending_sessions.push_back (session);
+  queue (message, path, result_other_callback, data);
 }
 
 
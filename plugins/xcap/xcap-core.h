@@ -60,6 +60,9 @@ namespace XCAP
      * document you wanted ;
      * - if the boolean is true, there was an error and the string is the
      * error message.
+     *
+     * The path may point to a whole document or to a node of it. Reading a
+     * path already read only downloads it again if it changed on the server.
      */
     void read (boost::shared_ptr<Path>,
 	       boost::function2<void,bool,std::string> callback);
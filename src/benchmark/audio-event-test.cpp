@@ -0,0 +1,292 @@
+
+/* Ekiga -- A VoIP and Video-Conferencing application
+ * Copyright (C) 2000-2009 Damien Sandras <dsandras@seconix.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ *
+ * Ekiga is licensed under the GPL license and as a special exception,
+ * you have permission to link or otherwise combine this program with the
+ * programs OPAL, OpenH323 and PWLIB, and distribute the combination,
+ * without applying the requirements of the GNU GPL to the OPAL, OpenH323
+ * and PWLIB programs, as long as you do follow the requirements of the
+ * GNU GPL for all the rest of the software thus combined.
+ */
+
+
+/*
+ *                         audio-event-test.cpp  -  description
+ *                         ------------------------------------
+ *   begin                : written in 2012
+ *   copyright            : (C) 2012 by Damien Sandras
+ *   description          : Checks the queue of the sound events scheduler
+ *                          on a fake clock, and measures it under load.
+ *
+ */
+
+/* The queue is driven by a clock which only moves when told to, so that
+ * the times the events come out at can be checked exactly, whatever the
+ * load of the machine. The program exits with 1 if a check failed.
+ *
+ * The last part simulates many calls, each of them ringing, and reports
+ * what adding, playing and removing their events costs.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include <glib.h>
+#include <ptlib.h>
+#include <ptlib/pprocess.h>
+
+#include "audiooutput-scheduler.h"
+
+#include "bench-check.h"
+
+static gint nb_calls = 1000;
+static PInt64 now = 0;
+
+static PInt64
+fake_clock ()
+{
+  return now;
+}
+
+/* the names of the events due now, separated by spaces */
+static std::string
+pending_names (Ekiga::AudioEventQueue & queue)
+{
+  std::vector<Ekiga::AudioEvent> pending;
+  std::string result;
+
+  queue.get_pending (pending);
+  for (std::vector<Ekiga::AudioEvent>::iterator iter = pending.begin ();
+       iter != pending.end ();
+       iter++)
+    result += (result.empty () ? "" : " ") + iter->name;
+
+  return result;
+}
+
+static void
+test_single ()
+{
+  Ekiga::AudioEventQueue queue (fake_clock);
+
+  now = 1000;
+  check (queue.get_time_to_next () == 65535, "an empty queue has nothing due");
+
+  queue.add ("new_message", false, 0, 1);
+  check (queue.get_time_to_next () == 0, "a new event is due at once");
+  check (pending_names (queue) == "new_message", "a new event is played");
+  check (queue.size () == 0, "an event without repetitions is gone once played");
+  check (pending_names (queue) == "", "an event is played once");
+}
+
+static void
+test_repetitions ()
+{
+  Ekiga::AudioEventQueue queue (fake_clock);
+
+  now = 0;
+  queue.add ("ring_tone", false, 100, 3);
+  check (pending_names (queue) == "ring_tone", "first ring at once");
+  check (queue.get_time_to_next () == 100, "second ring in 100 ms");
+
+  now = 50;
+  check (pending_names (queue) == "", "no ring before it is due");
+  check (queue.get_time_to_next () == 50, "the wait shrinks with the clock");
+
+  now = 100;
+  check (pending_names (queue) == "ring_tone", "second ring on time");
+
+  /* a late wake up doesn't play the missed repetitions at once */
+  now = 350;
+  check (pending_names (queue) == "ring_tone", "third ring when late");
+  check (queue.size () == 0, "no ring left after the last one");
+  check (queue.get_time_to_next () == 65535, "nothing to wait for");
+}
+
+static void
+test_removal ()
+{
+  Ekiga::AudioEventQueue queue (fake_clock);
+
+  now = 0;
+  queue.add ("ring_tone", false, 100, 10);
+  queue.add ("busy_tone", false, 200, 10);
+  check (pending_names (queue) == "ring_tone busy_tone", "both are due at once");
+
+  queue.remove ("ring_tone");
+  check (queue.size () == 1, "the removed event is gone");
+  check (queue.get_time_to_next () == 200, "the removed event doesn't wake up");
+
+  now = 200;
+  check (pending_names (queue) == "busy_tone", "the removed event isn't played");
+
+  /* only the first of two events with the same name is removed */
+  queue.add ("dialpad", false, 0, 1);
+  queue.add ("dialpad", false, 0, 1);
+  queue.remove ("dialpad");
+  check (pending_names (queue) == "dialpad", "one dialpad event is left");
+
+  queue.remove ("unknown");
+  check (queue.size () == 1, "removing an unknown event changes nothing");
+}
+
+static void
+test_order ()
+{
+  Ekiga::AudioEventQueue queue (fake_clock);
+
+  now = 0;
+  queue.add ("a", false, 300, 2);
+  now = 10;
+  queue.add ("b", false, 100, 2);
+  now = 20;
+  queue.add ("c", false, 200, 2);
+  check (pending_names (queue) == "a b c", "due events come in the order they are due");
+
+  now = 400;
+  check (pending_names (queue) == "b c a", "repetitions come in the order they are due");
+}
+
+/* many calls ringing at once : the clock jumps from one due time to the
+ * next, and every ring must come out exactly when it is due */
+static void
+test_load ()
+{
+  Ekiga::AudioEventQueue queue (fake_clock);
+  std::vector<Ekiga::AudioEvent> pending;
+  const unsigned repetitions = 10;
+  const unsigned interval = 3000;
+  unsigned wait = 0;
+  unsigned played = 0;
+  unsigned late = 0;
+  GTimer* timer = g_timer_new ();
+  double add_time = 0;
+  double play_time = 0;
+  double remove_time = 0;
+
+  /* call i starts ringing at i, then rings every interval */
+  g_timer_start (timer);
+  for (int i = 0 ; i < nb_calls ; i++) {
+
+    gchar* name = g_strdup_printf ("ring_tone %d", i);
+
+    now = i;
+    queue.add (name, false, interval, repetitions);
+    g_free (name);
+  }
+  add_time = g_timer_elapsed (timer, NULL);
+
+  now = 0;
+  g_timer_start (timer);
+  while ((wait = queue.get_time_to_next ()) != 65535) {
+
+    now += wait;
+    queue.get_pending (pending);
+    for (std::vector<Ekiga::AudioEvent>::iterator iter = pending.begin ();
+         iter != pending.end ();
+         iter++) {
+
+      int call = atoi (iter->name.c_str () + strlen ("ring_tone "));
+      if ((now - call) % interval != 0)
+        late++;
+      played++;
+    }
+  }
+  play_time = g_timer_elapsed (timer, NULL);
+
+  check (late == 0, "every ring is played when it is due");
+  check (played == nb_calls * repetitions, "every ring is played");
+
+  /* the same calls, answered before their first repetition */
+  for (int i = 0 ; i < nb_calls ; i++) {
+
+    gchar* name = g_strdup_printf ("ring_tone %d", i);
+
+    queue.add (name, false, interval, repetitions);
+    g_free (name);
+  }
+
+  g_timer_start (timer);
+  for (int i = 0 ; i < nb_calls ; i++) {
+
+    gchar* name = g_strdup_printf ("ring_tone %d", i);
+
+    queue.remove (name);
+    g_free (name);
+  }
+  remove_time = g_timer_elapsed (timer, NULL);
+  g_timer_destroy (timer);
+
+  check (queue.size () == 0, "all the calls were removed");
+  check (queue.get_time_to_next () == 65535, "nothing is left to wait for");
+
+  printf ("%d calls: add %.0f ns, play %.0f ns per ring (%u rings), remove %.0f ns\n",
+          nb_calls,
+          add_time * 1e9 / nb_calls,
+          play_time * 1e9 / played, played,
+          remove_time * 1e9 / nb_calls);
+}
+
+
+class AudioEventTest: public PProcess
+{
+  PCLASSINFO(AudioEventTest, PProcess);
+
+public:
+
+  AudioEventTest (): PProcess ("Ekiga", "ekiga-audio-event-test")
+  {}
+
+  void Main ()
+  {}
+};
+
+
+int
+main (int argc,
+      char *argv [])
+{
+
+  GOptionEntry arguments [] =
+    {
+      { "calls", 'c', 0, G_OPTION_ARG_INT, &nb_calls,
+        "Number of calls ringing at once (default: 1000)", NULL },
+      { NULL, 0, 0, G_OPTION_ARG_NONE, NULL, NULL, NULL }
+    };
+
+  if (!bench_parse_options (&argc, &argv, arguments))
+    return 1;
+
+  if (nb_calls <= 0)
+    nb_calls = 1;
+
+  AudioEventTest instance;
+
+  test_single ();
+  test_repetitions ();
+  test_removal ();
+  test_order ();
+  test_load ();
+
+  return bench_result ();
+}
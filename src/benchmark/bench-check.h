@@ -0,0 +1,108 @@
+
+/* Ekiga -- A VoIP and Video-Conferencing application
+ * Copyright (C) 2000-2009 Damien Sandras <dsandras@seconix.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ *
+ * Ekiga is licensed under the GPL license and as a special exception,
+ * you have permission to link or otherwise combine this program with the
+ * programs OPAL, OpenH323 and PWLIB, and distribute the combination,
+ * without applying the requirements of the GNU GPL to the OPAL, OpenH323
+ * and PWLIB programs, as long as you do follow the requirements of the
+ * GNU GPL for all the rest of the software thus combined.
+ */
+
+
+
+/*
+ *                         bench-check.h  -  description
+ *                         ------------------------------------
+ *   begin                : written in 2012
+ *   copyright            : (C) 2012 by Damien Sandras
+ *   description          : What the check and benchmark programs share:
+ *                          their options and their checks.
+ *
+ */
+
+/* A program calls bench_parse_options with its own options, then check
+ * for each of the things it verifies, and returns what bench_result says:
+ * a failed check is reported at once, and makes the program exit with 1.
+ */
+
+#ifndef __BENCH_CHECK_H__
+#define __BENCH_CHECK_H__
+
+#include <stdio.h>
+
+#include <glib.h>
+
+static unsigned bench_failures = 0;
+
+/* the entries are ended by a NULL one, as for g_option_context_add_main_entries ;
+ * the group, if there is one, is for the options of a library */
+static inline bool
+bench_parse_options (int* argc,
+		     char*** argv,
+		     const GOptionEntry* entries,
+		     GOptionGroup* group = NULL)
+{
+  GOptionContext* context = NULL;
+  GError* error = NULL;
+  bool result = true;
+
+  context = g_option_context_new (NULL);
+  g_option_context_add_main_entries (context, entries, NULL);
+  if (group != NULL)
+    g_option_context_add_group (context, group);
+
+  if (!g_option_context_parse (context, argc, argv, &error)) {
+
+    fprintf (stderr, "%s\n", error->message);
+    g_error_free (error);
+    result = false;
+  }
+  g_option_context_free (context);
+
+  return result;
+}
+
+static inline void
+check (bool condition,
+       const char* what)
+{
+  if (!condition) {
+
+    printf ("FAILED: %s\n", what);
+    bench_failures++;
+  }
+}
+
+/* what main returns */
+static inline int
+bench_result ()
+{
+  if (bench_failures > 0) {
+
+    printf ("%u checks failed\n", bench_failures);
+    return 1;
+  }
+
+  printf ("all checks passed\n");
+
+  return 0;
+}
+
+#endif
@@ -0,0 +1,231 @@
+
+/* Ekiga -- A VoIP and Video-Conferencing application
+ * Copyright (C) 2000-2009 Damien Sandras <dsandras@seconix.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ *
+ * Ekiga is licensed under the GPL license and as a special exception,
+ * you have permission to link or otherwise combine this program with the
+ * programs OPAL, OpenH323 and PWLIB, and distribute the combination,
+ * without applying the requirements of the GNU GPL to the OPAL, OpenH323
+ * and PWLIB programs, as long as you do follow the requirements of the
+ * GNU GPL for all the rest of the software thus combined.
+ */
+
+
+
+/*
+ *                         gstreamer-latency-test.cpp  -  description
+ *                         ------------------------------------------
+ *   begin                : written in 2012
+ *   copyright            : (C) 2012 by Damien Sandras
+ *   description          : Checks the GStreamer helper of the audio
+ *                          plugin follows its pipelines' clock, with
+ *                          test pipelines.
+ *
+ */
+
+/* The helper is given pipelines like the ones of the audio plugin, with
+ * audiotestsrc in place of the input device and fakesink in place of the
+ * output one, and frames of 10, 20 and 40 ms go through them.
+ *
+ * Reads must follow the source : one frame every frame duration, whatever
+ * the frame size, and no more. Writes must not wait for more than the sink
+ * does : not at all for a sink which renders the frames as they come, and
+ * one frame duration per frame for a sink which plays them at real time
+ * (an identity element timestamps them by their size and waits for the
+ * clock), once the few frames the helper queues are used up. The average
+ * time and the longest time per frame are reported. The program exits with
+ * 1 if a check failed.
+ */
+
+#include <stdio.h>
+
+#include <glib.h>
+#include <gst/gst.h>
+
+#include "gst-helper.h"
+
+#include "bench-check.h"
+
+#define RATE 8000
+#define BYTES_PER_SAMPLE 2
+
+static gint nb_frames = 50;
+
+static void
+report (const char* direction,
+	unsigned frame_ms,
+	double total,
+	double longest)
+{
+  printf ("%-18s %4u ms frames: %6.1f ms per frame on average, %6.1f ms at most\n",
+	  direction, frame_ms, total * 1e3 / nb_frames, longest * 1e3);
+}
+
+/* an audio input, reading from a live test source */
+static void
+test_input (unsigned frame_ms)
+{
+  const unsigned samples = RATE * frame_ms / 1000;
+  const unsigned size = samples * BYTES_PER_SAMPLE;
+  gchar* command = NULL;
+  gst_helper* helper = NULL;
+  char* data = g_new (char, size);
+  unsigned read = 0;
+  unsigned short_reads = 0;
+  GTimer* timer = g_timer_new ();
+  double last = 0;
+  double now = 0;
+  double longest = 0;
+
+  command = g_strdup_printf ("audiotestsrc is-live=true samplesperbuffer=%u"
+			     " ! appsink max_buffers=2 drop=true"
+			     " caps=audio/x-raw-int"
+			     ",rate=%d"
+			     ",channels=1"
+			     ",width=%d"
+			     " name=ekiga_sink",
+			     samples, RATE, BYTES_PER_SAMPLE * 8);
+  helper = gst_helper_new (command);
+  g_free (command);
+  gst_helper_set_buffer_size (helper, size);
+
+  /* the first read waits for the pipeline to start */
+  gst_helper_get_frame_data (helper, data, size, read);
+
+  g_timer_start (timer);
+  for (gint ii = 0; ii < nb_frames; ii++) {
+
+    gst_helper_get_frame_data (helper, data, size, read);
+    if (read != size)
+      short_reads++;
+
+    now = g_timer_elapsed (timer, NULL);
+    longest = MAX (longest, now - last);
+    last = now;
+  }
+
+  gst_helper_close (helper);
+  g_timer_destroy (timer);
+  g_free (data);
+
+  report ("input", frame_ms, now, longest);
+  check (short_reads == 0, "every read gets a whole frame");
+  check (now > 0.75 * nb_frames * frame_ms / 1000,
+	 "reads wait for the source");
+  check (now < 1.25 * nb_frames * frame_ms / 1000,
+	 "reads don't wait for more than the source");
+}
+
+/* an audio output, writing to a sink which renders the frames on time,
+ * and as they come or at real time */
+static void
+test_output (unsigned frame_ms,
+	     bool real_time)
+{
+  const unsigned samples = RATE * frame_ms / 1000;
+  const unsigned size = samples * BYTES_PER_SAMPLE;
+  const double duration = (double) nb_frames * frame_ms / 1000;
+  gchar* real_time_element = g_strdup_printf (" ! identity datarate=%u sync=true",
+					      RATE * BYTES_PER_SAMPLE);
+  gchar* command = NULL;
+  gst_helper* helper = NULL;
+  char* data = g_new0 (char, size);
+  GTimer* timer = g_timer_new ();
+  double last = 0;
+  double now = 0;
+  double longest = 0;
+
+  command = g_strdup_printf ("appsrc"
+			     " is-live=true format=time do-timestamp=%s"
+			     " min-latency=1 max-latency=5000000"
+			     " name=ekiga_src"
+			     " caps=audio/x-raw-int"
+			     ",rate=%d"
+			     ",channels=1"
+			     ",width=%d"
+			     ",depth=%d"
+			     ",signed=true,endianness=1234"
+			     "%s"
+			     " ! fakesink sync=true",
+			     real_time ? "false" : "true",
+			     RATE, BYTES_PER_SAMPLE * 8, BYTES_PER_SAMPLE * 8,
+			     real_time ? real_time_element : "");
+  helper = gst_helper_new (command);
+  g_free (command);
+  g_free (real_time_element);
+  gst_helper_set_buffer_size (helper, size);
+
+  g_timer_start (timer);
+  for (gint ii = 0; ii < nb_frames; ii++) {
+
+    gst_helper_set_frame_data (helper, data, size);
+
+    now = g_timer_elapsed (timer, NULL);
+    longest = MAX (longest, now - last);
+    last = now;
+  }
+
+  gst_helper_close (helper);
+  g_timer_destroy (timer);
+  g_free (data);
+
+  report (real_time ? "output (real time)" : "output", frame_ms, now, longest);
+  if (real_time) {
+
+    /* the first frame is played at once, and the helper queues a few more
+     * besides the one being played : only the others make writes wait */
+    check (now > duration - (GST_HELPER_QUEUED_BUFFERS + 2) * frame_ms / 1000.0,
+	   "writes wait for a sink playing at real time");
+    check (now < 1.25 * duration,
+	   "writes don't wait for more than a sink playing at real time");
+  } else
+    check (now < 0.5 * duration,
+	   "writes don't wait when the sink keeps up");
+}
+
+int
+main (int argc,
+      char *argv [])
+{
+  const unsigned frame_sizes [] = { 10, 20, 40 };
+
+  GOptionEntry arguments [] =
+    {
+      { "frames", 'f', 0, G_OPTION_ARG_INT, &nb_frames,
+        "Number of frames measured for each size (default: 50)", NULL },
+      { NULL, 0, 0, G_OPTION_ARG_NONE, NULL, NULL, NULL }
+    };
+
+  if (!bench_parse_options (&argc, &argv, arguments,
+			    gst_init_get_option_group ()))
+    return 1;
+
+  if (nb_frames <= 0)
+    nb_frames = 1;
+
+  for (unsigned ii = 0; ii < G_N_ELEMENTS (frame_sizes); ii++)
+    test_input (frame_sizes[ii]);
+
+  for (unsigned ii = 0; ii < G_N_ELEMENTS (frame_sizes); ii++)
+    test_output (frame_sizes[ii], false);
+
+  for (unsigned ii = 0; ii < G_N_ELEMENTS (frame_sizes); ii++)
+    test_output (frame_sizes[ii], true);
+
+  return bench_result ();
+}
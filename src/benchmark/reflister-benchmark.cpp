@@ -0,0 +1,202 @@
+
+/* Ekiga -- A VoIP and Video-Conferencing application
+ * Copyright (C) 2000-2009 Damien Sandras <dsandras@seconix.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ *
+ * Ekiga is licensed under the GPL license and as a special exception,
+ * you have permission to link or otherwise combine this program with the
+ * programs OPAL, OpenH323 and PWLIB, and distribute the combination,
+ * without applying the requirements of the GNU GPL to the OPAL, OpenH323
+ * and PWLIB programs, as long as you do follow the requirements of the
+ * GNU GPL for all the rest of the software thus combined.
+ */
+
+
+
+/*
+ *                         reflister-benchmark.cpp  -  description
+ *                         ---------------------------------------
+ *   begin                : written in 2012
+ *   copyright            : (C) 2012 by Damien Sandras
+ *   description          : Measures the RefLister heaps, books and banks
+ *                          are built on, with many objects.
+ *
+ */
+
+/* A lister of many objects (10000 by default) is filled, its objects are
+ * updated, half of them are removed one by one and the rest all at once,
+ * first with the updated signal emitted at each change, then with the
+ * updates held around each batch.
+ *
+ * The time per object and the number of updated signals the lister emitted
+ * are reported for each step. The program exits with 1 if a lister didn't
+ * emit what it should have.
+ */
+
+#include <stdio.h>
+
+#include <vector>
+
+#include <glib.h>
+
+#include "reflister.h"
+
+#include "bench-check.h"
+
+static gint nb_objects = 10000;
+
+class Object: public Ekiga::LiveObject
+{
+public:
+
+  bool populate_menu (Ekiga::MenuBuilder &)
+  { return false; }
+};
+
+typedef boost::shared_ptr<Object> ObjectPtr;
+
+/* what a heap does with its lister, made public */
+class Lister: public Ekiga::RefLister<Object>
+{
+public:
+
+  Lister (): nb_updated(0)
+  { updated.connect (boost::bind (&Lister::on_updated, this)); }
+
+  bool populate_menu (Ekiga::MenuBuilder &)
+  { return false; }
+
+  using Ekiga::RefLister<Object>::add_object;
+  using Ekiga::RefLister<Object>::remove_object;
+  using Ekiga::RefLister<Object>::remove_all_objects;
+  using Ekiga::RefLister<Object>::hold_updates;
+  using Ekiga::RefLister<Object>::release_updates;
+  using Ekiga::RefLister<Object>::begin;
+  using Ekiga::RefLister<Object>::end;
+
+  unsigned nb_updated;
+
+private:
+
+  void on_updated ()
+  { nb_updated++; }
+};
+
+static void
+report (const char* step,
+	bool held,
+	double elapsed,
+	unsigned count,
+	unsigned nb_updated)
+{
+  printf ("%-12s %-8s %10.0f %10u\n",
+	  step, held ? "held" : "unheld",
+	  elapsed * 1e9 / count, nb_updated);
+}
+
+static void
+run (bool held)
+{
+  Lister lister;
+  std::vector<ObjectPtr> objects;
+  GTimer* timer = g_timer_new ();
+  const unsigned count = nb_objects;
+  const unsigned half = count / 2;
+
+  for (unsigned i = 0 ; i < count ; i++)
+    objects.push_back (ObjectPtr (new Object));
+
+  /* adding */
+  lister.nb_updated = 0;
+  g_timer_start (timer);
+  if (held)
+    lister.hold_updates ();
+  for (unsigned i = 0 ; i < count ; i++)
+    lister.add_object (objects[i]);
+  if (held)
+    lister.release_updates ();
+  report ("add", held, g_timer_elapsed (timer, NULL), count, lister.nb_updated);
+  check (lister.nb_updated == (held ? 1 : count),
+	 "adding emits updated once per object, or once when held");
+
+  /* updating every object */
+  lister.nb_updated = 0;
+  g_timer_start (timer);
+  if (held)
+    lister.hold_updates ();
+  for (unsigned i = 0 ; i < count ; i++)
+    objects[i]->updated ();
+  if (held)
+    lister.release_updates ();
+  report ("update", held, g_timer_elapsed (timer, NULL), count, lister.nb_updated);
+  check (lister.nb_updated == (held ? 1 : count),
+	 "updating emits updated once per object, or once when held");
+
+  /* removing half of them, one by one */
+  lister.nb_updated = 0;
+  g_timer_start (timer);
+  if (held)
+    lister.hold_updates ();
+  for (unsigned i = 0 ; i < half ; i++)
+    lister.remove_object (objects[i]);
+  if (held)
+    lister.release_updates ();
+  report ("remove", held, g_timer_elapsed (timer, NULL), half, lister.nb_updated);
+  check (lister.nb_updated == (held ? 1 : half),
+	 "removing emits updated once per object, or once when held");
+
+  /* a removed object doesn't reach the lister anymore */
+  lister.nb_updated = 0;
+  objects[0]->updated ();
+  check (lister.nb_updated == 0, "a removed object isn't listened to");
+
+  /* removing the rest at once */
+  lister.nb_updated = 0;
+  g_timer_start (timer);
+  lister.remove_all_objects ();
+  report ("remove_all", held, g_timer_elapsed (timer, NULL), count - half, lister.nb_updated);
+  check (lister.nb_updated == 1, "removing all the objects emits updated once");
+  check (lister.begin () == lister.end (), "no object is left");
+
+  g_timer_destroy (timer);
+}
+
+int
+main (int argc,
+      char *argv [])
+{
+
+  GOptionEntry arguments [] =
+    {
+      { "objects", 'o', 0, G_OPTION_ARG_INT, &nb_objects,
+        "Number of objects in the lister (default: 10000)", NULL },
+      { NULL, 0, 0, G_OPTION_ARG_NONE, NULL, NULL, NULL }
+    };
+
+  if (!bench_parse_options (&argc, &argv, arguments))
+    return 1;
+
+  if (nb_objects < 2)
+    nb_objects = 2;
+
+  printf ("%d objects\n", nb_objects);
+  printf ("%-12s %-8s %10s %10s\n", "step", "updates", "ns/object", "updated");
+  run (false);
+  run (true);
+
+  return bench_result ();
+}
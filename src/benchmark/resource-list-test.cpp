@@ -0,0 +1,271 @@
+
+/* Ekiga -- A VoIP and Video-Conferencing application
+ * Copyright (C) 2000-2009 Damien Sandras <dsandras@seconix.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ *
+ * Ekiga is licensed under the GPL license and as a special exception,
+ * you have permission to link or otherwise combine this program with the
+ * programs OPAL, OpenH323 and PWLIB, and distribute the combination,
+ * without applying the requirements of the GNU GPL to the OPAL, OpenH323
+ * and PWLIB programs, as long as you do follow the requirements of the
+ * GNU GPL for all the rest of the software thus combined.
+ */
+
+
+
+/*
+ *                         resource-list-test.cpp  -  description
+ *                         ------------------------------------------
+ *   begin                : written in 2012
+ *   copyright            : (C) 2012 by Damien Sandras
+ *   description          : Checks the parser of the NOTIFY bodies of
+ *                          SIP resource lists, on canned ones.
+ *
+ */
+
+/* Each NOTIFY body is a multipart/related one (RFC 4662), with an RLMI
+ * document and a PIDF document per resource with a known presence ; the
+ * checks are on what the parser makes of them. The program exits with 1
+ * if a check failed.
+ */
+
+#include <string>
+#include <list>
+
+#include "sip-resource-list.h"
+
+#include "bench-check.h"
+
+#define RLMI_TYPE "multipart/related;type=\"application/rlmi+xml\""
+
+static const char* rlmi_full =
+  "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\r\n"
+  "<list xmlns=\"urn:ietf:params:xml:ns:rlmi\" uri=\"sip:buddies@example.com\""
+  " version=\"1\" fullState=\"true\">\r\n"
+  "  <resource uri=\"sip:bob@example.com\">\r\n"
+  "    <instance id=\"1\" state=\"active\" cid=\"bob@example.com\"/>\r\n"
+  "  </resource>\r\n"
+  "  <resource uri=\"sip:dave@example.com\">\r\n"
+  "    <instance id=\"2\" state=\"pending\"/>\r\n"
+  "  </resource>\r\n"
+  "</list>\r\n";
+
+static const char* pidf_bob_open =
+  "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\r\n"
+  "<presence xmlns=\"urn:ietf:params:xml:ns:pidf\" entity=\"sip:bob@example.com\">\r\n"
+  "  <tuple id=\"a\"><status><basic>closed</basic></status></tuple>\r\n"
+  "  <tuple id=\"b\"><status><basic>open</basic></status>"
+  "<note>In a meeting</note></tuple>\r\n"
+  "</presence>\r\n";
+
+static const char* pidf_bob_closed =
+  "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\r\n"
+  "<presence xmlns=\"urn:ietf:params:xml:ns:pidf\" entity=\"sip:bob@example.com\">\r\n"
+  "  <tuple id=\"a\"><status><basic>closed</basic></status></tuple>\r\n"
+  "  <note>Gone home</note>\r\n"
+  "</presence>\r\n";
+
+/* a multipart body, with CRLF line breaks as on the wire */
+static std::string
+part (const std::string boundary,
+      const std::string type,
+      const std::string id,
+      const std::string contents)
+{
+  std::string result = "--" + boundary + "\r\n";
+
+  result += "Content-Transfer-Encoding: binary\r\n";
+  if (!id.empty ())
+    result += "Content-ID: <" + id + ">\r\n";
+  result += "Content-Type: " + type + "\r\n\r\n";
+  result += contents + "\r\n";
+
+  return result;
+}
+
+static std::string
+end (const std::string boundary)
+{
+  return "--" + boundary + "--\r\n";
+}
+
+static const Opal::Sip::ResourceState*
+find (const std::list<Opal::Sip::ResourceState> & resources,
+      const std::string uri)
+{
+  for (std::list<Opal::Sip::ResourceState>::const_iterator iter = resources.begin ();
+       iter != resources.end ();
+       ++iter)
+    if (iter->uri == uri)
+      return &*iter;
+
+  return NULL;
+}
+
+static void
+test_full_state ()
+{
+  const std::string body =
+    part ("50UBfW7LSCVLtggUPe5z", "application/rlmi+xml;charset=\"UTF-8\"",
+	  "nXYxAE@pres.example.com", rlmi_full)
+    + part ("50UBfW7LSCVLtggUPe5z", "application/pidf+xml;charset=\"UTF-8\"",
+	    "bob@example.com", pidf_bob_open)
+    + end ("50UBfW7LSCVLtggUPe5z");
+  std::list<Opal::Sip::ResourceState> resources;
+  bool full_state = false;
+  const Opal::Sip::ResourceState* bob = NULL;
+  const Opal::Sip::ResourceState* dave = NULL;
+
+  check (Opal::Sip::parse_resource_list (RLMI_TYPE ";boundary=\"50UBfW7LSCVLtggUPe5z\"",
+					 body, full_state, resources),
+	 "a full state NOTIFY is parsed");
+  check (full_state, "a full state NOTIFY is seen as such");
+  check (resources.size () == 2, "a full state NOTIFY has all the resources");
+
+  bob = find (resources, "sip:bob@example.com");
+  check (bob && bob->state == "active", "an active resource is active");
+  check (bob && bob->has_presence && bob->open, "a resource with an open tuple is open");
+  check (bob && bob->note == "In a meeting", "the note of a tuple is the resource's");
+
+  dave = find (resources, "sip:dave@example.com");
+  check (dave && dave->state == "pending", "a pending resource is pending");
+  check (dave && !dave->has_presence, "a resource without a document has no presence");
+}
+
+static void
+test_partial_state ()
+{
+  std::string rlmi = rlmi_full;
+  rlmi.replace (rlmi.find ("fullState=\"true\""), 16, "fullState=\"false\"");
+  rlmi.replace (rlmi.find ("  <resource uri=\"sip:dave"), std::string::npos, "</list>\r\n");
+
+  const std::string body =
+    part ("boundary42", "application/rlmi+xml", "rlmi@example.com", rlmi)
+    + part ("boundary42", "application/pidf+xml", "bob@example.com", pidf_bob_closed)
+    + end ("boundary42");
+  std::list<Opal::Sip::ResourceState> resources;
+  bool full_state = true;
+
+  check (Opal::Sip::parse_resource_list (RLMI_TYPE ";boundary=\"boundary42\"",
+					 body, full_state, resources),
+	 "a partial state NOTIFY is parsed");
+  check (!full_state, "a partial state NOTIFY is seen as such");
+  check (resources.size () == 1, "a partial state NOTIFY has only what changed");
+  check (!resources.empty () && resources.front ().has_presence
+	 && !resources.front ().open,
+	 "a resource without an open tuple is closed");
+  check (!resources.empty () && resources.front ().note == "Gone home",
+	 "the note of the document is the resource's when no tuple has one");
+}
+
+/* the root is named by the start parameter, and isn't the first part ;
+ * the start parameter is quoted and contains a semicolon, and the
+ * boundary isn't quoted */
+static void
+test_start ()
+{
+  const std::string body =
+    "This is a preamble.\r\n"
+    + part ("zz;z", "application/pidf+xml", "bob@example.com", pidf_bob_open)
+    + part ("zz;z", "application/rlmi+xml", "root;1@example.com", rlmi_full)
+    + end ("zz;z");
+  std::list<Opal::Sip::ResourceState> resources;
+  bool full_state = false;
+  const Opal::Sip::ResourceState* bob = NULL;
+
+  check (Opal::Sip::parse_resource_list (RLMI_TYPE "; start=\"<root;1@example.com>\"; boundary=\"zz;z\"",
+					 body, full_state, resources),
+	 "the root part is found from the start parameter");
+  bob = find (resources, "sip:bob@example.com");
+  check (bob && bob->has_presence && bob->open, "the parts before the root are used");
+}
+
+static void
+test_boundaries ()
+{
+  const std::string body =
+    part ("simple-boundary", "application/rlmi+xml", "rlmi@example.com", rlmi_full)
+    + part ("simple-boundary", "application/pidf+xml", "bob@example.com", pidf_bob_open)
+    + end ("simple-boundary");
+  std::list<Opal::Sip::ResourceState> resources;
+  bool full_state = false;
+
+  check (Opal::Sip::parse_resource_list (RLMI_TYPE ";boundary=simple-boundary",
+					 body, full_state, resources)
+	 && resources.size () == 2,
+	 "an unquoted boundary is used");
+
+  resources.clear ();
+  check (Opal::Sip::parse_resource_list ("Multipart/Related; Boundary=\"simple-boundary\"",
+					 body, full_state, resources)
+	 && resources.size () == 2,
+	 "a quoted boundary is used, and names are case-insensitive");
+
+  /* an earlier quoted parameter with what looks like a boundary in it */
+  resources.clear ();
+  check (Opal::Sip::parse_resource_list (RLMI_TYPE ";start=\"<a;boundary=fake>\";boundary=simple-boundary",
+					 body, full_state, resources)
+	 && resources.size () == 2,
+	 "the boundary isn't taken from another quoted parameter");
+
+  resources.clear ();
+  check (!Opal::Sip::parse_resource_list (RLMI_TYPE ";boundary=other",
+					  body, full_state, resources),
+	 "a body without the boundary isn't a resource list");
+  check (!Opal::Sip::parse_resource_list ("application/pidf+xml", pidf_bob_open,
+					  full_state, resources),
+	 "a single PIDF document isn't a resource list");
+}
+
+static void
+test_missing_pidf ()
+{
+  const std::string body =
+    part ("b", "application/rlmi+xml", "rlmi@example.com", rlmi_full)
+    + end ("b");
+  std::list<Opal::Sip::ResourceState> resources;
+  bool full_state = false;
+  const Opal::Sip::ResourceState* bob = NULL;
+
+  check (Opal::Sip::parse_resource_list (RLMI_TYPE ";boundary=b",
+					 body, full_state, resources),
+	 "a NOTIFY with a missing document is parsed");
+  bob = find (resources, "sip:bob@example.com");
+  check (bob && bob->state == "active" && !bob->has_presence,
+	 "a resource whose document is missing has no presence");
+}
+
+int
+main (int argc,
+      char *argv [])
+{
+  GOptionEntry arguments [] =
+    {
+      { NULL, 0, 0, G_OPTION_ARG_NONE, NULL, NULL, NULL }
+    };
+
+  if (!bench_parse_options (&argc, &argv, arguments))
+    return 1;
+
+  test_full_state ();
+  test_partial_state ();
+  test_start ();
+  test_boundaries ();
+  test_missing_pidf ();
+
+  return bench_result ();
+}
@@ -0,0 +1,346 @@
+
+/* Ekiga -- A VoIP and Video-Conferencing application
+ * Copyright (C) 2000-2009 Damien Sandras <dsandras@seconix.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ *
+ * Ekiga is licensed under the GPL license and as a special exception,
+ * you have permission to link or otherwise combine this program with the
+ * programs OPAL, OpenH323 and PWLIB, and distribute the combination,
+ * without applying the requirements of the GNU GPL to the OPAL, OpenH323
+ * and PWLIB programs, as long as you do follow the requirements of the
+ * GNU GPL for all the rest of the software thus combined.
+ */
+
+
+
+/*
+ *                         text-enhancer-benchmark.cpp  -  description
+ *                         -------------------------------------------
+ *   begin                : written in 2012
+ *   copyright            : (C) 2012 by Damien Sandras
+ *   description          : Checks the smiley helper of the chat text
+ *                          enhancer against the former one, and measures
+ *                          them on a long message.
+ *
+ */
+
+/* The smiley helper used to run one strstr over the rest of the text per
+ * smiley it knows ; it now walks the text once. The former way is kept
+ * here, and both must find the same smiley at the same place on many
+ * random strings (200000 by default) made of smiley characters.
+ *
+ * Then all the smileys of a long message (200 KB by default) are found
+ * both ways, and the time it took is reported. Last, the message is
+ * inserted through an enhancer with the link and smiley helpers, as a chat
+ * area does: that part needs a display with an icon theme, and is skipped
+ * without one -- run the benchmark under Xvfb (e.g. with xvfb-run) on a
+ * build machine.
+ *
+ * The program exits with 1 if a check failed.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <string>
+
+#include <glib.h>
+#include <gtk/gtk.h>
+
+#include "gm-smileys.h"
+#include "gm-text-buffer-enhancer.h"
+#include "gm-text-extlink.h"
+#include "gm-text-smiley.h"
+
+#include "bench-check.h"
+
+static gint nb_strings = 200000;
+static gint kilobytes = 200;
+
+typedef void (*CheckFunction) (GmTextBufferEnhancerHelper* helper,
+			       const gchar* full_text,
+			       gint from,
+			       gint* start,
+			       gint* length);
+
+/* the smiley check as it was : the smiley chosen is the one which starts
+ * the soonest, and the longest one in case of equality */
+static void
+former_smiley_check (G_GNUC_UNUSED GmTextBufferEnhancerHelper* helper,
+		     const gchar* full_text,
+		     gint from,
+		     gint* start,
+		     gint* length)
+{
+  const gchar **smileys = gm_get_smileys ();
+  gint smiley = 0;
+  gint best_start = 0;
+  gint best_smiley = -1;
+  const char* found = NULL;
+  gint found_start = 0;
+
+  for (smiley = 0;
+       smileys[smiley] != NULL;
+       smiley = smiley + 2) {
+
+    found = strstr (full_text + from, smileys[smiley]);
+    if (found != NULL) {
+
+      found_start = found - full_text;
+      if ((best_smiley == -1)
+          || (found_start < best_start)
+	  || ((found_start == best_start)
+	      && (strlen (smileys[smiley]) > strlen (smileys[best_smiley])))) {
+
+	best_smiley = smiley;
+	best_start = found_start;
+      }
+    }
+  }
+
+  if (best_smiley != -1) {
+
+    *start = best_start;
+    *length = strlen (smileys[best_smiley]);
+  } else
+    *length = 0;
+}
+
+/* random strings made of smileys, beginnings of smileys and single
+ * characters of the smileys (or a few others), so that there are many
+ * smileys, partial ones and overlapping ones */
+static void
+test_equivalence (GmTextBufferEnhancerHelper* smiley_helper)
+{
+  const gchar **smileys = gm_get_smileys ();
+  gint nb_smileys = 0;
+  const gchar* smiley = NULL;
+  std::string alphabet = "a ";
+  GRand* rand = g_rand_new_with_seed (42);
+  std::string text;
+  gint from = 0;
+  gint former_start = 0;
+  gint former_length = 0;
+  gint start = 0;
+  gint length = 0;
+  unsigned found = 0;
+  unsigned differences = 0;
+
+  for (nb_smileys = 0; smileys[2 * nb_smileys] != NULL; nb_smileys++)
+    for (const gchar* ptr = smileys[2 * nb_smileys]; *ptr != '\0'; ptr++)
+      if (alphabet.find (*ptr) == std::string::npos)
+	alphabet += *ptr;
+
+  for (gint ii = 0; ii < nb_strings; ii++) {
+
+    text.clear ();
+    for (gint jj = g_rand_int_range (rand, 0, 7); jj > 0; jj--) {
+
+      smiley = smileys[2 * g_rand_int_range (rand, 0, nb_smileys)];
+      switch (g_rand_int_range (rand, 0, 3)) {
+
+      case 0:
+	text += smiley;
+	break;
+      case 1:
+	text.append (smiley, g_rand_int_range (rand, 1, strlen (smiley) + 1));
+	break;
+      default:
+	text += alphabet[g_rand_int_range (rand, 0, alphabet.length ())];
+	break;
+      }
+    }
+    from = g_rand_int_range (rand, 0, text.length () + 1);
+
+    former_start = start = -1;
+    former_smiley_check (NULL, text.c_str (), from,
+			 &former_start, &former_length);
+    gm_text_buffer_enhancer_helper_check (smiley_helper, text.c_str (), from,
+					  &start, &length);
+
+    if (former_length > 0)
+      found++;
+
+    if (length != former_length
+	|| (length > 0 && start != former_start)) {
+
+      if (differences < 10)
+	printf ("\"%s\" from %d: %d (%d) instead of %d (%d)\n",
+		text.c_str (), from,
+		start, length, former_start, former_length);
+      differences++;
+    }
+  }
+
+  g_rand_free (rand);
+
+  printf ("%d strings, %u with a smiley, %u differences\n",
+	  nb_strings, found, differences);
+  check (differences == 0, "the smiley helper finds what it used to");
+}
+
+/* about one smiley every 200 bytes, and a link every 2000 bytes */
+static std::string
+build_message ()
+{
+  const gchar **smileys = gm_get_smileys ();
+  const gint size = kilobytes * 1024;
+  gint smiley = 0;
+  unsigned line = 0;
+  std::string message;
+
+  while ((gint) message.length () < size) {
+
+    message += "Did you read the log of the last call? It has all of it: ";
+    message += "the codecs, the network and some more ";
+    message += smileys[smiley];
+    message += ", so have a look at it before ";
+    if (line % 10 == 0)
+      message += "http://www.ekiga.org/ and ";
+    message += "we talk again.\n";
+
+    smiley = smileys[smiley + 2] != NULL ? smiley + 2 : 0;
+    line++;
+  }
+
+  return message;
+}
+
+/* finds all the smileys of the text, one after the other, as the enhancer
+ * does */
+static unsigned
+find_all (CheckFunction check_function,
+	  GmTextBufferEnhancerHelper* helper,
+	  const std::string& text,
+	  double* elapsed)
+{
+  GTimer* timer = g_timer_new ();
+  gint position = 0;
+  gint start = 0;
+  gint length = 0;
+  unsigned count = 0;
+
+  g_timer_start (timer);
+  while (position < (gint) text.length ()) {
+
+    check_function (helper, text.c_str (), position, &start, &length);
+    if (length <= 0)
+      break;
+
+    count++;
+    position = start + length;
+  }
+  *elapsed = g_timer_elapsed (timer, NULL);
+  g_timer_destroy (timer);
+
+  return count;
+}
+
+static void
+test_message (GmTextBufferEnhancerHelper* smiley_helper,
+	      const std::string& message)
+{
+  double former_time = 0;
+  double time = 0;
+  unsigned former_count = 0;
+  unsigned count = 0;
+
+  former_count = find_all (former_smiley_check, NULL, message, &former_time);
+  count = find_all (gm_text_buffer_enhancer_helper_check, smiley_helper,
+		    message, &time);
+
+  printf ("%d KB, %u smileys: former %.1f ms, now %.1f ms\n",
+	  kilobytes, count, former_time * 1e3, time * 1e3);
+  check (count == former_count, "the same smileys are found in the message");
+}
+
+/* the message goes through an enhancer set up like the one of a chat area */
+static void
+test_insertion (const std::string& message)
+{
+  GtkTextBuffer* buffer = gtk_text_buffer_new (NULL);
+  GmTextBufferEnhancer* enhancer = gm_text_buffer_enhancer_new (buffer);
+  GmTextBufferEnhancerHelper* helper = NULL;
+  GtkTextTag* tag = NULL;
+  GtkTextIter iter;
+  GTimer* timer = g_timer_new ();
+
+  tag = gtk_text_buffer_create_tag (buffer, "external-link",
+				    "foreground", "blue",
+				    "underline", PANGO_UNDERLINE_SINGLE,
+				    NULL);
+  helper = gm_text_extlink_new ("\\<(http[s]?|[s]?ftp)://[^[:blank:]]+\\>", tag);
+  gm_text_buffer_enhancer_add_helper (enhancer, helper);
+  g_object_unref (helper);
+
+  helper = gm_text_smiley_new ();
+  gm_text_buffer_enhancer_add_helper (enhancer, helper);
+  g_object_unref (helper);
+
+  gtk_text_buffer_get_end_iter (buffer, &iter);
+  g_timer_start (timer);
+  gm_text_buffer_enhancer_insert_text (enhancer, &iter,
+				       message.c_str (), message.length ());
+  printf ("%d KB inserted through the enhancer: %.1f ms\n",
+	  kilobytes, g_timer_elapsed (timer, NULL) * 1e3);
+
+  g_timer_destroy (timer);
+  g_object_unref (enhancer);
+  g_object_unref (buffer);
+}
+
+int
+main (int argc,
+      char *argv [])
+{
+  GmTextBufferEnhancerHelper* smiley_helper = NULL;
+  std::string message;
+
+  GOptionEntry arguments [] =
+    {
+      { "strings", 's', 0, G_OPTION_ARG_INT, &nb_strings,
+        "Number of random strings checked (default: 200000)", NULL },
+      { "kilobytes", 'k', 0, G_OPTION_ARG_INT, &kilobytes,
+        "Size of the long message, in KB (default: 200)", NULL },
+      { NULL, 0, 0, G_OPTION_ARG_NONE, NULL, NULL, NULL }
+    };
+
+#if !GLIB_CHECK_VERSION(2,36,0)
+  g_type_init ();
+#endif
+
+  if (!bench_parse_options (&argc, &argv, arguments))
+    return 1;
+
+  if (kilobytes <= 0)
+    kilobytes = 1;
+
+  smiley_helper = gm_text_smiley_new ();
+  message = build_message ();
+
+  test_equivalence (smiley_helper);
+  test_message (smiley_helper, message);
+
+  if (gtk_init_check (&argc, &argv))
+    test_insertion (message);
+  else
+    printf ("No display, the insertion through the enhancer is skipped\n");
+
+  g_object_unref (smiley_helper);
+
+  return bench_result ();
+}
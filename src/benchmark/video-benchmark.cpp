@@ -0,0 +1,678 @@
+/* Ekiga -- A VoIP and Video-Conferencing application
+ * Copyright (C) 2000-2009 Damien Sandras <dsandras@seconix.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ *
+ * Ekiga is licensed under the GPL license and as a special exception,
+ * you have permission to link or otherwise combine this program with the
+ * programs OPAL, OpenH323 and PWLIB, and distribute the combination,
+ * without applying the requirements of the GNU GPL to the OPAL, OpenH323
+ * and PWLIB programs, as long as you do follow the requirements of the
+ * GNU GPL for all the rest of the software thus combined.
+ */
+
+
+/*
+ *                         video-benchmark.cpp  -  description
+ *                         -----------------------------------
+ *   begin                : written in 2012
+ *   copyright            : (C) 2012 by Damien Sandras
+ *   description          : Measures the video rendering paths one by one,
+ *                          with synthetic YUV420P frames.
+ *
+ */
+
+/* Every path is fed with synthetic frames at CIF, VGA, 720p and 1080p, and
+ * the time per frame, the number of frame-sized copies or conversions done
+ * by ekiga on that path and the throughput (in source bytes) are reported.
+ *
+ * The software scaling paths and the XVideo copy loop don't need an X
+ * server. The XWindow and XVWindow paths need one, which can be a headless
+ * one: run the benchmark under Xvfb (e.g. with xvfb-run) to measure them
+ * on a build machine. GMVideoOutputManager::set_frame_data is measured
+ * with a manager displaying nowhere.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include <glib.h>
+#include <ptlib.h>
+#include <ptlib/pprocess.h>
+#include <ptlib/vconvert.h>
+
+extern "C" {
+#include <pixops.h>
+#include <yuv-scale.h>
+}
+
+#include "xwindow.h"
+#ifdef HAVE_XV
+#include "xvwindow.h"
+#endif
+
+#include "services.h"
+#include "runtime.h"
+#include "videooutput-frame.h"
+#include "videooutput-manager-common.h"
+
+#define NB_FRAMES 4
+
+struct Resolution
+{
+  const char* name;
+  unsigned width;
+  unsigned height;
+};
+
+static const Resolution resolutions[] = {
+  { "CIF", 352, 288 },
+  { "VGA", 640, 480 },
+  { "720p", 1280, 720 },
+  { "1080p", 1920, 1080 }
+};
+
+static gint zoom = 200;
+static gdouble duration = 1.0;
+static gboolean no_display = FALSE;
+
+
+/* A few different frames, so that no path works on a single cached one */
+class SyntheticFrames
+{
+public:
+
+  SyntheticFrames (unsigned _width,
+                   unsigned _height)
+    : width(_width), height(_height)
+  {
+    for (unsigned i = 0 ; i < NB_FRAMES ; i++) {
+
+      std::vector<char> frame (Ekiga::VideoFrame::size_for (width, height));
+      char* y = &frame[0];
+      char* u = y + width * height;
+      char* v = u + width * height / 4;
+
+      for (unsigned row = 0 ; row < height ; row++)
+        for (unsigned col = 0 ; col < width ; col++)
+          y[row * width + col] = (col + row + 8 * i) & 0xff;
+
+      for (unsigned row = 0 ; row < height / 2 ; row++)
+        for (unsigned col = 0 ; col < width / 2 ; col++) {
+
+          u[row * width / 2 + col] = (2 * col + i) & 0xff;
+          v[row * width / 2 + col] = (2 * row - i) & 0xff;
+        }
+
+      frames.push_back (frame);
+    }
+  }
+
+  const char* get (unsigned n) const
+  { return &frames[n % NB_FRAMES][0]; }
+
+  unsigned width;
+  unsigned height;
+
+private:
+
+  std::vector<std::vector<char> > frames;
+};
+
+
+/* A path of the pipeline, run once per frame */
+class BenchmarkPath
+{
+public:
+
+  virtual ~BenchmarkPath ()
+  {}
+
+  virtual void step (const char* frame) = 0;
+};
+
+static void
+run_path (const std::string & name,
+          const Resolution & resolution,
+          unsigned copies,
+          BenchmarkPath & path,
+          const SyntheticFrames & frames)
+{
+  GTimer* timer = g_timer_new ();
+  unsigned n = 0;
+  double elapsed = 0;
+  double frame_size = Ekiga::VideoFrame::size_for (resolution.width, resolution.height);
+
+  path.step (frames.get (0)); // warm-up
+
+  g_timer_start (timer);
+  do {
+
+    path.step (frames.get (n));
+    n++;
+    elapsed = g_timer_elapsed (timer, NULL);
+  } while (n < 10 || elapsed < duration);
+  g_timer_destroy (timer);
+
+  printf ("%-30s %-6s %12.0f %7u %10.1f %10.1f\n",
+          name.c_str (), resolution.name,
+          elapsed * 1e9 / n,
+          copies,
+          frame_size * n / elapsed / (1024 * 1024),
+          n / elapsed);
+  fflush (stdout);
+}
+
+static void
+skip_path (const std::string & name,
+           const Resolution & resolution,
+           const char* reason)
+{
+  printf ("%-30s %-6s skipped: %s\n", name.c_str (), resolution.name, reason);
+}
+
+
+/* The XWindow software path as it was : colour conversion then scaling */
+class PixopsPath: public BenchmarkPath
+{
+public:
+
+  PixopsPath (unsigned _width,
+              unsigned _height,
+              unsigned _dest_width,
+              unsigned _dest_height)
+    : width(_width), height(_height),
+      dest_width(_dest_width), dest_height(_dest_height),
+      converted(_width * _height * 4), dest(_dest_width * _dest_height * 4)
+  {
+    PVideoFrameInfo src_info, dest_info;
+
+    src_info.SetFrameSize (width, height);
+    dest_info.SetFrameSize (width, height);
+    dest_info.SetColourFormat ("RGB32");
+    converter = PColourConverter::Create (src_info, dest_info);
+  }
+
+  ~PixopsPath ()
+  { delete converter; }
+
+  bool is_valid () const
+  { return converter != NULL; }
+
+  void step (const char* frame)
+  {
+    converter->Convert ((const BYTE*) frame, (BYTE*) &converted[0]);
+    pixops_scale (&dest[0], 0, 0, dest_width, dest_height,
+                  dest_width * 4, 4, FALSE,
+                  &converted[0], width, height, width * 4, 4, FALSE,
+                  (double) dest_width / width, (double) dest_height / height,
+                  PIXOPS_INTERP_BILINEAR);
+  }
+
+private:
+
+  unsigned width;
+  unsigned height;
+  unsigned dest_width;
+  unsigned dest_height;
+  PColourConverter* converter;
+  std::vector<guchar> converted;
+  std::vector<guchar> dest;
+};
+
+
+/* The fused conversion and scaling, with a given implementation */
+class YuvScalePath: public BenchmarkPath
+{
+public:
+
+  YuvScalePath (PixopsYuvCpu _cpu,
+                unsigned _width,
+                unsigned _height,
+                unsigned _dest_width,
+                unsigned _dest_height)
+    : cpu(_cpu), width(_width), height(_height),
+      dest_width(_dest_width), dest_height(_dest_height),
+      dest(_dest_width * _dest_height * 4)
+  {}
+
+  void step (const char* frame)
+  {
+    pixops_yuv420p_scale_with_cpu (cpu, &dest[0], dest_width, dest_height,
+                                   dest_width * 4, FALSE,
+                                   (const guchar*) frame, width, height,
+                                   PIXOPS_INTERP_BILINEAR);
+  }
+
+private:
+
+  PixopsYuvCpu cpu;
+  unsigned width;
+  unsigned height;
+  unsigned dest_width;
+  unsigned dest_height;
+  std::vector<guchar> dest;
+};
+
+
+#ifdef HAVE_XV
+/* The copy to the XvImage, with or without padded pitches */
+class XvCopyPath: public BenchmarkPath
+{
+public:
+
+  XvCopyPath (unsigned width,
+              unsigned height,
+              bool padded)
+  {
+    int padding = padded ? 64 : 0;
+
+    memset (&image, 0, sizeof (image));
+    image.width = width;
+    image.height = height;
+    image.num_planes = 3;
+    image.pitches = pitches;
+    image.offsets = offsets;
+    pitches[0] = width + padding;
+    pitches[1] = width / 2 + padding / 2;
+    pitches[2] = width / 2 + padding / 2;
+    offsets[0] = 0;
+    offsets[1] = pitches[0] * height;
+    offsets[2] = offsets[1] + pitches[1] * height / 2;
+    image.data_size = offsets[2] + pitches[2] * height / 2;
+    data.resize (image.data_size);
+    image.data = &data[0];
+  }
+
+  void step (const char* frame)
+  {
+    XVWindow::CopyFrame (&image, (const uint8_t*) frame);
+  }
+
+private:
+
+  XvImage image;
+  int pitches[3];
+  int offsets[3];
+  std::vector<char> data;
+};
+#endif
+
+
+/* XWindow or XVWindow, on a real (or virtual) X server */
+class WindowPath: public BenchmarkPath
+{
+public:
+
+  WindowPath (Display* _display,
+              XWindow* _window,
+              unsigned _width,
+              unsigned _height)
+    : display(_display), window(_window), width(_width), height(_height)
+  {}
+
+  void step (const char* frame)
+  {
+    window->PutFrame ((uint8_t*) frame, width, height);
+    window->Sync ();
+    XSync (display, False);
+  }
+
+private:
+
+  Display* display;
+  XWindow* window;
+  unsigned width;
+  unsigned height;
+};
+
+static void
+run_window_path (const std::string & name,
+                 Display* display,
+                 XWindow* window,
+                 const Resolution & resolution,
+                 unsigned copies,
+                 const SyntheticFrames & frames)
+{
+  unsigned dest_width = resolution.width * zoom / 100;
+  unsigned dest_height = resolution.height * zoom / 100;
+  int screen = DefaultScreen (display);
+  Window parent;
+  GC gc;
+
+  parent = XCreateSimpleWindow (display, RootWindow (display, screen),
+                                0, 0, dest_width, dest_height, 0,
+                                BlackPixel (display, screen),
+                                BlackPixel (display, screen));
+  XMapWindow (display, parent);
+  gc = XCreateGC (display, parent, 0, NULL);
+  XSync (display, False);
+
+  if (window->Init (display, parent, gc, 0, 0,
+                    dest_width, dest_height,
+                    resolution.width, resolution.height)) {
+
+    WindowPath path (display, window, resolution.width, resolution.height);
+
+    window->SetSwScalingAlgo (PIXOPS_INTERP_BILINEAR);
+    run_path (name, resolution, copies, path, frames);
+  }
+  else
+    skip_path (name, resolution, "could not initialise the window");
+
+  delete window;
+  XFreeGC (display, gc);
+  XDestroyWindow (display, parent);
+  XSync (display, False);
+}
+
+
+/* A GMVideoOutputManager which displays nowhere, to measure what the
+ * producers pay to hand their frames over */
+class HeadlessVideoOutputManager: public GMVideoOutputManager
+{
+public:
+
+  HeadlessVideoOutputManager (Ekiga::ServiceCore & _core)
+    : GMVideoOutputManager (_core), displayed(0)
+  {
+    Ekiga::DisplayInfo info;
+
+    info.widget_info_set = true;
+    info.config_info_set = true;
+    info.mode = Ekiga::VO_MODE_REMOTE;
+    info.zoom = 100;
+    set_display_info (info);
+
+    end_thread = false;
+    init_thread = false;
+    uninit_thread = false;
+
+    this->Resume ();
+    thread_created.Wait ();
+  }
+
+  void quit ()
+  {
+    end_thread = true;
+    run_thread.Signal ();
+    PWaitAndSignal m(thread_ended);
+  }
+
+  unsigned get_displayed () const
+  { return g_atomic_int_get (&displayed); }
+
+protected:
+
+  void setup_frame_display ()
+  {
+    last_frame.mode = current_frame.mode;
+    last_frame.zoom = current_frame.zoom;
+    last_frame.remote_width = current_frame.remote_width;
+    last_frame.remote_height = current_frame.remote_height;
+  }
+
+  void close_frame_display ()
+  {}
+
+  void display_frame (const char* /*frame*/,
+                      unsigned /*width*/,
+                      unsigned /*height*/)
+  {
+    g_atomic_int_inc (&displayed);
+  }
+
+  void display_pip_frames (const char* /*local_frame*/,
+                           unsigned /*lf_width*/,
+                           unsigned /*lf_height*/,
+                           const char* /*remote_frame*/,
+                           unsigned /*rf_width*/,
+                           unsigned /*rf_height*/)
+  {
+    g_atomic_int_inc (&displayed);
+  }
+
+  void sync (UpdateRequired /*sync_required*/)
+  {}
+
+private:
+
+  mutable volatile gint displayed;
+};
+
+class SetFrameDataPath: public BenchmarkPath
+{
+public:
+
+  SetFrameDataPath (GMVideoOutputManager & _manager,
+                    unsigned _width,
+                    unsigned _height)
+    : manager(_manager), width(_width), height(_height)
+  {}
+
+  void step (const char* frame)
+  {
+    manager.set_frame_data (frame, width, height, 1, 1);
+  }
+
+private:
+
+  GMVideoOutputManager & manager;
+  unsigned width;
+  unsigned height;
+};
+
+class SetFramePath: public BenchmarkPath
+{
+public:
+
+  SetFramePath (GMVideoOutputManager & _manager,
+                const SyntheticFrames & frames)
+    : manager(_manager), pool(new Ekiga::VideoFramePool), next(0)
+  {
+    for (unsigned i = 0 ; i < NB_FRAMES ; i++)
+      pooled.push_back (pool->acquire_copy (frames.get (i),
+                                            frames.width, frames.height));
+  }
+
+  void step (const char* /*frame*/)
+  {
+    manager.set_frame (pooled[next++ % NB_FRAMES], 1, 1);
+  }
+
+private:
+
+  GMVideoOutputManager & manager;
+  Ekiga::VideoFramePoolPtr pool;
+  std::vector<Ekiga::VideoFramePtr> pooled;
+  unsigned next;
+};
+
+static void
+run_manager_paths (Ekiga::ServiceCore & core,
+                   const Resolution & resolution,
+                   const SyntheticFrames & frames)
+{
+  /* the manager deletes itself when its thread ends */
+  HeadlessVideoOutputManager* manager = new HeadlessVideoOutputManager (core);
+
+  manager->open ();
+
+  SetFrameDataPath data_path (*manager, resolution.width, resolution.height);
+  run_path ("set_frame_data", resolution, 1, data_path, frames);
+
+  SetFramePath frame_path (*manager, frames);
+  run_path ("set_frame", resolution, 0, frame_path, frames);
+
+  /* let the thread catch up before counting */
+  PThread::Sleep (300);
+  printf ("%-30s %-6s displayed %u, dropped %u\n", "", resolution.name,
+          manager->get_displayed (), manager->get_dropped_frames (1));
+
+  manager->close ();
+  manager->quit ();
+}
+
+
+class VideoBenchmark: public PProcess
+{
+  PCLASSINFO(VideoBenchmark, PProcess);
+
+public:
+
+  VideoBenchmark (): PProcess ("Ekiga", "ekiga-video-benchmark")
+  {}
+
+  void Main ()
+  {}
+};
+
+
+int
+main (int argc,
+      char *argv [])
+{
+  GOptionContext* context = NULL;
+  GError* error = NULL;
+  Display* display = NULL;
+  PixopsYuvCpu cpu;
+
+  GOptionEntry arguments [] =
+    {
+      { "zoom", 'z', 0, G_OPTION_ARG_INT, &zoom,
+        "Zoom of the displayed frames, in percent (default: 200)", NULL },
+      { "duration", 'd', 0, G_OPTION_ARG_DOUBLE, &duration,
+        "Minimum duration of each measure, in seconds (default: 1)", NULL },
+      { "no-display", 'n', 0, G_OPTION_ARG_NONE, &no_display,
+        "Don't measure the paths which need an X server", NULL },
+      { NULL, 0, 0, G_OPTION_ARG_NONE, NULL, NULL, NULL }
+    };
+
+  if (!XInitThreads ())
+    exit (1);
+
+#if !GLIB_CHECK_VERSION(2,36,0)
+  g_type_init ();
+#endif
+#if !GLIB_CHECK_VERSION(2,32,0)
+  g_thread_init (NULL);
+#endif
+
+  context = g_option_context_new (NULL);
+  g_option_context_add_main_entries (context, arguments, NULL);
+  if (!g_option_context_parse (context, &argc, &argv, &error)) {
+
+    fprintf (stderr, "%s\n", error->message);
+    g_error_free (error);
+    return 1;
+  }
+  g_option_context_free (context);
+
+  if (zoom <= 0)
+    zoom = 100;
+
+  VideoBenchmark instance;
+  Ekiga::ServiceCore core;
+
+  Ekiga::Runtime::init ();
+
+  if (!no_display) {
+
+    display = XOpenDisplay (NULL);
+    if (!display)
+      fprintf (stderr, "Cannot open the X display, the window paths will be skipped\n");
+  }
+
+  cpu = pixops_yuv420p_scale_get_cpu ();
+
+  printf ("%-30s %-6s %12s %7s %10s %10s\n",
+          "path", "size", "ns/frame", "copies", "MB/s", "frames/s");
+
+  for (unsigned i = 0 ; i < G_N_ELEMENTS (resolutions) ; i++) {
+
+    const Resolution & resolution = resolutions[i];
+    unsigned dest_width = resolution.width * zoom / 100;
+    unsigned dest_height = resolution.height * zoom / 100;
+    SyntheticFrames frames (resolution.width, resolution.height);
+
+    {
+      PixopsPath path (resolution.width, resolution.height,
+                       dest_width, dest_height);
+
+      if (path.is_valid ())
+        run_path ("convert+pixops_scale", resolution, 2, path, frames);
+      else
+        skip_path ("convert+pixops_scale", resolution, "no colour converter");
+    }
+
+    {
+      YuvScalePath path (PIXOPS_YUV_CPU_C, resolution.width, resolution.height,
+                         dest_width, dest_height);
+      run_path ("yuv420p_scale/c", resolution, 1, path, frames);
+    }
+    if (cpu >= PIXOPS_YUV_CPU_SSE2) {
+
+      YuvScalePath path (PIXOPS_YUV_CPU_SSE2, resolution.width, resolution.height,
+                         dest_width, dest_height);
+      run_path ("yuv420p_scale/sse2", resolution, 1, path, frames);
+    }
+    if (cpu >= PIXOPS_YUV_CPU_AVX2) {
+
+      YuvScalePath path (PIXOPS_YUV_CPU_AVX2, resolution.width, resolution.height,
+                         dest_width, dest_height);
+      run_path ("yuv420p_scale/avx2", resolution, 1, path, frames);
+    }
+
+#ifdef HAVE_XV
+    {
+      XvCopyPath path (resolution.width, resolution.height, false);
+      run_path ("XVWindow::CopyFrame", resolution, 1, path, frames);
+    }
+    {
+      XvCopyPath path (resolution.width, resolution.height, true);
+      run_path ("XVWindow::CopyFrame/padded", resolution, 1, path, frames);
+    }
+#endif
+
+    if (display) {
+
+      /* the fused path is used on 24 and 32 bits visuals ; it leaves one
+       * copy, not counting the transfer to the X server */
+      unsigned copies = (DefaultDepth (display, DefaultScreen (display)) >= 24) ? 1 : 2;
+
+      run_window_path ("XWindow::PutFrame", display, new XWindow (),
+                       resolution, copies, frames);
+#ifdef HAVE_XV
+      run_window_path ("XVWindow::PutFrame", display, new XVWindow (),
+                       resolution, 1, frames);
+#endif
+    }
+
+    run_manager_paths (core, resolution, frames);
+  }
+
+  if (display)
+    XCloseDisplay (display);
+
+  Ekiga::Runtime::quit ();
+
+  return 0;
+}
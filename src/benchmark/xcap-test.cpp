@@ -0,0 +1,566 @@
+
+/* Ekiga -- A VoIP and Video-Conferencing application
+ * Copyright (C) 2000-2009 Damien Sandras <dsandras@seconix.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ *
+ * Ekiga is licensed under the GPL license and as a special exception,
+ * you have permission to link or otherwise combine this program with the
+ * programs OPAL, OpenH323 and PWLIB, and distribute the combination,
+ * without applying the requirements of the GNU GPL to the OPAL, OpenH323
+ * and PWLIB programs, as long as you do follow the requirements of the
+ * GNU GPL for all the rest of the software thus combined.
+ */
+
+
+
+/*
+ *                         xcap-test.cpp  -  description
+ *                         ------------------------------------------
+ *   begin                : written in 2012
+ *   copyright            : (C) 2012 by Damien Sandras
+ *   description          : Checks the XCAP core against a stand-in
+ *                          server on a local port.
+ *
+ */
+
+/* The stand-in is a SOUP server asking for basic authentication, which
+ * keeps documents by path (up to the "/~~" of the node selector), gives
+ * them an entity tag, and answers a GET with a matching If-None-Match with
+ * a 304. It counts what it did, so the checks are on what the core asked
+ * for as much as on what the callbacks got. The program exits with 1 if a
+ * check failed.
+ */
+
+#include <string>
+#include <map>
+#include <stdio.h>
+#include <string.h>
+
+#include <boost/bind.hpp>
+#include <libsoup/soup.h>
+
+#include "xcap-core.h"
+#include "xcap-path.h"
+
+#include "bench-check.h"
+
+#define APPLICATION "resource-lists"
+
+/* how long a request may take before the check gives up on it */
+static int timeout = 10;
+
+struct StandIn
+{
+  struct Document
+  {
+    std::string etag;
+    std::string content;
+  };
+
+  SoupServer* server;
+  std::map<std::string, Document> documents;
+  unsigned version;
+
+  std::map<std::string, std::string> passwords;
+  std::map<std::string, unsigned> attempts;
+  boost::function0<void> on_attempt;
+  std::string last_user;
+
+  unsigned full_answers;
+  unsigned not_modified_answers;
+
+  /* the next 304 is held until the check sends it with release */
+  bool hold_not_modified;
+  bool holding;
+  SoupMessage* held;
+};
+
+static StandIn stand_in;
+
+struct Result
+{
+  bool done;
+  bool error;
+  std::string value;
+};
+
+/* the stand-in server */
+
+static std::string
+document_path (const std::string path)
+{
+  return path.substr (0, path.find ("/~~"));
+}
+
+static gboolean
+check_password (G_GNUC_UNUSED SoupAuthDomain* domain,
+		G_GNUC_UNUSED SoupMessage* message,
+		const char* username,
+		const char* password,
+		G_GNUC_UNUSED gpointer data)
+{
+  std::map<std::string, std::string>::const_iterator iter
+    = stand_in.passwords.find (username);
+
+  stand_in.attempts[username]++;
+  if (stand_in.on_attempt)
+    stand_in.on_attempt ();
+
+  return iter != stand_in.passwords.end () && iter->second == password;
+}
+
+static void
+set_document (const std::string path,
+	      const std::string content)
+{
+  char etag[32];
+
+  snprintf (etag, sizeof (etag), "\"%u\"", ++stand_in.version);
+  stand_in.documents[path].etag = etag;
+  stand_in.documents[path].content = content;
+}
+
+static void
+handle_request (SoupServer* server,
+		SoupMessage* message,
+		const char* path,
+		G_GNUC_UNUSED GHashTable* query,
+		SoupClientContext* client,
+		G_GNUC_UNUSED gpointer data)
+{
+  const std::string document = document_path (path);
+  std::map<std::string, StandIn::Document>::iterator iter
+    = stand_in.documents.find (document);
+  const char* user = soup_client_context_get_auth_user (client);
+
+  stand_in.last_user = (user != NULL) ? user : "";
+
+  if (message->method == SOUP_METHOD_GET) {
+
+    const char* etag = NULL;
+
+    if (iter == stand_in.documents.end ()) {
+
+      soup_message_set_status (message, SOUP_STATUS_NOT_FOUND);
+      return;
+    }
+
+    etag = soup_message_headers_get_one (message->request_headers,
+					 "If-None-Match");
+    if (etag != NULL && iter->second.etag == etag) {
+
+      stand_in.not_modified_answers++;
+      soup_message_set_status (message, SOUP_STATUS_NOT_MODIFIED);
+      if (stand_in.hold_not_modified) {
+
+	stand_in.hold_not_modified = false;
+	stand_in.holding = true;
+	stand_in.held = message;
+	soup_server_pause_message (server, message);
+      }
+      return;
+    }
+
+    stand_in.full_answers++;
+    soup_message_headers_replace (message->response_headers,
+				  "ETag", iter->second.etag.c_str ());
+    soup_message_set_response (message, "application/resource-lists+xml",
+			       SOUP_MEMORY_COPY,
+			       iter->second.content.c_str (),
+			       iter->second.content.length ());
+    soup_message_set_status (message, SOUP_STATUS_OK);
+  } else if (message->method == SOUP_METHOD_PUT) {
+
+    set_document (document, std::string (message->request_body->data,
+					 message->request_body->length));
+    soup_message_set_status (message, SOUP_STATUS_OK);
+  } else if (message->method == SOUP_METHOD_DELETE) {
+
+    if (iter != stand_in.documents.end ()) {
+
+      stand_in.documents.erase (iter);
+      soup_message_set_status (message, SOUP_STATUS_OK);
+    } else {
+
+      soup_message_set_status (message, SOUP_STATUS_NOT_FOUND);
+    }
+  } else {
+
+    soup_message_set_status (message, SOUP_STATUS_NOT_IMPLEMENTED);
+  }
+}
+
+/* returns the root of the XCAP server, or an empty string */
+static std::string
+start_stand_in ()
+{
+  SoupAddress* address = NULL;
+  SoupAuthDomain* domain = NULL;
+  char root[64];
+
+  address = soup_address_new ("127.0.0.1", SOUP_ADDRESS_ANY_PORT);
+  if (soup_address_resolve_sync (address, NULL) != SOUP_STATUS_OK) {
+
+    g_object_unref (address);
+    return "";
+  }
+
+  stand_in.server = soup_server_new (SOUP_SERVER_INTERFACE, address, NULL);
+  g_object_unref (address);
+  if (stand_in.server == NULL)
+    return "";
+
+  domain = soup_auth_domain_basic_new (SOUP_AUTH_DOMAIN_REALM, "ekiga",
+				       SOUP_AUTH_DOMAIN_BASIC_AUTH_CALLBACK,
+				       check_password,
+				       SOUP_AUTH_DOMAIN_ADD_PATH, "/",
+				       NULL);
+  soup_server_add_auth_domain (stand_in.server, domain);
+  g_object_unref (domain);
+
+  soup_server_add_handler (stand_in.server, NULL, handle_request, NULL, NULL);
+  soup_server_run_async (stand_in.server);
+
+  stand_in.passwords["alice"] = "alice-secret";
+  stand_in.passwords["bob"] = "bob-secret";
+  stand_in.passwords["carol"] = "carol-secret";
+  stand_in.passwords["dave"] = "dave-secret";
+
+  snprintf (root, sizeof (root), "http://127.0.0.1:%u/xcap",
+	    soup_server_get_port (stand_in.server));
+
+  return root;
+}
+
+static void
+release_held ()
+{
+  soup_server_unpause_message (stand_in.server, stand_in.held);
+  stand_in.holding = false;
+  stand_in.held = NULL;
+}
+
+/* the client side */
+
+static gboolean
+on_timeout (gpointer data)
+{
+  *(bool*)data = true;
+
+  return FALSE;
+}
+
+/* runs the main loop until the flag is set, or for the timeout at most */
+static bool
+wait_for (const bool& flag)
+{
+  bool timed_out = false;
+  guint id = g_timeout_add_seconds (timeout, on_timeout, &timed_out);
+
+  while (!flag && !timed_out)
+    g_main_context_iteration (NULL, TRUE);
+
+  if (!timed_out)
+    g_source_remove (id);
+
+  return flag;
+}
+
+static void
+on_read (boost::shared_ptr<Result> result,
+	 bool error,
+	 std::string value)
+{
+  result->done = true;
+  result->error = error;
+  result->value = value;
+}
+
+static void
+on_other (boost::shared_ptr<Result> result,
+	  std::string error)
+{
+  result->done = true;
+  result->error = !error.empty ();
+  result->value = error;
+}
+
+/* the results are shared with the callbacks, which may still come after a
+ * check timed out */
+static boost::shared_ptr<Result>
+start_read (XCAP::Core& core,
+	    boost::shared_ptr<XCAP::Path> path)
+{
+  boost::shared_ptr<Result> result (new Result ());
+
+  core.read (path, boost::bind (on_read, result, _1, _2));
+
+  return result;
+}
+
+static boost::shared_ptr<Result>
+read_document (XCAP::Core& core,
+	       boost::shared_ptr<XCAP::Path> path)
+{
+  boost::shared_ptr<Result> result = start_read (core, path);
+
+  wait_for (result->done);
+
+  return result;
+}
+
+static boost::shared_ptr<Result>
+write_document (XCAP::Core& core,
+		boost::shared_ptr<XCAP::Path> path,
+		const std::string content)
+{
+  boost::shared_ptr<Result> result (new Result ());
+
+  core.write (path, "application/resource-lists+xml", content,
+	      boost::bind (on_other, result, _1));
+  wait_for (result->done);
+
+  return result;
+}
+
+static boost::shared_ptr<XCAP::Path>
+build_path (const std::string root,
+	    const std::string user,
+	    const std::string username,
+	    const std::string password)
+{
+  boost::shared_ptr<XCAP::Path> path (new XCAP::Path (root, APPLICATION, user));
+
+  path->set_credentials (username, password);
+
+  return path;
+}
+
+/* the path of the document on the server */
+static std::string
+server_path (boost::shared_ptr<XCAP::Path> path)
+{
+  const std::string uri = path->to_uri ();
+
+  return document_path (uri.substr (uri.find ('/', strlen ("http://"))));
+}
+
+static void
+set_credentials (boost::shared_ptr<XCAP::Path> path,
+		 const std::string username,
+		 const std::string password)
+{
+  path->set_credentials (username, password);
+}
+
+/* the checks */
+
+static void
+test_cache (XCAP::Core& core,
+	    const std::string root)
+{
+  boost::shared_ptr<XCAP::Path> path
+    = build_path (root, "alice", "alice", "alice-secret");
+  boost::shared_ptr<Result> result;
+  unsigned full_answers = 0;
+
+  set_document (server_path (path), "<list name=\"one\"/>");
+
+  full_answers = stand_in.full_answers;
+  result = read_document (core, path);
+  check (result->done && !result->error
+	 && result->value == "<list name=\"one\"/>",
+	 "a document is read");
+  check (stand_in.full_answers == full_answers + 1,
+	 "the server sent a document read the first time");
+
+  result = read_document (core, path);
+  check (result->done && !result->error
+	 && result->value == "<list name=\"one\"/>",
+	 "a document read again is the same");
+  check (stand_in.full_answers == full_answers + 1
+	 && stand_in.not_modified_answers == 1,
+	 "the server only said a document read again didn't change");
+}
+
+static void
+test_write (XCAP::Core& core,
+	    const std::string root)
+{
+  boost::shared_ptr<XCAP::Path> path
+    = build_path (root, "alice", "alice", "alice-secret");
+  boost::shared_ptr<Result> result;
+  unsigned full_answers = stand_in.full_answers;
+
+  result = write_document (core, path, "<list name=\"two\"/>");
+  check (result->done && !result->error, "a document is written");
+
+  result = read_document (core, path);
+  check (result->done && !result->error
+	 && result->value == "<list name=\"two\"/>",
+	 "a document read after a write is the new one");
+  check (stand_in.full_answers == full_answers + 1,
+	 "the server sent a document read after a write");
+}
+
+static void
+test_not_modified_after_write (XCAP::Core& core,
+			       const std::string root)
+{
+  boost::shared_ptr<XCAP::Path> path
+    = build_path (root, "alice", "alice", "alice-secret");
+  boost::shared_ptr<Result> pending;
+  boost::shared_ptr<Result> result;
+
+  result = read_document (core, path);
+  check (result->done && result->value == "<list name=\"two\"/>",
+	 "the document is cached before the write");
+
+  /* the server says the document didn't change, but the answer only
+   * comes once a write on it is done */
+  stand_in.hold_not_modified = true;
+  pending = start_read (core, path);
+  wait_for (stand_in.holding);
+  check (stand_in.holding, "the read waits for the server");
+  if (!stand_in.holding)
+    return;
+
+  result = write_document (core, path, "<list name=\"three\"/>");
+  check (result->done && !result->error, "a document is written during a read");
+
+  release_held ();
+  wait_for (pending->done);
+  check (pending->done && !pending->error
+	 && pending->value == "<list name=\"two\"/>",
+	 "a read answered 304 after a write gets the document it asked about");
+
+  result = read_document (core, path);
+  check (result->done && !result->error
+	 && result->value == "<list name=\"three\"/>",
+	 "the next read gets the written document");
+}
+
+static void
+test_accounts (XCAP::Core& core,
+	       const std::string root)
+{
+  boost::shared_ptr<XCAP::Path> alice
+    = build_path (root, "", "alice", "alice-secret");
+  boost::shared_ptr<XCAP::Path> bob
+    = build_path (root, "", "bob", "bob-secret");
+  boost::shared_ptr<Result> result;
+
+  set_document (server_path (alice), "<list name=\"global\"/>");
+
+  result = read_document (core, alice);
+  check (result->done && !result->error && stand_in.last_user == "alice",
+	 "a global document is read as the first account");
+
+  result = read_document (core, bob);
+  check (result->done && !result->error && stand_in.last_user == "bob",
+	 "the same global document is read as the second account");
+
+  result = read_document (core, alice);
+  check (result->done && !result->error && stand_in.last_user == "alice",
+	 "the first account reads with its own credentials again");
+}
+
+static void
+test_password_fixed (XCAP::Core& core,
+		     const std::string root)
+{
+  boost::shared_ptr<XCAP::Path> path
+    = build_path (root, "carol", "carol", "wrong");
+  boost::shared_ptr<Result> result;
+
+  set_document (server_path (path), "<list name=\"carol\"/>");
+
+  /* the user fixes the password as the server refuses the wrong one */
+  stand_in.on_attempt = boost::bind (set_credentials, path,
+				     "carol", "carol-secret");
+  result = read_document (core, path);
+  stand_in.on_attempt.clear ();
+
+  check (result->done && !result->error
+	 && result->value == "<list name=\"carol\"/>",
+	 "a read succeeds once its password is fixed");
+  check (stand_in.attempts["carol"] == 2,
+	 "a read is retried once with the fixed password");
+}
+
+static void
+test_wrong_password (XCAP::Core& core,
+		     const std::string root)
+{
+  boost::shared_ptr<XCAP::Path> path
+    = build_path (root, "dave", "dave", "wrong");
+  boost::shared_ptr<Result> result;
+
+  set_document (server_path (path), "<list name=\"dave\"/>");
+
+  result = read_document (core, path);
+  check (result->done && result->error,
+	 "a read with a wrong password fails");
+  check (stand_in.attempts["dave"] == 1,
+	 "a read with a wrong password isn't retried with it");
+}
+
+int
+main (int argc,
+      char *argv [])
+{
+  XCAP::Core* core = NULL;
+  std::string root;
+
+  GOptionEntry arguments [] =
+    {
+      { "timeout", 't', 0, G_OPTION_ARG_INT, &timeout,
+        "Seconds a request may take (default: 10)", NULL },
+      { NULL, 0, 0, G_OPTION_ARG_NONE, NULL, NULL, NULL }
+    };
+
+#if !GLIB_CHECK_VERSION(2,36,0)
+  g_type_init ();
+#endif
+
+  if (!bench_parse_options (&argc, &argv, arguments))
+    return 1;
+
+  if (timeout <= 0)
+    timeout = 1;
+
+  root = start_stand_in ();
+  if (root.empty ()) {
+
+    printf ("The stand-in server couldn't listen on a local port\n");
+    return 1;
+  }
+
+  core = new XCAP::Core ();
+
+  test_cache (*core, root);
+  test_write (*core, root);
+  test_not_modified_after_write (*core, root);
+  test_accounts (*core, root);
+  test_password_fixed (*core, root);
+  test_wrong_password (*core, root);
+
+  delete core;
+  g_object_unref (stand_in.server);
+
+  return bench_result ();
+}